@@ -18,6 +18,7 @@
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "dma.h"
 #include "tim.h"
 #include "usart.h"
 #include "gpio.h"
@@ -28,6 +29,9 @@
 #include "menu.h"
 #include "mg513.h"
 #include "encoder.h"
+#include "telemetry.h"
+#include "profiler.h"
+#include "knob.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -48,7 +52,7 @@
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
-int16_t encoder_num;
+
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -65,14 +69,10 @@ int _write(int file, char *ptr, int len) {
 }
 //编码
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
-    if (GPIO_Pin == Encoder_A_Pin) {
-        if (HAL_GPIO_ReadPin(Encoder_B_GPIO_Port, Encoder_B_Pin) == GPIO_PIN_RESET) {
-            encoder_num++;
-        }
-    } else if (GPIO_Pin == Encoder_B_Pin) {
-        if (HAL_GPIO_ReadPin(Encoder_A_GPIO_Port, Encoder_A_Pin) == GPIO_PIN_RESET) {
-            encoder_num--;
-        }
+    if (GPIO_Pin == Encoder_A_Pin || GPIO_Pin == Encoder_B_Pin) {
+        knob_Edge();                        //旋钮AB相任一边沿
+    } else {
+        mg513_EncoderEdge(GPIO_Pin);        //电机编码器A相边沿
     }
 }
 
@@ -106,12 +106,15 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART3_UART_Init();
   MX_TIM2_Init();
   MX_TIM3_Init();
   MX_TIM4_Init();
   MX_TIM1_Init();
   /* USER CODE BEGIN 2 */
+    telemetry_Init();
+    profiler_Init();
     Menu_Init();
     mg513_EncoderInit();
     /* USER CODE END 2 */
@@ -120,6 +123,7 @@ int main(void)
   /* USER CODE BEGIN WHILE */
     while (1) {
         Menu();
+        mg513_Service();
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
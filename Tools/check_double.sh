@@ -0,0 +1,31 @@
+#!/bin/sh
+# 检查控制路径目标文件是否引用了双精度软浮点库函数
+# 用法：Tools/check_double.sh [目标文件...]
+# 不带参数时检查 STM32CubeIDE 默认输出目录 Debug/User/Src 下的控制相关目标文件
+# 发现 __aeabi_d* / __*df* 引用时返回非0
+
+NM=${NM:-arm-none-eabi-nm}
+
+if [ $# -eq 0 ]; then
+    set -- Debug/User/Src/encoder.o Debug/User/Src/pid.o Debug/User/Src/filter.o \
+           Debug/User/Src/mg513.o Debug/User/Src/telemetry.o Debug/User/Src/profiler.o \
+           Debug/User/Src/planner.o Debug/User/Src/motion.o Debug/User/Src/bench.o
+fi
+
+status=0
+for obj in "$@"; do
+    if [ ! -f "$obj" ]; then
+        echo "missing: $obj" >&2
+        status=2
+        continue
+    fi
+    syms=$("$NM" -u "$obj" | awk '{print $NF}' | grep -E '^__aeabi_(d|[a-z0-9]*2d$)|^__[a-z]+df[0-9]|^(exp|log|pow|sqrt|atan2|round)$')
+    if [ -n "$syms" ]; then
+        echo "$obj:"
+        echo "$syms" | sed 's/^/    /'
+        status=1
+    fi
+done
+
+[ $status -eq 0 ] && echo "no double-precision helpers referenced"
+exit $status
@@ -0,0 +1,9 @@
+//仿真用HAL桩：替代Core/Inc/gpio.h
+#ifndef __GPIO_H__
+#define __GPIO_H__
+
+#include "main.h"
+
+void MX_GPIO_Init(void);
+
+#endif //__GPIO_H__
@@ -0,0 +1,140 @@
+//仿真用HAL桩：替代Core/Inc/main.h，只提供User/Src用到的外设寄存器、宏和函数
+//寄存器用普通内存模拟，由sim_hal.c和电机模型读写
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __weak  __attribute__((weak))
+
+typedef enum { HAL_OK = 0, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+
+//------内核------//
+typedef struct { volatile uint32_t CTRL, CYCCNT; } DWT_Type;
+typedef struct { volatile uint32_t DEMCR; } CoreDebug_Type;
+extern DWT_Type sim_dwt;
+extern CoreDebug_Type sim_coredebug;
+#define DWT                         (&sim_dwt)
+#define CoreDebug                   (&sim_coredebug)
+#define DWT_CTRL_CYCCNTENA_Msk      0x1u
+#define CoreDebug_DEMCR_TRCENA_Msk  (1u << 24)
+
+extern uint32_t SystemCoreClock;
+extern uint32_t sim_primask;
+#define __disable_irq()             (sim_primask = 1)
+#define __enable_irq()              (sim_primask = 0)
+#define __get_PRIMASK()             (sim_primask)
+#define __set_PRIMASK(x)            (sim_primask = (x))
+#define __NOP()                     ((void) 0)
+#define __WFI()                     ((void) 0)
+
+//------RCC------//
+typedef struct { volatile uint32_t CFGR; } RCC_TypeDef;
+extern RCC_TypeDef sim_rcc;
+#define RCC                         (&sim_rcc)
+#define RCC_CFGR_PPRE1              0x00000700u
+#define RCC_CFGR_PPRE1_DIV1         0x00000000u
+#define RCC_CFGR_PPRE1_DIV2         0x00000400u
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+//------GPIO------//
+typedef struct { volatile uint32_t ODR, IDR, BSRR; } GPIO_TypeDef;
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+extern GPIO_TypeDef sim_gpioa, sim_gpiob;
+#define GPIOA                       (&sim_gpioa)
+#define GPIOB                       (&sim_gpiob)
+#define GPIO_PIN_0                  ((uint16_t) 0x0001)
+#define GPIO_PIN_3                  ((uint16_t) 0x0008)
+#define GPIO_PIN_5                  ((uint16_t) 0x0020)
+#define GPIO_PIN_6                  ((uint16_t) 0x0040)
+#define GPIO_PIN_8                  ((uint16_t) 0x0100)
+#define GPIO_PIN_9                  ((uint16_t) 0x0200)
+#define GPIO_PIN_13                 ((uint16_t) 0x2000)
+#define GPIO_PIN_15                 ((uint16_t) 0x8000)
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin);
+
+//与Core/Inc/main.h相同的引脚定义
+#define BIN1_Pin ((uint16_t) 0x0004)
+#define BIN1_GPIO_Port GPIOA
+#define AIN1_Pin ((uint16_t) 0x0008)
+#define AIN1_GPIO_Port GPIOA
+#define BIN2_Pin ((uint16_t) 0x0010)
+#define BIN2_GPIO_Port GPIOA
+#define AIN2_Pin ((uint16_t) 0x0020)
+#define AIN2_GPIO_Port GPIOA
+#define Encoder_A_Pin GPIO_PIN_13
+#define Encoder_A_GPIO_Port GPIOB
+#define Encoder_B_Pin GPIO_PIN_15
+#define Encoder_B_GPIO_Port GPIOB
+#define Key_ON_Pin GPIO_PIN_3
+#define Key_ON_GPIO_Port GPIOB
+#define Key_OK_Pin GPIO_PIN_5
+#define Key_OK_GPIO_Port GPIOB
+#define OLED_SCL_Pin GPIO_PIN_8
+#define OLED_SCL_GPIO_Port GPIOB
+#define OLED_SDA_Pin GPIO_PIN_9
+#define OLED_SDA_GPIO_Port GPIOB
+
+//OLED BSRR软件I2C：写入经sim_GpioBsrr解析引脚波形
+void sim_GpioBsrr(GPIO_TypeDef* port, uint32_t value);
+#define OLED_BSRR_WRITE(Value)      sim_GpioBsrr(OLED_SCL_GPIO_Port, (Value))
+
+//------TIM------//
+typedef struct {
+    volatile uint32_t CR1, DIER, SR, CCER, CNT, PSC, ARR;
+    volatile uint32_t CCR1, CCR2, CCR3, CCR4;
+} TIM_TypeDef;
+typedef struct { uint32_t Prescaler, Period; } TIM_Base_InitTypeDef;
+typedef struct { TIM_TypeDef* Instance; TIM_Base_InitTypeDef Init; } TIM_HandleTypeDef;
+
+#define TIM_CR1_CEN                 0x0001u
+#define TIM_CR1_DIR                 0x0010u
+#define TIM_IT_UPDATE               0x0001u
+#define TIM_FLAG_UPDATE             0x0001u
+#define TIM_CHANNEL_1               0x0000u
+#define TIM_CHANNEL_2               0x0004u
+#define TIM_CHANNEL_3               0x0008u
+#define TIM_CHANNEL_4               0x000Cu
+
+//读CNT、SR之前调用sim_tim_hook（非NULL时），测试用它在两次寄存器访问之间改变计数、插入中断
+extern void (*sim_tim_hook)(TIM_TypeDef* tim);
+static inline TIM_TypeDef* sim_TimAccess(TIM_TypeDef* tim) {
+    if (sim_tim_hook)
+        sim_tim_hook(tim);
+    return tim;
+}
+
+#define __HAL_TIM_GET_COUNTER(h)            (sim_TimAccess((h)->Instance)->CNT)
+#define __HAL_TIM_SET_COUNTER(h, v)         ((h)->Instance->CNT = (v))
+#define __HAL_TIM_SetCounter                __HAL_TIM_SET_COUNTER
+#define __HAL_TIM_SET_COMPARE(h, ch, v)     (*(&(h)->Instance->CCR1 + ((ch) >> 2)) = (uint32_t) (v))
+#define __HAL_TIM_GET_FLAG(h, f)            ((sim_TimAccess((h)->Instance)->SR & (f)) == (f))
+#define __HAL_TIM_CLEAR_IT(h, it)           ((h)->Instance->SR &= ~(uint32_t) (it))
+#define __HAL_TIM_ENABLE_IT(h, it)          ((h)->Instance->DIER |= (it))
+#define __HAL_TIM_DISABLE_IT(h, it)         ((h)->Instance->DIER &= ~(uint32_t) (it))
+#define __HAL_TIM_IS_TIM_COUNTING_DOWN(h)   (((h)->Instance->CR1 & TIM_CR1_DIR) == TIM_CR1_DIR)
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef* htim, uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef* htim, uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef* htim, uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_Encoder_Stop(TIM_HandleTypeDef* htim, uint32_t channel);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim);
+
+//------UART------//
+#define HAL_UART_ERROR_NONE     0x00000000U
+#define HAL_UART_ERROR_DMA      0x00000010U
+typedef struct { uint32_t id; volatile uint32_t ErrorCode; } UART_HandleTypeDef;
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart);
+
+//------SysTick------//
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t ms);
+
+#endif //__MAIN_H
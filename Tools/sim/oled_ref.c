@@ -0,0 +1,341 @@
+//OLED图形绘制的参考实现：改为按列填充之前的逐点绘制算法，供mg513_sim --shapes比较
+//圆弧由atan2判断角度，三角形由pnpoly逐点判断，均直接写入OLED_DisplayBuf
+//除函数名前缀和画点不标记脏区外与原OLED.c相同，不要修改；OLED.c中的实现必须与之逐像素一致
+
+#include <math.h>
+#include "sim.h"
+#include "OLED.h"
+
+extern uint8_t OLED_DisplayBuf[8][128];
+
+static void ref_DrawPoint(int16_t X, int16_t Y)
+{
+	if (X >= 0 && X <= 127 && Y >=0 && Y <= 63)
+	{
+		OLED_DisplayBuf[Y / 8][X] |= 0x01 << (Y % 8);
+	}
+}
+
+static uint8_t ref_pnpoly(uint8_t nvert, int16_t *vertx, int16_t *verty, int16_t testx, int16_t testy)
+{
+	int16_t i, j, c = 0;
+	
+	/*此算法由W. Randolph Franklin提出*/
+	/*参考链接：https://wrfranklin.org/Research/Short_Notes/pnpoly.html*/
+	for (i = 0, j = nvert - 1; i < nvert; j = i++)
+	{
+		if (((verty[i] > testy) != (verty[j] > testy)) &&
+			(testx < (vertx[j] - vertx[i]) * (testy - verty[i]) / (verty[j] - verty[i]) + vertx[i]))
+		{
+			c = !c;
+		}
+	}
+	return c;
+}
+
+static uint8_t ref_IsInAngle(int16_t X, int16_t Y, int16_t StartAngle, int16_t EndAngle)
+{
+	int16_t PointAngle;
+	PointAngle = atan2(Y, X) / 3.14 * 180;	//计算指定点的弧度，并转换为角度表示
+	if (StartAngle < EndAngle)	//起始角度小于终止角度的情况
+	{
+		/*如果指定角度在起始终止角度之间，则判定指定点在指定角度*/
+		if (PointAngle >= StartAngle && PointAngle <= EndAngle)
+		{
+			return 1;
+		}
+	}
+	else			//起始角度大于于终止角度的情况
+	{
+		/*如果指定角度大于起始角度或者小于终止角度，则判定指定点在指定角度*/
+		if (PointAngle >= StartAngle || PointAngle <= EndAngle)
+		{
+			return 1;
+		}
+	}
+	return 0;		//不满足以上条件，则判断判定指定点不在指定角度
+}
+
+void ref_DrawTriangle(int16_t X0, int16_t Y0, int16_t X1, int16_t Y1, int16_t X2, int16_t Y2, uint8_t IsFilled)
+{
+	int16_t minx = X0, miny = Y0, maxx = X0, maxy = Y0;
+	int16_t i, j;
+	int16_t vx[] = {X0, X1, X2};
+	int16_t vy[] = {Y0, Y1, Y2};
+	
+	if (!IsFilled)			//指定三角形不填充
+	{
+		/*调用画线函数，将三个点用直线连接*/
+		OLED_DrawLine(X0, Y0, X1, Y1);
+		OLED_DrawLine(X0, Y0, X2, Y2);
+		OLED_DrawLine(X1, Y1, X2, Y2);
+	}
+	else					//指定三角形填充
+	{
+		/*找到三个点最小的X、Y坐标*/
+		if (X1 < minx) {minx = X1;}
+		if (X2 < minx) {minx = X2;}
+		if (Y1 < miny) {miny = Y1;}
+		if (Y2 < miny) {miny = Y2;}
+		
+		/*找到三个点最大的X、Y坐标*/
+		if (X1 > maxx) {maxx = X1;}
+		if (X2 > maxx) {maxx = X2;}
+		if (Y1 > maxy) {maxy = Y1;}
+		if (Y2 > maxy) {maxy = Y2;}
+		
+		/*最小最大坐标之间的矩形为可能需要填充的区域*/
+		/*遍历此区域中所有的点*/
+		/*遍历X坐标*/		
+		for (i = minx; i <= maxx; i ++)
+		{
+			/*遍历Y坐标*/	
+			for (j = miny; j <= maxy; j ++)
+			{
+				/*调用OLED_pnpoly，判断指定点是否在指定三角形之中*/
+				/*如果在，则画点，如果不在，则不做处理*/
+				if (ref_pnpoly(3, vx, vy, i, j)) {ref_DrawPoint(i, j);}
+			}
+		}
+	}
+}
+
+void ref_DrawCircle(int16_t X, int16_t Y, uint8_t Radius, uint8_t IsFilled)
+{
+	int16_t x, y, d, j;
+	
+	/*使用Bresenham算法画圆，可以避免耗时的浮点运算，效率更高*/
+	/*参考文档：https://www.cs.montana.edu/courses/spring2009/425/dslectures/Bresenham.pdf*/
+	/*参考教程：https://www.bilibili.com/video/BV1VM4y1u7wJ*/
+	
+	d = 1 - Radius;
+	x = 0;
+	y = Radius;
+	
+	/*画每个八分之一圆弧的起始点*/
+	ref_DrawPoint(X + x, Y + y);
+	ref_DrawPoint(X - x, Y - y);
+	ref_DrawPoint(X + y, Y + x);
+	ref_DrawPoint(X - y, Y - x);
+	
+	if (IsFilled)		//指定圆填充
+	{
+		/*遍历起始点Y坐标*/
+		for (j = -y; j < y; j ++)
+		{
+			/*在指定区域画点，填充部分圆*/
+			ref_DrawPoint(X, Y + j);
+		}
+	}
+	
+	while (x < y)		//遍历X轴的每个点
+	{
+		x ++;
+		if (d < 0)		//下一个点在当前点东方
+		{
+			d += 2 * x + 1;
+		}
+		else			//下一个点在当前点东南方
+		{
+			y --;
+			d += 2 * (x - y) + 1;
+		}
+		
+		/*画每个八分之一圆弧的点*/
+		ref_DrawPoint(X + x, Y + y);
+		ref_DrawPoint(X + y, Y + x);
+		ref_DrawPoint(X - x, Y - y);
+		ref_DrawPoint(X - y, Y - x);
+		ref_DrawPoint(X + x, Y - y);
+		ref_DrawPoint(X + y, Y - x);
+		ref_DrawPoint(X - x, Y + y);
+		ref_DrawPoint(X - y, Y + x);
+		
+		if (IsFilled)	//指定圆填充
+		{
+			/*遍历中间部分*/
+			for (j = -y; j < y; j ++)
+			{
+				/*在指定区域画点，填充部分圆*/
+				ref_DrawPoint(X + x, Y + j);
+				ref_DrawPoint(X - x, Y + j);
+			}
+			
+			/*遍历两侧部分*/
+			for (j = -x; j < x; j ++)
+			{
+				/*在指定区域画点，填充部分圆*/
+				ref_DrawPoint(X - y, Y + j);
+				ref_DrawPoint(X + y, Y + j);
+			}
+		}
+	}
+}
+
+void ref_DrawEllipse(int16_t X, int16_t Y, uint8_t A, uint8_t B, uint8_t IsFilled)
+{
+	int16_t x, y, j;
+	int16_t a = A, b = B;
+	float d1, d2;
+	
+	/*使用Bresenham算法画椭圆，可以避免部分耗时的浮点运算，效率更高*/
+	/*参考链接：https://blog.csdn.net/myf_666/article/details/128167392*/
+	
+	x = 0;
+	y = b;
+	d1 = b * b + a * a * (-b + 0.5);
+	
+	if (IsFilled)	//指定椭圆填充
+	{
+		/*遍历起始点Y坐标*/
+		for (j = -y; j < y; j ++)
+		{
+			/*在指定区域画点，填充部分椭圆*/
+			ref_DrawPoint(X, Y + j);
+			ref_DrawPoint(X, Y + j);
+		}
+	}
+	
+	/*画椭圆弧的起始点*/
+	ref_DrawPoint(X + x, Y + y);
+	ref_DrawPoint(X - x, Y - y);
+	ref_DrawPoint(X - x, Y + y);
+	ref_DrawPoint(X + x, Y - y);
+	
+	/*画椭圆中间部分*/
+	while (b * b * (x + 1) < a * a * (y - 0.5))
+	{
+		if (d1 <= 0)		//下一个点在当前点东方
+		{
+			d1 += b * b * (2 * x + 3);
+		}
+		else				//下一个点在当前点东南方
+		{
+			d1 += b * b * (2 * x + 3) + a * a * (-2 * y + 2);
+			y --;
+		}
+		x ++;
+		
+		if (IsFilled)	//指定椭圆填充
+		{
+			/*遍历中间部分*/
+			for (j = -y; j < y; j ++)
+			{
+				/*在指定区域画点，填充部分椭圆*/
+				ref_DrawPoint(X + x, Y + j);
+				ref_DrawPoint(X - x, Y + j);
+			}
+		}
+		
+		/*画椭圆中间部分圆弧*/
+		ref_DrawPoint(X + x, Y + y);
+		ref_DrawPoint(X - x, Y - y);
+		ref_DrawPoint(X - x, Y + y);
+		ref_DrawPoint(X + x, Y - y);
+	}
+	
+	/*画椭圆两侧部分*/
+	d2 = b * b * (x + 0.5) * (x + 0.5) + a * a * (y - 1) * (y - 1) - a * a * b * b;
+	
+	while (y > 0)
+	{
+		if (d2 <= 0)		//下一个点在当前点东方
+		{
+			d2 += b * b * (2 * x + 2) + a * a * (-2 * y + 3);
+			x ++;
+			
+		}
+		else				//下一个点在当前点东南方
+		{
+			d2 += a * a * (-2 * y + 3);
+		}
+		y --;
+		
+		if (IsFilled)	//指定椭圆填充
+		{
+			/*遍历两侧部分*/
+			for (j = -y; j < y; j ++)
+			{
+				/*在指定区域画点，填充部分椭圆*/
+				ref_DrawPoint(X + x, Y + j);
+				ref_DrawPoint(X - x, Y + j);
+			}
+		}
+		
+		/*画椭圆两侧部分圆弧*/
+		ref_DrawPoint(X + x, Y + y);
+		ref_DrawPoint(X - x, Y - y);
+		ref_DrawPoint(X - x, Y + y);
+		ref_DrawPoint(X + x, Y - y);
+	}
+}
+
+void ref_DrawArc(int16_t X, int16_t Y, uint8_t Radius, int16_t StartAngle, int16_t EndAngle, uint8_t IsFilled)
+{
+	int16_t x, y, d, j;
+	
+	/*此函数借用Bresenham算法画圆的方法*/
+	
+	d = 1 - Radius;
+	x = 0;
+	y = Radius;
+	
+	/*在画圆的每个点时，判断指定点是否在指定角度内，在，则画点，不在，则不做处理*/
+	if (ref_IsInAngle(x, y, StartAngle, EndAngle))	{ref_DrawPoint(X + x, Y + y);}
+	if (ref_IsInAngle(-x, -y, StartAngle, EndAngle)) {ref_DrawPoint(X - x, Y - y);}
+	if (ref_IsInAngle(y, x, StartAngle, EndAngle)) {ref_DrawPoint(X + y, Y + x);}
+	if (ref_IsInAngle(-y, -x, StartAngle, EndAngle)) {ref_DrawPoint(X - y, Y - x);}
+	
+	if (IsFilled)	//指定圆弧填充
+	{
+		/*遍历起始点Y坐标*/
+		for (j = -y; j < y; j ++)
+		{
+			/*在填充圆的每个点时，判断指定点是否在指定角度内，在，则画点，不在，则不做处理*/
+			if (ref_IsInAngle(0, j, StartAngle, EndAngle)) {ref_DrawPoint(X, Y + j);}
+		}
+	}
+	
+	while (x < y)		//遍历X轴的每个点
+	{
+		x ++;
+		if (d < 0)		//下一个点在当前点东方
+		{
+			d += 2 * x + 1;
+		}
+		else			//下一个点在当前点东南方
+		{
+			y --;
+			d += 2 * (x - y) + 1;
+		}
+		
+		/*在画圆的每个点时，判断指定点是否在指定角度内，在，则画点，不在，则不做处理*/
+		if (ref_IsInAngle(x, y, StartAngle, EndAngle)) {ref_DrawPoint(X + x, Y + y);}
+		if (ref_IsInAngle(y, x, StartAngle, EndAngle)) {ref_DrawPoint(X + y, Y + x);}
+		if (ref_IsInAngle(-x, -y, StartAngle, EndAngle)) {ref_DrawPoint(X - x, Y - y);}
+		if (ref_IsInAngle(-y, -x, StartAngle, EndAngle)) {ref_DrawPoint(X - y, Y - x);}
+		if (ref_IsInAngle(x, -y, StartAngle, EndAngle)) {ref_DrawPoint(X + x, Y - y);}
+		if (ref_IsInAngle(y, -x, StartAngle, EndAngle)) {ref_DrawPoint(X + y, Y - x);}
+		if (ref_IsInAngle(-x, y, StartAngle, EndAngle)) {ref_DrawPoint(X - x, Y + y);}
+		if (ref_IsInAngle(-y, x, StartAngle, EndAngle)) {ref_DrawPoint(X - y, Y + x);}
+		
+		if (IsFilled)	//指定圆弧填充
+		{
+			/*遍历中间部分*/
+			for (j = -y; j < y; j ++)
+			{
+				/*在填充圆的每个点时，判断指定点是否在指定角度内，在，则画点，不在，则不做处理*/
+				if (ref_IsInAngle(x, j, StartAngle, EndAngle)) {ref_DrawPoint(X + x, Y + j);}
+				if (ref_IsInAngle(-x, j, StartAngle, EndAngle)) {ref_DrawPoint(X - x, Y + j);}
+			}
+			
+			/*遍历两侧部分*/
+			for (j = -x; j < x; j ++)
+			{
+				/*在填充圆的每个点时，判断指定点是否在指定角度内，在，则画点，不在，则不做处理*/
+				if (ref_IsInAngle(-y, j, StartAngle, EndAngle)) {ref_DrawPoint(X - y, Y + j);}
+				if (ref_IsInAngle(y, j, StartAngle, EndAngle)) {ref_DrawPoint(X + y, Y + j);}
+			}
+		}
+	}
+}
@@ -0,0 +1,69 @@
+//MG513直流减速电机模型
+//  L di/dt = V - R i - Ke w
+//  J dw/dt = Kt i - B w - Tf sign(w) - Tload
+//参数按12V、空载约366rpm（输出轴）、堵转约4.8A估算，机械时间常数约30ms
+#include "plant.h"
+#include <math.h>
+
+#define PLANT_R         2.5         //电枢电阻  ohm
+#define PLANT_L         1.5e-3      //电枢电感  H
+#define PLANT_KE        0.0110      //反电动势常数  V*s/rad（=Kt）
+#define PLANT_J         1.5e-6      //折算到电机轴的转动惯量  kg*m^2
+#define PLANT_B         2.0e-7      //粘滞摩擦  N*m*s/rad
+#define PLANT_TF        1.5e-3      //库仑摩擦  N*m
+
+#define PI 3.14159265358979
+
+void plant_Init(MotorModel* m) {
+    m->theta = 0;
+    m->omega = 0;
+    m->current = 0;
+    m->count = 0;
+    m->load = 0;
+}
+
+static void plant_UpdateCount(MotorModel* m) {
+    m->count = (int64_t) floor(m->theta / (2 * PI) * PLANT_CPR);
+}
+
+//半隐式欧拉，dt取10us以内
+void plant_Step(MotorModel* m, double voltage, int driven, double dt) {
+    double torque;
+
+    if (driven) {
+        m->current += (voltage - PLANT_R * m->current - PLANT_KE * m->omega) / PLANT_L * dt;
+    } else {
+        m->current = 0;
+    }
+
+    torque = PLANT_KE * m->current - PLANT_B * m->omega - m->load;
+    if (fabs(m->omega) > 1e-3) {
+        torque -= m->omega > 0 ? PLANT_TF : -PLANT_TF;
+    } else if (fabs(torque) <= PLANT_TF) {
+        //静摩擦
+        torque = 0;
+        m->omega = 0;
+    } else {
+        torque -= torque > 0 ? PLANT_TF : -PLANT_TF;
+    }
+
+    m->omega += torque / PLANT_J * dt;
+    m->theta += m->omega * dt;
+    plant_UpdateCount(m);
+}
+
+void plant_SetAngle(MotorModel* m, double output_deg) {
+    double theta = output_deg / 360.0 * 2 * PI * PLANT_RATIO;
+    m->current = 0;
+    m->omega = 0;
+    m->theta = theta;
+    plant_UpdateCount(m);
+}
+
+double plant_OutputRpm(const MotorModel* m) {
+    return m->omega / (2 * PI) * 60.0 / PLANT_RATIO;
+}
+
+double plant_OutputDeg(const MotorModel* m) {
+    return m->theta / (2 * PI) * 360.0 / PLANT_RATIO;
+}
@@ -0,0 +1,25 @@
+//MG513直流减速电机 + 霍尔编码器模型
+#ifndef __PLANT_H__
+#define __PLANT_H__
+
+#include <stdint.h>
+
+typedef struct {
+    double theta;                   //电机轴转角  rad
+    double omega;                   //电机轴角速度  rad/s
+    double current;                 //电枢电流  A
+    int64_t count;                  //编码器计数（电机轴，4倍频）
+    double load;                    //外加负载转矩（折算到电机轴）  N*m，与正转方向相反
+}MotorModel;
+
+#define PLANT_SUPPLY        12.0    //驱动电压  V
+#define PLANT_RATIO         28.0    //减速比    与Parameter一致
+#define PLANT_CPR           52.0    //电机轴每圈计数    13线 * 4倍频
+
+void plant_Init(MotorModel* m);
+void plant_Step(MotorModel* m, double voltage, int driven, double dt);  //driven为0时电枢开路（滑行）
+void plant_SetAngle(MotorModel* m, double output_deg);                  //外力直接转动输出轴（跟随模式的主电机）
+double plant_OutputRpm(const MotorModel* m);
+double plant_OutputDeg(const MotorModel* m);
+
+#endif //__PLANT_H__
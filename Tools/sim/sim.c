@@ -0,0 +1,2159 @@
+//MG513闭环仿真：User/Src控制代码 + HAL桩 + 电机模型，在Linux上快于实时运行
+//编译（在仓库根目录）：
+//  gcc -O2 -ITools/sim -ITools -IUser/Inc -o mg513_sim Tools/sim/*.c Tools/telemetry_decoder.c User/Src/pid.c
+//      User/Src/encoder.c User/Src/filter.c User/Src/mg513.c User/Src/planner.c User/Src/motion.c
+//      User/Src/telemetry.c User/Src/profiler.c User/Src/bench.c User/Src/OLED.c User/Src/OLED_Data.c
+//      User/Src/menu.c User/Src/key.c User/Src/knob.c -lm
+//  （以上为同一条命令）Tools/sim下的main.h、tim.h、usart.h替代Core/Inc中的同名头文件
+//用法：mg513_sim [-t 遥测文件] [-d 仿真时长s] [模式名...]   不指定模式时运行全部模式
+//输出：每个模式一行JSON（JSON Lines），字段：
+//  mode target unit rise_ms overshoot_pct settling_ms ss_error
+//  rise_ms       10%~90%上升时间，未到达为-1
+//  overshoot_pct 相对目标的超调百分比
+//  settling_ms   最后一次离开±2%误差带的时刻，始终未进入为-1
+//  ss_error      最后200ms的平均误差（目标-实际）
+//遥测文件可用Tools/telemetry_decode解码
+//
+//遥测回环：mg513_sim --telemetry
+//  帧经环形缓冲（含缓冲区满丢帧）和模拟DMA发出，原样、加入误码/丢字节/杂散字节后分别送入Tools/telemetry_decoder.c，
+//  再模拟DMA发送出错（丢弃出错的一段后继续发送）
+//  每种一行JSON，字段：case frames lost crc_errors ok，解出的帧数、按序号统计的丢帧数或帧内容与预期不符时退出码为1
+//
+//基准测试：mg513_sim --bench [-n 次数] [--tol 允许变慢比例] [--baseline 文件] [--save 文件]
+//  每个函数一行JSON，字段：bench ns_per_call heap_delta baseline regressed
+//  基准文件每行 "函数名 ns"，由--save生成；任一项超过 baseline * (1 + tol) 时退出码为1
+//  ns基准与机器相关，只应和同一台机器上保存的基准比较
+//
+//OLED刷新量：mg513_sim --oled
+//  按菜单的绘制方式逐帧绘制，每帧一行JSON，字段：frame scene bytes full_bytes pin_writes ns match
+//  bytes为OLED_Update实际发送的字节数，full_bytes为整屏刷新的字节数
+//  pin_writes为软件I2C写引脚次数（HAL_GPIO_WritePin或BSRR），ns为主机上刷新一帧的耗时
+//  match为模拟I2C从机解析出的屏幕内容是否与显存一致，不一致时退出码为1
+//  默认使用OLED_BACKEND_HOST；编译时加 -DOLED_BACKEND=0（HAL软件I2C）或 -DOLED_BACKEND=3（BSRR软件I2C）
+//  可比较两种软件I2C的引脚波形开销
+//
+//文字绘制：mg513_sim --text [-n 次数]
+//  按菜单各页的文字布局绘制，每页一行JSON，字段：page chars blit_ns image_ns same
+//  blit_ns为OLED_ShowString每绘制一页的耗时，image_ns为逐字符OLED_ShowImage（原绘制方式）的耗时
+//  same为两种方式绘制结果是否一致，不一致时退出码为1
+//
+//数字格式化：mg513_sim --format [-n 随机次数]
+//  OLED_Printf、OLED_ShowFloatNum、OLED_ShowFixedNum的显示结果与snprintf格式化后显示的结果逐像素比较
+//  不一致的用例各输出一行JSON，最后输出汇总：cases failed；有不一致时退出码为1
+//
+//图形绘制：mg513_sim --shapes [-n 随机次数]
+//  随机的三角形、圆、椭圆、圆弧与oled_ref.c中的逐点参考实现逐像素比较，每种图形一行JSON
+//  字段：shape filled cases ns ref_ns same，ns和ref_ns为平均每次绘制的耗时，不一致时退出码为1
+//
+//抗扰与CPU余量：mg513_sim --disturb
+//  Speed_Control、Position_Control稳定后在左电机上突加负载转矩，每个模式一行JSON
+//  字段：mode load_nm dip recover_ms ss_error tick_mean_ns tick_p99_ns headroom_pct ok
+//  dip为加负载后的最大偏差，recover_ms为偏差回到±2%误差带内的时间，ss_error为最后200ms的平均误差
+//  tick_*_ns为主机上每个控制节拍的耗时，headroom_pct为按SIM_TARGET_SLOWDOWN换算到目标板后控制周期的剩余比例
+//  恢复时间超过该模式的上限、稳态误差超过误差带的一半或余量低于SIM_MIN_HEADROOM时退出码为1
+//
+//重新进入模式：mg513_sim --restart
+//  Speed_Control运行中再次选择当前模式、Position_Control停止后再打开，每种一行JSON，字段：case stale clean ok
+//  stale为操作前控制环带有积分、上次输出等状态，clean为重新进入后这些状态为0（位置目标保留），否则退出码为1
+//
+//菜单：mg513_sim --menu
+//  向Menu_Handle回放输入事件序列，每步一行JSON，字段：step flushes ok
+//  ok为屏幕（模拟I2C从机解析出的内容）是否显示预期内容、刷新次数是否符合预期，任一步不符时退出码为1
+//
+//按键：mg513_sim --keys [-n 随机次数]
+//  向Key_OK、Key_ON输入带抖动的电平序列，逐毫秒调用key_Tick，每个用例一行JSON，字段：case events ok
+//  events为取出的事件（o/n为OK/ON键，P按下 R松开 L长按 T自动重复），与预期不符时退出码为1
+//
+//编码器：mg513_sim --encoder
+//  向M/T测速输入合成的边沿时刻序列（匀速、极低速、无边沿、停转后重启、反转、CYCCNT回绕），每个用例一行JSON
+//  字段：case v ok，v为最后的估计值  rpm，估计值超出允许误差时退出码为1
+//  再模拟encoderCount64与溢出中断竞争（正反转，中断打断读、读时UIF挂起），每个用例一行JSON，字段：case reads count ok
+//  count为最后读到的64位计数，读数不在读前后的实际位置之间或不单调时退出码为1
+//  最后在零点附近来回抖动、溢出中断推迟执行，读数与实际位置不符或溢出次数不为0时退出码为1
+//
+//定点pid：mg513_sim --fixed
+//  同一输入序列分别送入浮点pid和Q16.16定点pid（速度环、位置环，含超出Q16.16范围的大角度），每个用例一行JSON
+//  字段：case steps max_diff peak ok，max_diff为两者输出之差的最大值，不小于FIXED_TOL时退出码为1
+//
+//运动规划：mg513_sim --planner [-n 随机次数]
+//  梯形、S曲线、无匀速段、只有减速段、距离不足、不收敛各一个用例，指令队列衔接中被清空（须减速停住）两个用例，
+//  再加随机起止速度、距离和上限
+//  每个用例一行JSON，字段：case p v vpeak apeak jpeak ok，p v为终点状态，*peak为速度、加速度、加加速度的最大绝对值
+//  规划成功时终点偏差或任一项超过上限、预期失败的用例规划成功时退出码为1
+//
+//S曲线查表：mg513_sim --curve
+//  sigmoidLookup与解析的s(x)逐点比较，VelocityCurve、PositionCurve每个节拍与用exp计算的同一条曲线比较
+//  每个用例一行JSON，字段：case points max_err bound ok，max_err为误差最大值（曲线按幅值归一化），超过bound时退出码为1
+//  旧的S曲线只在主机上编译（pid.h中的PID_CURVE），固件的曲线模式使用planner.c
+//
+//中值滤波：mg513_sim --filter [-n 样本数]
+//  随机输入（有限值、夹杂NaN/Inf、有序数组被改写）与逐次排序的参考实现比较，每个用例一行JSON
+//  字段：case samples mismatches ok，NaN/Inf不进入窗口，输出与参考不同时退出码为1
+//
+//在线整定：mg513_sim --tune
+//  位置控制运动中修改位置环参数，分别不修改、直接setPIDParam、mg513_Tune各运行一次，每种一行JSON，字段：tune bump
+//  bump为修改后10ms内位置环输出与不修改时之差的最大值；mg513_Tune的bump不小于直接修改的1/10
+//  或参数未在下一节拍才生效时退出码为1
+//
+//旋钮：mg513_sim --knob [-n 随机次数]
+//  按格雷码序列改变AB相电平（可带随机抖动、漏中断），每个用例一行JSON，字段：case detents steps invalid ok
+//  detents为knob_Read读出的格数，steps为加速后的格数，与预期不符时退出码为1
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "tim.h"
+#include "sim.h"
+#include "plant.h"
+#include "mg513.h"
+#include "pid.h"
+#include "telemetry.h"
+#include "profiler.h"
+#include "bench.h"
+#include "OLED.h"
+#include "OLED_Data.h"
+#include "menu.h"
+#include "key.h"
+#include "knob.h"
+#include "planner.h"
+#include "motion.h"
+#include "encoder.h"
+#include "filter.h"
+#include "telemetry_decoder.h"
+#include <malloc.h>
+
+#define SIM_SUBSTEPS        100         //每个控制节拍内电机模型积分步数（1ms / 100 = 10us）
+#define SIM_SETTLE_BAND     0.02        //调节时间误差带
+#define SIM_SS_WINDOW_MS    200         //稳态误差统计窗口
+
+extern PID vec_l, ang_l;
+
+typedef enum {
+    SIGNAL_LEFT_RPM,
+    SIGNAL_LEFT_DEG,
+    SIGNAL_RIGHT_DEG
+}Signal;
+
+//每个模式的激励：设置目标的方式和观测量
+typedef struct {
+    MotorMode mode;
+    const char* name;
+    float target;
+    Signal signal;
+    const char* unit;
+}Scenario;
+
+static const Scenario scenarios[] = {
+    {Init,                  "Init",                  0,   SIGNAL_LEFT_RPM,  "rpm"},
+    {Speed_Control,         "Speed_Control",         200, SIGNAL_LEFT_RPM,  "rpm"},
+    {Position_Control,      "Position_Control",      360, SIGNAL_LEFT_DEG,  "deg"},
+    {Speed_Follow,          "Speed_Follow",          200, SIGNAL_LEFT_RPM,  "rpm"},
+    {Position_Follow_L,     "Position_Follow_L",     360, SIGNAL_RIGHT_DEG, "deg"},
+    {Position_Follow_R,     "Position_Follow_R",     360, SIGNAL_LEFT_DEG,  "deg"},
+    {Speed_CurveControl,    "Speed_CurveControl",    200, SIGNAL_LEFT_RPM,  "rpm"},
+    {Position_CurveControl, "Position_CurveControl", 360, SIGNAL_LEFT_DEG,  "deg"},
+};
+
+static MotorModel motor_l, motor_r;
+static void (*scenario_hook)(uint32_t ms);  //每个控制节拍之前调用，NULL为不调用
+static uint32_t* scenario_tick_ns;          //非NULL时记录每个控制节拍的耗时（主机ns），长度为仿真毫秒数
+
+//A相边沿：A相每2个计数翻转一次
+static int64_t edge_index(int64_t count) {
+    return count >= 0 ? count / 2 : (count - 1) / 2;
+}
+
+//把模型的计数变化同步到编码器定时器，产生溢出中断和A相边沿中断
+static void sync_encoder(const MotorModel* m, int64_t* last, TIM_HandleTypeDef* htim, uint16_t edge_pin,
+                         uint64_t step_start, uint32_t step_cycles) {
+    TIM_TypeDef* tim = htim->Instance;
+    int64_t target = m->count;
+    int64_t total = target - *last;
+
+    if (!(tim->CR1 & TIM_CR1_CEN)) {
+        *last = target;
+        return;
+    }
+
+    for (int64_t k = 1; *last != target; k++) {
+        int step = target > *last ? 1 : -1;
+        int64_t before = edge_index(*last);
+
+        *last += step;
+        if (step > 0) {
+            tim->CR1 &= ~TIM_CR1_DIR;
+            tim->CNT = (tim->CNT + 1) & 0xFFFF;
+        } else {
+            tim->CR1 |= TIM_CR1_DIR;
+            tim->CNT = (tim->CNT - 1) & 0xFFFF;
+        }
+
+        //计数器回绕：更新中断
+        if ((step > 0 && tim->CNT == 0) || (step < 0 && tim->CNT == 0xFFFF)) {
+            tim->SR |= TIM_FLAG_UPDATE;
+            if (tim->DIER & TIM_IT_UPDATE) {
+                tim->SR &= ~TIM_FLAG_UPDATE;
+                HAL_TIM_PeriodElapsedCallback(htim);
+            }
+        }
+
+        //A相边沿：时刻在本步内按计数均匀插值
+        if (edge_index(*last) != before) {
+            sim_dwt.CYCCNT = (uint32_t) (step_start + (uint64_t) step_cycles * (uint64_t) k
+                                                      / (uint64_t) (total > 0 ? total : -total));
+            mg513_EncoderEdge(edge_pin);
+        }
+    }
+}
+
+//驱动桥：INx1/INx2决定方向，CCR决定占空比，通道关闭或两路同为低电平时滑行
+static double bridge_voltage(uint16_t in1, uint16_t in2, uint32_t channel, int* driven) {
+    TIM_TypeDef* tim = htim1.Instance;
+    int pos = (sim_gpioa.ODR & in1) != 0;
+    int neg = (sim_gpioa.ODR & in2) != 0;
+    double duty;
+
+    *driven = (tim->CR1 & TIM_CR1_CEN) && (tim->CCER & (1u << (channel >> 2))) && (pos != neg);
+    if (!*driven)
+        return 0;
+    duty = (double) (&tim->CCR1)[channel >> 2] / (double) (htim1.Init.Period);
+    if (duty > 1)
+        duty = 1;
+    return (pos ? 1 : -1) * duty * PLANT_SUPPLY;
+}
+
+static double observe(Signal signal) {
+    switch (signal) {
+        case SIGNAL_LEFT_RPM:
+            return plant_OutputRpm(&motor_l);
+        case SIGNAL_LEFT_DEG:
+            return plant_OutputDeg(&motor_l);
+        case SIGNAL_RIGHT_DEG:
+            return plant_OutputDeg(&motor_r);
+    }
+    return 0;
+}
+
+//运行一个模式，返回采样序列（每ms一个点）
+static double* run_scenario(const Scenario* sc, uint32_t duration_ms) {
+    double* y = malloc(sizeof(double) * duration_ms);
+    uint32_t tick_cycles = (htim4.Init.Prescaler + 1) * (htim4.Init.Period + 1);    //定时器时钟72MHz
+    uint32_t step_cycles = tick_cycles / SIM_SUBSTEPS;
+    double dt = (double) step_cycles / SystemCoreClock;
+    int64_t last_l = 0, last_r = 0;
+
+    sim_ResetPeripherals();
+    plant_Init(&motor_l);
+    plant_Init(&motor_r);
+    telemetry_Init();
+    profiler_Init();
+    mg513_EncoderInit();
+
+    //与菜单操作顺序一致：选模式、设目标、打开电机
+    mg513_SetMode(sc->mode);
+    switch (sc->mode) {
+        case Speed_Control:
+        case Speed_Follow:
+            setPIDTarget(&vec_l, sc->target);
+            break;
+        case Position_Control:
+            setPIDTarget(&ang_l, sc->target);
+            break;
+        case Speed_CurveControl:
+            mg513_PlanSpeed(sc->target, 0, 0);
+            break;
+        case Position_CurveControl:
+            mg513_PlanPosition(sc->target, 0, 0, 0);
+            break;
+        default:
+            break;
+    }
+    mg513_Start();
+
+    for (uint32_t ms = 0; ms < duration_ms; ms++) {
+        //跟随模式：主电机由外力在500ms内匀速转到目标
+        double master = sc->target * (ms < 500 ? ms / 500.0 : 1.0);
+        if (sc->mode == Position_Follow_L)
+            plant_SetAngle(&motor_l, master);
+        else if (sc->mode == Position_Follow_R)
+            plant_SetAngle(&motor_r, master);
+
+        for (int s = 0; s < SIM_SUBSTEPS; s++) {
+            int driven_l, driven_r;
+            double v_l = bridge_voltage(AIN1_Pin, AIN2_Pin, TIM_CHANNEL_3, &driven_l);
+            double v_r = bridge_voltage(BIN1_Pin, BIN2_Pin, TIM_CHANNEL_4, &driven_r);
+            uint64_t step_start = sim_cycles;
+
+            if (!(sc->mode == Position_Follow_L))
+                plant_Step(&motor_l, v_l, driven_l, dt);
+            if (!(sc->mode == Position_Follow_R))
+                plant_Step(&motor_r, v_r, driven_r, dt);
+            sync_encoder(&motor_l, &last_l, &htim2, GPIO_PIN_0, step_start, step_cycles);
+            sync_encoder(&motor_r, &last_r, &htim3, GPIO_PIN_6, step_start, step_cycles);
+
+            sim_cycles += step_cycles;
+            sim_dwt.CYCCNT = (uint32_t) sim_cycles;
+        }
+
+        if (scenario_hook != NULL)
+            scenario_hook(ms);
+
+        //控制节拍
+        if ((htim4.Instance->CR1 & TIM_CR1_CEN) && (htim4.Instance->DIER & TIM_IT_UPDATE)) {
+            uint32_t start = profiler_Now();
+            HAL_TIM_PeriodElapsedCallback(&htim4);
+            if (scenario_tick_ns != NULL)
+                scenario_tick_ns[ms] = profiler_Now() - start;
+        }
+        sim_UartService();
+
+        y[ms] = observe(sc->signal);
+    }
+
+    mg513_Stop();
+    mg513_SetMode(Init);
+    return y;
+}
+
+//阶跃响应指标，输出一行JSON
+static void report(const Scenario* sc, const double* y, uint32_t n) {
+    double target = sc->target;
+    double band = fabs(target) * SIM_SETTLE_BAND;
+    double peak = 0, ss = 0;
+    long t10 = -1, t90 = -1, settle = -1;
+    uint32_t window = n < SIM_SS_WINDOW_MS ? n : SIM_SS_WINDOW_MS;
+
+    if (band == 0)
+        band = 1;   //零目标时误差带取1个单位
+
+    for (uint32_t i = 0; i < n; i++) {
+        double r = target != 0 ? y[i] / target : 0;
+        if (t10 < 0 && r >= 0.1)
+            t10 = i;
+        if (t90 < 0 && r >= 0.9)
+            t90 = i;
+        if (target != 0 && y[i] / target > peak)
+            peak = y[i] / target;
+        if (fabs(y[i] - target) > band)
+            settle = -1;
+        else if (settle < 0)
+            settle = i;
+    }
+    for (uint32_t i = n - window; i < n; i++) {
+        ss += target - y[i];
+    }
+    ss /= window;
+
+    printf("{\"mode\":\"%s\",\"target\":%g,\"unit\":\"%s\",\"rise_ms\":%ld,\"overshoot_pct\":%.2f,"
+           "\"settling_ms\":%ld,\"ss_error\":%.4f}\n",
+           sc->name, target, sc->unit, (t10 >= 0 && t90 >= 0) ? t90 - t10 : -1,
+           peak > 1 ? (peak - 1) * 100 : 0, settle, ss);
+}
+
+extern uint8_t OLED_DisplayBuf[8][128];
+
+//刷新一帧，输出发送字节数、GPIO写次数、耗时，并检查模拟屏幕与显存是否一致
+static uint32_t oled_Flush(uint32_t frame, const char* scene, uint32_t full, int* ok) {
+    uint32_t tx = OLED_GetTxCount(), writes = sim_gpio_writes, start = profiler_Now();
+    int match;
+
+    OLED_Update();
+    OLED_WaitIdle();
+    uint32_t ns = profiler_Now() - start;
+    tx = OLED_GetTxCount() - tx;
+    match = memcmp(sim_oled, OLED_DisplayBuf, sizeof(sim_oled)) == 0 && sim_oled_errors == 0;
+    *ok &= match;
+    printf("{\"frame\":%u,\"scene\":\"%s\",\"bytes\":%u,\"full_bytes\":%u,\"pin_writes\":%u,\"ns\":%u,"
+           "\"match\":%s}\n", frame, scene, tx, full ? full : tx, sim_gpio_writes - writes, ns,
+           match ? "true" : "false");
+    return tx;
+}
+
+//按菜单的绘制方式逐帧绘制，统计每帧OLED_Update的发送量
+static int run_oled(void) {
+    static const char* items[] = {"Speed Control", "Position Control", "Speed Follow", "Position Follow",
+                                  "Speed Curve", "Position Curve", "Diagnostics"};
+    static const uint8_t cursor[] = {0, 1, 2, 2, 2, 3, 6, 5, 0};
+    uint32_t frame = 0, full;
+    int ok = 1;
+
+    sim_ResetPeripherals();
+    OLED_Init();
+
+    //整屏刷新：主页
+    for (uint8_t k = 0; k < 7; k++)
+        OLED_ShowString(16, 9 * k, (char*) items[k], OLED_6X8);
+    OLED_Invalidate();
+    full = oled_Flush(frame++, "home", 0, &ok);
+
+    //选项指针：与原Menu_option相同，每次清除指针列后重画
+    for (size_t k = 0; k < sizeof(cursor); k++) {
+        OLED_ClearArea(0, 0, 16, 64);
+        OLED_ShowImage(0, (int16_t) (cursor[k] * 9), 16, 9, This);
+        oled_Flush(frame++, "cursor", full, &ok);
+    }
+
+    //运行界面：整屏清除后重画，只有数值变化
+    for (int32_t k = 0; k < 6; k++) {
+        OLED_Clear();
+        OLED_ShowString(0, 0, "Speed Control", OLED_6X8);
+        OLED_ShowString(0, 16, "Target:", OLED_6X8);
+        OLED_ShowSignedNum(48, 16, 200, 3, OLED_6X8);
+        OLED_ShowString(0, 32, "Speed:", OLED_6X8);
+        OLED_ShowSignedNum(48, 32, 195 + k / 2, 3, OLED_6X8);
+        oled_Flush(frame++, "redraw", full, &ok);
+    }
+    return !ok;
+}
+
+//菜单各页的文字：与menu.c中各页初始化函数相同，Y为9的倍数，多数行不按页对齐
+typedef struct {
+    const char* name;
+    const char* lines[8];
+}TextPage;
+
+static const TextPage text_pages[] = {
+    {"Menu",  {"Speed Control", "Position Control", "Speed Follow", "Position Follow", "Speed Curve",
+               "Position Curve", "Diagnostics"}},
+    {"Mode1", {"OFF", "SetSpeed", "BACK", "Kp", "Ki", "Kd"}},
+    {"Mode2", {"OFF", "SetAngle", "BACK"}},
+    {"Mode4", {"OFF", "Control Motor", "BACK"}},
+    {"Mode5", {"OFF", "Speed", "Acceleration", "BACK"}},
+    {"Mode6", {"OFF", "Angle", "Speed", "BACK", "Queue"}},
+};
+
+//原绘制方式：逐字符调用OLED_ShowImage
+static void text_Image(const TextPage* page) {
+    for (uint8_t k = 0; k < 8 && page->lines[k] != NULL; k++) {
+        for (const char* c = page->lines[k]; *c; c++)
+            OLED_ShowImage((int16_t) (16 + (c - page->lines[k]) * 6), (int16_t) (9 * k), 6, 8, OLED_F6x8[*c - ' ']);
+    }
+}
+
+static void text_Blit(const TextPage* page) {
+    for (uint8_t k = 0; k < 8 && page->lines[k] != NULL; k++)
+        OLED_ShowString(16, (int16_t) (9 * k), (char*) page->lines[k], OLED_6X8);
+}
+
+static uint32_t text_Time(void (*draw)(const TextPage*), const TextPage* page, uint32_t iterations) {
+    uint32_t start = profiler_Now();
+    for (uint32_t i = 0; i < iterations; i++)
+        draw(page);
+    return profiler_Now() - start;
+}
+
+//逐页比较两种文字绘制方式的耗时和结果
+static int run_text(uint32_t iterations) {
+    static uint8_t image[8][128];
+    int ok = 1;
+
+    if (iterations > 100000)
+        iterations = 100000;            //32位ns计数不回绕
+    for (size_t k = 0; k < sizeof(text_pages) / sizeof(text_pages[0]); k++) {
+        const TextPage* page = &text_pages[k];
+        uint32_t chars = 0;
+        for (uint8_t n = 0; n < 8 && page->lines[n] != NULL; n++)
+            chars += (uint32_t) strlen(page->lines[n]);
+
+        OLED_Clear();
+        uint32_t image_ns = text_Time(text_Image, page, iterations);
+        memcpy(image, OLED_DisplayBuf, sizeof(image));
+        OLED_Clear();
+        uint32_t blit_ns = text_Time(text_Blit, page, iterations);
+        int same = memcmp(image, OLED_DisplayBuf, sizeof(image)) == 0;
+        ok &= same;
+
+        printf("{\"page\":\"%s\",\"chars\":%u,\"blit_ns\":%.1f,\"image_ns\":%.1f,\"same\":%s}\n", page->name, chars,
+               (double) blit_ns / iterations, (double) image_ns / iterations, same ? "true" : "false");
+    }
+    return !ok;
+}
+
+//数字格式化：显示结果与snprintf的结果比较
+static uint8_t format_got[8][128];
+static uint32_t format_cases, format_failed;
+
+static void format_Check(const char* what, const char* expect) {
+    char quoted[64];
+    size_t i;
+
+    memcpy(format_got, OLED_DisplayBuf, sizeof(format_got));
+    OLED_Clear();
+    OLED_ShowString(0, 0, (char*) expect, OLED_6X8);
+    format_cases++;
+    if (memcmp(format_got, OLED_DisplayBuf, sizeof(format_got)) != 0) {
+        format_failed++;
+        for (i = 0; what[i] != '\0' && i < sizeof(quoted) - 1; i++)
+            quoted[i] = what[i] == '"' ? '\'' : what[i];
+        quoted[i] = '\0';
+        printf("{\"case\":\"%s\",\"expect\":\"%s\"}\n", quoted, expect);
+    }
+}
+
+#define FORMAT_CASE(...) do { \
+        char expect[32]; \
+        snprintf(expect, sizeof(expect), __VA_ARGS__); \
+        OLED_Clear(); \
+        OLED_Printf(0, 0, OLED_6X8, __VA_ARGS__); \
+        format_Check(#__VA_ARGS__, expect); \
+    } while (0)
+
+static int run_format(uint32_t iterations) {
+    char expect[32], what[64];
+
+    FORMAT_CASE("%d", 0);
+    FORMAT_CASE("%d", -2147483647 - 1);
+    FORMAT_CASE("%+5d|%-5d|", 42, -42);
+    FORMAT_CASE("% d %05d %.3d", 7, -12, 5);
+    FORMAT_CASE("%.0d|%u", 0, 4294967295u);
+    FORMAT_CASE("%x %X %08x", 0xBEEFu, 0xBEEFu, 0x1Fu);
+    FORMAT_CASE("%ld %lu", 123456789L, 987654321UL);
+    FORMAT_CASE("%*d|%-*d|", 6, 33, 4, 7);
+    FORMAT_CASE("%c%3c%-3c|", 'A', 'b', 'c');
+    FORMAT_CASE("%s|%6s|%-6s|%.2s", "rpm", "deg", "ms", "Speed");
+    FORMAT_CASE("100%%");
+    FORMAT_CASE("%f", 3.14159265);
+    FORMAT_CASE("%.2f %.0f %.1f", 0.125, 2.5, -0.05);
+    FORMAT_CASE("%8.3f|%-8.3f|", -12.3456, 1.0005);
+    FORMAT_CASE("%+.2f %08.2f", 380.0, -1.5);
+    FORMAT_CASE("%.9f", 0.1);
+    FORMAT_CASE("%.1f %.3f", 1e-30, 4294967295.4);
+
+    //随机浮点数：OLED_Printf、OLED_ShowFloatNum、OLED_ShowFixedNum
+    srand(1);
+    for (uint32_t i = 0; i < iterations; i++) {
+        float v = (float) ((rand() / (double) RAND_MAX - 0.5) * pow(10, rand() % 8 - 2));
+        int fra = rand() % 5;
+        int32_t q = (int32_t) (rand() - RAND_MAX / 2);
+
+        snprintf(what, sizeof(what), "%%.%df of %.9g", fra, v);
+        snprintf(expect, sizeof(expect), "%.*f", fra, v);
+        OLED_Clear();
+        OLED_Printf(0, 0, OLED_6X8, "%.*f", fra, v);
+        format_Check(what, expect);
+
+        if (fabsf(v) < 99999) {
+            snprintf(what, sizeof(what), "ShowFloatNum %.9g", v);
+            snprintf(expect, sizeof(expect), "%+0*.*f", 7 + fra, fra, v);
+            if (fra == 0)
+                snprintf(expect, sizeof(expect), "%+06.0f.", v);
+            OLED_Clear();
+            OLED_ShowFloatNum(0, 0, v, 5, fra, OLED_6X8);
+            format_Check(what, expect);
+        }
+
+        snprintf(what, sizeof(what), "ShowFixedNum %d", q);
+        snprintf(expect, sizeof(expect), "%+0*.*f", 7 + fra, fra, q / 65536.0);
+        if (fra == 0)
+            snprintf(expect, sizeof(expect), "%+06.0f.", q / 65536.0);
+        OLED_Clear();
+        OLED_ShowFixedNum(0, 0, q, 16, 5, fra, OLED_6X8);
+        format_Check(what, expect);
+    }
+
+    printf("{\"cases\":%u,\"failed\":%u}\n", format_cases, format_failed);
+    return format_failed != 0;
+}
+
+//图形绘制：按列填充的实现与逐点参考实现比较
+typedef enum {
+    SHAPE_TRIANGLE,
+    SHAPE_CIRCLE,
+    SHAPE_ELLIPSE,
+    SHAPE_ARC,
+    SHAPE_COUNT
+}Shape;
+
+static const char* const shape_names[SHAPE_COUNT] = {"triangle", "circle", "ellipse", "arc"};
+
+static int16_t shape_Rand(int16_t min, int16_t max) {
+    return (int16_t) (min + rand() % (max - min + 1));
+}
+
+//半径多数在屏幕尺寸内，少数取到最大值255
+static uint8_t shape_Radius(void) {
+    return (uint8_t) (rand() % 16 == 0 ? shape_Rand(0, 255) : shape_Rand(0, 70));
+}
+
+static void shape_Draw(Shape shape, const int16_t* p, uint8_t filled, int ref) {
+    switch (shape) {
+    case SHAPE_TRIANGLE:
+        (ref ? ref_DrawTriangle : OLED_DrawTriangle)(p[0], p[1], p[2], p[3], p[4], p[5], filled);
+        break;
+    case SHAPE_CIRCLE:
+        (ref ? ref_DrawCircle : OLED_DrawCircle)(p[0], p[1], (uint8_t) p[2], filled);
+        break;
+    case SHAPE_ELLIPSE:
+        (ref ? ref_DrawEllipse : OLED_DrawEllipse)(p[0], p[1], (uint8_t) p[2], (uint8_t) p[3], filled);
+        break;
+    default:
+        (ref ? ref_DrawArc : OLED_DrawArc)(p[0], p[1], (uint8_t) p[2], p[3], p[4], filled);
+        break;
+    }
+}
+
+static int run_shapes(uint32_t iterations) {
+    static uint8_t ref[8][128];
+    int ok = 1;
+
+    srand(1);
+    for (int shape = 0; shape < SHAPE_COUNT; shape++) {
+        for (uint8_t filled = 0; filled <= 1; filled++) {
+            uint64_t ns = 0, ref_ns = 0;
+            uint32_t failed = 0;
+
+            for (uint32_t i = 0; i < iterations; i++) {
+                int16_t p[6];
+                if (shape == SHAPE_TRIANGLE) {
+                    for (int k = 0; k < 6; k++)
+                        p[k] = k % 2 ? shape_Rand(-40, 103) : shape_Rand(-40, 167);
+                } else {
+                    p[0] = shape_Rand(-30, 157);
+                    p[1] = shape_Rand(-30, 93);
+                    p[2] = shape_Radius();
+                    p[3] = shape == SHAPE_ELLIPSE ? shape_Radius() : shape_Rand(-180, 180);
+                    p[4] = shape_Rand(-180, 180);
+                }
+
+                OLED_Clear();
+                uint32_t start = profiler_Now();
+                shape_Draw((Shape) shape, p, filled, 1);
+                ref_ns += profiler_Now() - start;
+                memcpy(ref, OLED_DisplayBuf, sizeof(ref));
+
+                OLED_Clear();
+                start = profiler_Now();
+                shape_Draw((Shape) shape, p, filled, 0);
+                ns += profiler_Now() - start;
+                if (memcmp(ref, OLED_DisplayBuf, sizeof(ref)) != 0 && failed++ == 0)
+                    fprintf(stderr, "%s filled=%u differs: %d %d %d %d %d %d\n", shape_names[shape], filled,
+                            p[0], p[1], p[2], p[3], p[4], shape == SHAPE_TRIANGLE ? p[5] : 0);
+            }
+            ok &= failed == 0;
+
+            printf("{\"shape\":\"%s\",\"filled\":%s,\"cases\":%u,\"ns\":%.1f,\"ref_ns\":%.1f,\"same\":%s}\n",
+                   shape_names[shape], filled ? "true" : "false", iterations, (double) ns / iterations,
+                   (double) ref_ns / iterations, failed == 0 ? "true" : "false");
+        }
+    }
+    return !ok;
+}
+
+//在线整定：位置控制运动中把位置环从P改为PI并加大kp，比较改参数后位置环输出与不改参数时的差
+//naive直接setPIDParam，ki为0期间累积的误差积分立即进入输出；mg513_Tune在下一节拍无扰生效
+#define TUNE_AT_MS          700         //修改参数的时刻
+#define TUNE_WINDOW_MS      10          //比较输出的时长
+
+typedef enum {
+    TUNE_NONE,
+    TUNE_NAIVE,
+    TUNE_BUMPLESS
+}TuneWay;
+
+static const char* const tune_ways[] = {"none", "naive", "bumpless"};
+static const PIDTune tune_new = {1.0f, 0.05f, 0, 2000, 4000};
+static TuneWay tune_way;
+static double tune_out[TUNE_WINDOW_MS];
+static int tune_deferred;                   //mg513_Tune提交后到下一节拍之前参数不变
+
+static void tune_Hook(uint32_t ms) {
+    if (ms == TUNE_AT_MS) {
+        float kp = ang_l.kp;
+        if (tune_way == TUNE_NAIVE)
+            setPIDParam(&ang_l, tune_new.kp, tune_new.ki, tune_new.kd);
+        if (tune_way == TUNE_BUMPLESS) {
+            mg513_Tune(TUNE_ANG_L, &tune_new);
+            tune_deferred = ang_l.kp == kp;
+        }
+    }
+    if (ms == TUNE_AT_MS + 1 && tune_way == TUNE_BUMPLESS)
+        tune_deferred = tune_deferred && ang_l.kp == tune_new.kp;
+    if (ms > TUNE_AT_MS && ms <= TUNE_AT_MS + TUNE_WINDOW_MS)
+        tune_out[ms - TUNE_AT_MS - 1] = ang_l.output;
+}
+
+static int run_tune(void) {
+    static const Scenario sc = {Position_Control, "Position_Control", 360, SIGNAL_LEFT_DEG, "deg"};
+    double none[TUNE_WINDOW_MS], bump[3] = {0};
+
+    scenario_hook = tune_Hook;
+    for (int way = TUNE_NONE; way <= TUNE_BUMPLESS; way++) {
+        tune_way = (TuneWay) way;
+        free(run_scenario(&sc, TUNE_AT_MS + TUNE_WINDOW_MS + 1));
+        if (way == TUNE_NONE)
+            memcpy(none, tune_out, sizeof(none));
+        for (int k = 0; k < TUNE_WINDOW_MS; k++)
+            bump[way] = fmax(bump[way], fabs(tune_out[k] - none[k]));
+        printf("{\"tune\":\"%s\",\"bump\":%.3f}\n", tune_ways[way], bump[way]);
+    }
+    scenario_hook = NULL;
+
+    //无扰切换的差应远小于直接修改，且只在下一节拍生效
+    int ok = tune_deferred && bump[TUNE_BUMPLESS] < 0.1 * bump[TUNE_NAIVE];
+    printf("{\"tune\":\"check\",\"deferred\":%s,\"ok\":%s}\n", tune_deferred ? "true" : "false",
+           ok ? "true" : "false");
+    return !ok;
+}
+
+//抗扰与CPU余量：稳定后在左电机轴上突加负载转矩，检查偏差恢复时间和恢复后的稳态误差；
+//同时记录每个控制节拍的耗时，按多速率调度下最慢的节拍（内环、外环同时执行）估算目标板上的余量
+#define DIST_MS             3000
+#define DIST_AT_MS          1500            //加负载的时刻
+#define DIST_LOAD           0.01            //负载转矩  N*m（电机轴，约为堵转转矩的1/5）
+//主机与目标板（Cortex-M3 72MHz，无FPU，浮点为软件实现）执行同一段控制代码的耗时比，按偏慢估计
+//可用目标板上CMD_BENCH的结果和--bench的结果校准
+#define SIM_TARGET_SLOWDOWN 300
+#define SIM_MIN_HEADROOM    50              //最慢节拍换算到目标板后至少留出的控制周期百分比
+
+static int disturb_ok;
+
+static void disturb_Hook(uint32_t ms) {
+    motor_l.load = ms >= DIST_AT_MS ? DIST_LOAD : 0;
+}
+
+static int tick_Compare(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*) a, y = *(const uint32_t*) b;
+    return (x > y) - (x < y);
+}
+
+//recover_max为回到误差带（SIM_SETTLE_BAND）内允许的最长时间  ms
+static void disturb_Case(const Scenario* sc, long recover_max) {
+    static uint32_t tick_ns[DIST_MS];
+    double band = fabs(sc->target) * SIM_SETTLE_BAND, dip = 0, ss = 0;
+    long recover = 0;
+    uint64_t sum = 0;
+
+    memset(tick_ns, 0, sizeof(tick_ns));
+    scenario_hook = disturb_Hook;
+    scenario_tick_ns = tick_ns;
+    double* y = run_scenario(sc, DIST_MS);
+    scenario_hook = NULL;
+    scenario_tick_ns = NULL;
+
+    //最大偏差、最后一次离开误差带到重新进入的时间、最后SIM_SS_WINDOW_MS的平均误差
+    for (uint32_t i = DIST_AT_MS; i < DIST_MS; i++) {
+        dip = fmax(dip, fabs(y[i] - sc->target));
+        if (fabs(y[i] - sc->target) > band)
+            recover = (long) (i - DIST_AT_MS + 1);
+    }
+    for (uint32_t i = DIST_MS - SIM_SS_WINDOW_MS; i < DIST_MS; i++)
+        ss += sc->target - y[i];
+    ss /= SIM_SS_WINDOW_MS;
+    free(y);
+
+    //第99百分位：外环每OUTER_DIV_DEFAULT个节拍执行一次，占全部节拍的10%，第99百分位落在内外环同时执行的节拍中，
+    //又不受主机上偶尔被调度打断的个别节拍影响
+    for (uint32_t i = 0; i < DIST_MS; i++)
+        sum += tick_ns[i];
+    qsort(tick_ns, DIST_MS, sizeof(tick_ns[0]), tick_Compare);
+    uint32_t worst = tick_ns[DIST_MS * 99 / 100];
+    double period_ns = 1e9 * (htim4.Init.Prescaler + 1) * (htim4.Init.Period + 1) / SystemCoreClock;
+    double headroom = 100 * (1 - (double) worst * SIM_TARGET_SLOWDOWN / period_ns);
+
+    int ok = recover <= recover_max && fabs(ss) <= band / 2 && headroom >= SIM_MIN_HEADROOM;
+    printf("{\"mode\":\"%s\",\"load_nm\":%g,\"dip\":%.2f,\"recover_ms\":%ld,\"ss_error\":%.4f,"
+           "\"tick_mean_ns\":%llu,\"tick_p99_ns\":%u,\"headroom_pct\":%.1f,\"ok\":%s}\n",
+           sc->name, DIST_LOAD, dip, recover, ss, (unsigned long long) (sum / DIST_MS), worst, headroom,
+           ok ? "true" : "false");
+    disturb_ok &= ok;
+}
+
+static int run_disturb(void) {
+    disturb_ok = 1;
+    //允许的恢复时间约为实测的1.5倍，阶跃响应的调节时间量级
+    disturb_Case(&scenarios[1], 400);       //Speed_Control
+    disturb_Case(&scenarios[2], 1000);      //Position_Control：1kHz速度内环 + 100Hz位置外环
+    return !disturb_ok;
+}
+
+//重新进入模式：运行中再次选择当前模式、停止后再打开，控制环不能带着之前的积分和上次输出继续
+#define RESTART_AT_MS       1000
+
+typedef enum {
+    RESTART_RESELECT,
+    RESTART_STOP_START
+}RestartWay;
+
+static RestartWay restart_way;
+static int restart_stale, restart_clean, restart_target;
+
+static int restart_Clean(const PID* pid) {
+    return pid->output_last == 0 && pid->error.last == 0 && pid->error.integral == 0 && pid->q.output_last == 0
+           && pid->q.error.last == 0 && pid->q.error.integral == 0;
+}
+
+static void restart_Hook(uint32_t ms) {
+    if (ms == RESTART_AT_MS) {
+        if (restart_way == RESTART_RESELECT) {
+            restart_stale = !restart_Clean(&vec_l);
+            mg513_SetMode(Speed_Control);
+        } else {
+            mg513_Stop();
+            restart_stale = !restart_Clean(&vec_l) && !restart_Clean(&ang_l);
+            mg513_Start();
+            restart_clean = restart_Clean(&vec_l) && restart_Clean(&ang_l);
+            restart_target = ang_l.target == 360;
+        }
+    }
+    //运行中重新选择：在下一个节拍边界复位，外环第一次执行之前状态为0
+    if (ms == RESTART_AT_MS + 1 && restart_way == RESTART_RESELECT)
+        restart_clean = restart_Clean(&vec_l);
+}
+
+static int run_restart(void) {
+    static const Scenario speed = {Speed_Control, "Speed_Control", 200, SIGNAL_LEFT_RPM, "rpm"};
+    static const Scenario position = {Position_Control, "Position_Control", 360, SIGNAL_LEFT_DEG, "deg"};
+    int ok, all = 1;
+
+    scenario_hook = restart_Hook;
+    restart_way = RESTART_RESELECT;
+    restart_stale = restart_clean = 0;
+    free(run_scenario(&speed, RESTART_AT_MS + 2));
+    ok = restart_stale && restart_clean;
+    printf("{\"case\":\"reselect while running\",\"stale\":%s,\"clean\":%s,\"ok\":%s}\n",
+           restart_stale ? "true" : "false", restart_clean ? "true" : "false", ok ? "true" : "false");
+    all &= ok;
+
+    //停止再打开：位置目标保留
+    restart_way = RESTART_STOP_START;
+    restart_stale = restart_clean = restart_target = 0;
+    free(run_scenario(&position, RESTART_AT_MS + 2));
+    ok = restart_stale && restart_clean && restart_target;
+    printf("{\"case\":\"stop and start\",\"stale\":%s,\"clean\":%s,\"ok\":%s}\n",
+           restart_stale ? "true" : "false", restart_clean ? "true" : "false", ok ? "true" : "false");
+    all &= ok;
+    scenario_hook = NULL;
+    return !all;
+}
+
+//菜单：回放输入事件，检查屏幕内容和刷新次数
+static uint8_t menu_saved[8][128];
+static int menu_ok;
+
+//屏幕上(X, Y)处是否显示指定文字：在显存上重画一遍，屏幕内容不变即为显示中
+static void screen_Begin(void) {
+    memcpy(menu_saved, OLED_DisplayBuf, sizeof(menu_saved));
+}
+
+static int screen_End(void) {
+    int same = memcmp(OLED_DisplayBuf, sim_oled, sizeof(sim_oled)) == 0;
+    memcpy(OLED_DisplayBuf, menu_saved, sizeof(menu_saved));
+    return same;
+}
+
+static int screen_Text(int16_t x, int16_t y, const char* text) {
+    screen_Begin();
+    OLED_ShowString(x, y, (char*) text, OLED_6X8);
+    return screen_End();
+}
+
+//模式页第0行反色显示的ON/OFF状态
+static int screen_Label(const char* text) {
+    screen_Begin();
+    OLED_ClearArea(14, 0, 21, 8);
+    OLED_ShowString(16, 0, (char*) text, OLED_6X8);
+    OLED_ReverseArea(14, -1, 21, 9);
+    return screen_End();
+}
+
+//光标在指定行，且其他行的指针位置为空（第14、15列属于模式页第0行的反色区，不检查）
+static int screen_Cursor(int8_t row) {
+    screen_Begin();
+    for (int8_t k = 0; k < 7; k++)
+        OLED_ClearArea(0, (int16_t) (k * 9), 14, 9);
+    OLED_ShowImage(0, (int16_t) (row * 9), 16, 9, This);
+    return screen_End();
+}
+
+//处理一个事件后检查刷新次数和屏幕内容，check在事件处理之后求值
+#define MENU_STEP(step, type, delta, flushes, check) do { \
+        MenuEvent event_ = {type, delta}; \
+        uint32_t before_ = Menu_GetFlushCount(); \
+        Menu_Handle(&event_); \
+        int ok_ = Menu_GetFlushCount() - before_ == (flushes) && sim_oled_errors == 0 && (check); \
+        printf("{\"step\":\"%s\",\"flushes\":%u,\"ok\":%s}\n", step, Menu_GetFlushCount() - before_, \
+               ok_ ? "true" : "false"); \
+        menu_ok &= ok_; \
+    } while (0)
+
+static int run_menu(void) {
+    menu_ok = 1;
+    sim_ResetPeripherals();
+    Menu_Init();
+    mg513_EncoderInit();
+    menu_ok &= screen_Text(16, 0, "Speed Control") && screen_Text(16, 54, "Diagnostics") && screen_Cursor(0);
+
+    //主页：光标移动和回绕，每个事件刷新一次
+    MENU_STEP("home down 2", MENU_EVENT_KNOB, 2, 1, screen_Cursor(2));
+    MENU_STEP("home up 3 wraps", MENU_EVENT_KNOB, -3, 1, screen_Cursor(6));
+    MENU_STEP("home down 1 wraps", MENU_EVENT_KNOB, 1, 1, screen_Cursor(0));
+    MENU_STEP("knob 0", MENU_EVENT_KNOB, 0, 0, screen_Cursor(0));
+    MENU_STEP("home refresh", MENU_EVENT_REFRESH, 0, 0, 1);
+    MENU_STEP("home on/off ignored", MENU_EVENT_ON_OFF, 0, 0, screen_Cursor(0));
+
+    //速度控制页：编辑目标速度
+    MENU_STEP("enter mode1", MENU_EVENT_OK, 0, 1,
+              screen_Label("OFF") && screen_Text(16, 9, "SetSpeed") && screen_Text(16, 18, "BACK") && screen_Cursor(1));
+    MENU_STEP("mode1 idle refresh", MENU_EVENT_REFRESH, 0, 0, 1);
+    MENU_STEP("edit speed", MENU_EVENT_OK, 0, 1, screen_Text(92, 9, "+0000"));
+    MENU_STEP("speed +3", MENU_EVENT_KNOB, 3, 1, screen_Text(92, 9, "+0030") && screen_Cursor(1));
+    MENU_STEP("speed -5", MENU_EVENT_KNOB, -5, 1, screen_Text(92, 9, "-0020"));
+    MENU_STEP("apply speed", MENU_EVENT_OK, 0, 1, vec_l.target == -20.0f && screen_Cursor(1));
+    MENU_STEP("edit again", MENU_EVENT_OK, 0, 1, screen_Text(92, 9, "-0020"));
+    MENU_STEP("speed clamps", MENU_EVENT_KNOB, 99, 1, screen_Text(92, 9, "+0500"));
+    MENU_STEP("apply clamped", MENU_EVENT_OK, 0, 1, vec_l.target == 500.0f);
+    MENU_STEP("motor on", MENU_EVENT_ON_OFF, 0, 1, screen_Label("ON.") && (htim4.Instance->CR1 & TIM_CR1_CEN));
+
+    //参数整定页：电机运行中修改kp，下一个控制节拍才生效；返回模式页不切换模式
+    MENU_STEP("open tune", MENU_EVENT_TUNE, 0, 1,
+              screen_Text(16, 0, "Loop") && screen_Text(98, 0, "vec_l") && screen_Text(86, 9, "+005.00")
+              && screen_Cursor(0) && (htim4.Instance->CR1 & TIM_CR1_CEN));
+    MENU_STEP("to kp", MENU_EVENT_KNOB, 1, 1, screen_Cursor(1));
+    MENU_STEP("edit kp", MENU_EVENT_OK, 0, 1, 1);
+    MENU_STEP("kp +3", MENU_EVENT_KNOB, 3, 1, screen_Text(86, 9, "+005.30") && vec_l.kp == 5.0f);
+    HAL_TIM_PeriodElapsedCallback(&htim4);
+    MENU_STEP("kp after tick", MENU_EVENT_REFRESH, 0, 0, fabsf(vec_l.kp - 5.3f) < 1e-4f);
+    MENU_STEP("kp done", MENU_EVENT_OK, 0, 1, screen_Cursor(1));
+    MENU_STEP("to loop", MENU_EVENT_KNOB, -1, 1, screen_Cursor(0));
+    MENU_STEP("edit loop", MENU_EVENT_OK, 0, 1, 1);
+    MENU_STEP("loop ang_l", MENU_EVENT_KNOB, 2, 1, screen_Text(98, 0, "ang_l"));
+    MENU_STEP("loop wraps", MENU_EVENT_KNOB, 2, 1, screen_Text(98, 0, "vec_l") && screen_Text(86, 9, "+005.30"));
+    MENU_STEP("loop done", MENU_EVENT_OK, 0, 1, screen_Cursor(0));
+    MENU_STEP("tune motor off", MENU_EVENT_ON_OFF, 0, 0,
+              !(htim4.Instance->CR1 & TIM_CR1_CEN) && screen_Text(16, 0, "Loop") && screen_Cursor(0));
+    MENU_STEP("tune back off", MENU_EVENT_KNOB, -1, 1, screen_Cursor(6));
+    MENU_STEP("mode1 shows off", MENU_EVENT_OK, 0, 1, screen_Label("OFF") && screen_Cursor(1));
+    MENU_STEP("reopen tune", MENU_EVENT_TUNE, 0, 1, screen_Text(98, 0, "vec_l"));
+    MENU_STEP("tune motor on", MENU_EVENT_ON_OFF, 0, 0,
+              (htim4.Instance->CR1 & TIM_CR1_CEN) && screen_Text(16, 0, "Loop"));
+    MENU_STEP("tune to back", MENU_EVENT_KNOB, -1, 1, screen_Cursor(6));
+    MENU_STEP("back to mode1", MENU_EVENT_OK, 0, 1,
+              screen_Label("ON.") && screen_Text(16, 9, "SetSpeed") && screen_Cursor(1)
+              && (htim4.Instance->CR1 & TIM_CR1_CEN) && fabsf(vec_l.kp - 5.3f) < 1e-4f);
+    MENU_STEP("mode1 tune again", MENU_EVENT_TUNE, 0, 1, screen_Text(86, 9, "+005.30"));
+    MENU_STEP("tune back", MENU_EVENT_KNOB, -1, 1, screen_Cursor(6));
+    MENU_STEP("back to mode1", MENU_EVENT_OK, 0, 1, screen_Cursor(1));
+    MENU_STEP("to back", MENU_EVENT_KNOB, 1, 1, screen_Cursor(2));
+    MENU_STEP("back home", MENU_EVENT_OK, 0, 1,
+              screen_Text(16, 0, "Speed Control") && screen_Cursor(0) && !(htim4.Instance->CR1 & TIM_CR1_CEN));
+
+    //位置曲线页：追加一条位置指令，队列占用变化时才重绘
+    MENU_STEP("to position curve", MENU_EVENT_KNOB, 5, 1, screen_Cursor(5));
+    MENU_STEP("enter mode6", MENU_EVENT_OK, 0, 1, screen_Text(16, 36, "Queue") && screen_Text(92, 36, "00"));
+    MENU_STEP("mode6 idle refresh", MENU_EVENT_REFRESH, 0, 0, 1);
+    MENU_STEP("edit angle", MENU_EVENT_OK, 0, 1, screen_Text(92, 9, "+000"));
+    MENU_STEP("angle +9", MENU_EVENT_KNOB, 9, 1, screen_Text(92, 9, "+090"));
+    MENU_STEP("queue angle", MENU_EVENT_OK, 0, 1, screen_Text(92, 36, "00"));
+    MENU_STEP("queue refresh", MENU_EVENT_REFRESH, 0, 1, screen_Text(92, 36, "01"));
+    MENU_STEP("queue refresh again", MENU_EVENT_REFRESH, 0, 0, 1);
+    MENU_STEP("to back", MENU_EVENT_KNOB, -1, 1, screen_Cursor(3));
+    MENU_STEP("back home", MENU_EVENT_OK, 0, 1, screen_Cursor(5));
+
+    //诊断页：统计不变时不刷新
+    MENU_STEP("home tune ignored", MENU_EVENT_TUNE, 0, 0, screen_Cursor(5));
+    MENU_STEP("to diagnostics", MENU_EVENT_KNOB, 1, 1, screen_Cursor(6));
+    MENU_STEP("enter mode7", MENU_EVENT_OK, 0, 1, screen_Text(16, 0, "Speed   ") && screen_Text(16, 27, "Min"));
+    MENU_STEP("mode7 idle refresh", MENU_EVENT_REFRESH, 0, 0, 1);
+    MENU_STEP("edit diag mode", MENU_EVENT_OK, 0, 1, 1);
+    MENU_STEP("diag mode +1", MENU_EVENT_KNOB, 1, 1, screen_Text(16, 0, "Position"));
+    MENU_STEP("diag mode -3 wraps", MENU_EVENT_KNOB, -3, 1, screen_Text(16, 0, "PosCurve"));
+    MENU_STEP("done", MENU_EVENT_OK, 0, 1, screen_Cursor(1));
+    MENU_STEP("to back", MENU_EVENT_KNOB, 1, 1, screen_Cursor(2));
+    MENU_STEP("back home", MENU_EVENT_OK, 0, 1, screen_Cursor(6));
+
+    //反复进出模式页：原实现每次返回主页都递归调用Menu()，栈最终溢出
+    MENU_STEP("to speed control", MENU_EVENT_KNOB, 1, 1, screen_Cursor(0));
+    uint32_t before = Menu_GetFlushCount();
+    for (int k = 0; k < 10000; k++) {
+        MenuEvent enter = {MENU_EVENT_OK, 0}, down = {MENU_EVENT_KNOB, 1}, back = {MENU_EVENT_OK, 0};
+        Menu_Handle(&enter);
+        Menu_Handle(&down);
+        Menu_Handle(&back);
+    }
+    int round_ok = Menu_GetFlushCount() - before == 30000 && screen_Cursor(0) && screen_Text(16, 0, "Speed Control");
+    printf("{\"step\":\"10000 round trips\",\"flushes\":%u,\"ok\":%s}\n", Menu_GetFlushCount() - before,
+           round_ok ? "true" : "false");
+    menu_ok &= round_ok;
+
+    //整定结果在再次进入该模式时保留
+    MENU_STEP("mode1 keeps tuned kp", MENU_EVENT_OK, 0, 1, screen_Cursor(1) && fabsf(vec_l.kp - 5.3f) < 1e-4f);
+    return !menu_ok;
+}
+
+//按键：向Key_OK（PB5）、Key_ON（PB3）输入带抖动的电平，检查消抖后产生的事件
+static int keys_ok;
+
+//引脚电平，低电平为按下
+static void keys_Level(uint16_t pin, int pressed) {
+    if (pressed)
+        sim_gpiob.IDR &= ~(uint32_t) pin;
+    else
+        sim_gpiob.IDR |= pin;
+}
+
+//保持当前电平ms毫秒，每毫秒一次SysTick；menu为1时主循环每毫秒调用一次Menu()
+static void keys_Hold(uint32_t ms, int menu) {
+    while (ms--) {
+        sim_cycles += SystemCoreClock / 1000;
+        key_Tick();
+        if (menu)
+            Menu();
+    }
+}
+
+//抖动ms毫秒：每毫秒随机电平，最后停在pressed
+static void keys_Bounce(uint16_t pin, uint32_t ms, int pressed) {
+    while (ms--) {
+        keys_Level(pin, ms == 0 ? pressed : rand() & 1);
+        keys_Hold(1, 0);
+    }
+}
+
+//取出全部事件，每个事件两个字符：键（o为OK，n为ON/OFF）、类型（P按下 R松开 L长按 T自动重复）
+static const char* keys_Collect(void) {
+    static char text[2 * KEY_QUEUE_SIZE + 1];
+    KeyEvent event;
+    int n = 0;
+
+    while (key_Read(&event)) {
+        text[n++] = event.key == KEY_OK ? 'o' : 'n';
+        text[n++] = "PRLT"[event.type];
+    }
+    text[n] = '\0';
+    return text;
+}
+
+static void keys_Check(const char* name, const char* events, const char* expected, int ok) {
+    ok = ok && strcmp(events, expected) == 0;
+    printf("{\"case\":\"%s\",\"events\":\"%s\",\"ok\":%s}\n", name, events, ok ? "true" : "false");
+    keys_ok &= ok;
+}
+
+static int run_keys(uint32_t iterations) {
+    const char* events;
+    int same;
+
+    keys_ok = 1;
+    sim_ResetPeripherals();
+    keys_Level(Key_OK_Pin, 0);
+    keys_Level(Key_ON_Pin, 0);
+    key_Init();
+    keys_Hold(100, 0);
+    keys_Check("idle", keys_Collect(), "", 1);
+
+    keys_Level(Key_OK_Pin, 1);
+    keys_Hold(100, 0);
+    keys_Level(Key_OK_Pin, 0);
+    keys_Hold(100, 0);
+    keys_Check("clean press", keys_Collect(), "oPoR", 1);
+
+    //按下、松开各抖动最多30ms（短于40ms的消抖窗口），每种随机抖动都只产生一次按下和一次松开
+    same = 1;
+    events = "";
+    for (uint32_t k = 0; k < iterations; k++) {
+        srand(k);
+        keys_Bounce(Key_OK_Pin, 1 + k % 30, 1);
+        keys_Hold(60 + k % 200, 0);
+        keys_Bounce(Key_OK_Pin, 1 + (k * 7) % 30, 0);
+        keys_Hold(60, 0);
+        events = keys_Collect();
+        if (strcmp(events, "oPoR") != 0) {
+            same = 0;
+            break;
+        }
+    }
+    keys_Check("bouncy press", events, "oPoR", same);
+
+    //短于消抖窗口的干扰脉冲不产生事件
+    same = 1;
+    for (uint32_t k = 0; k < iterations && same; k++) {
+        srand(k);
+        keys_Level(Key_ON_Pin, 1);
+        keys_Hold(1 + k % 30, 0);
+        keys_Bounce(Key_ON_Pin, 1 + (k * 3) % 5, 0);
+        keys_Hold(60, 0);
+        same = key_Read(&(KeyEvent) {0}) == 0;
+    }
+    keys_Check("glitch", "", "", same);
+
+    //按住1.5s：确认按下后800ms长按，此后每200ms一次自动重复
+    keys_Bounce(Key_OK_Pin, 10, 1);
+    keys_Hold(1500, 0);
+    keys_Bounce(Key_OK_Pin, 10, 0);
+    keys_Hold(60, 0);
+    keys_Check("long hold", keys_Collect(), "oPoLoToToToR", 1);
+
+    //两个键互不影响
+    keys_Level(Key_OK_Pin, 1);
+    keys_Hold(100, 0);
+    keys_Level(Key_ON_Pin, 1);
+    keys_Hold(100, 0);
+    keys_Level(Key_ON_Pin, 0);
+    keys_Hold(100, 0);
+    keys_Level(Key_OK_Pin, 0);
+    keys_Hold(100, 0);
+    keys_Check("both keys", keys_Collect(), "oPnPnRoR", 1);
+
+    //主循环不取事件时队列满，丢弃新事件，已入队的事件不受影响
+    for (int k = 0; k < 20; k++) {
+        keys_Level(Key_ON_Pin, 1);
+        keys_Hold(50, 0);
+        keys_Level(Key_ON_Pin, 0);
+        keys_Hold(50, 0);
+    }
+    keys_Check("queue full", keys_Collect(), "nPnRnPnRnPnRnPnRnPnRnPnRnPnRnPnR", key_Dropped() == 24);
+
+    //菜单：OK松开时才进入模式页，按住期间主循环照常运行；ON/OFF按下即启动电机
+    sim_ResetPeripherals();
+    keys_Level(Key_OK_Pin, 0);
+    keys_Level(Key_ON_Pin, 0);
+    Menu_Init();
+    mg513_EncoderInit();
+    uint32_t before = Menu_GetFlushCount();
+    keys_Bounce(Key_OK_Pin, 15, 1);
+    keys_Hold(300, 1);
+    same = Menu_GetFlushCount() - before == 0;
+    keys_Bounce(Key_OK_Pin, 15, 0);
+    keys_Hold(100, 1);
+    same = same && Menu_GetFlushCount() - before == 1 && screen_Label("OFF") && screen_Cursor(1);
+    keys_Bounce(Key_ON_Pin, 15, 1);
+    keys_Hold(100, 1);
+    keys_Bounce(Key_ON_Pin, 15, 0);
+    keys_Hold(100, 1);
+    same = same && Menu_GetFlushCount() - before == 2 && screen_Label("ON.") && (htim4.Instance->CR1 & TIM_CR1_CEN);
+    keys_Check("menu", "", "", same);
+
+    //菜单：模式页长按OK打开参数整定页，继续按住的自动重复和松开都不再算OK
+    before = Menu_GetFlushCount();
+    keys_Bounce(Key_OK_Pin, 15, 1);
+    keys_Hold(2000, 1);
+    keys_Bounce(Key_OK_Pin, 15, 0);
+    keys_Hold(100, 1);
+    same = Menu_GetFlushCount() - before == 1 && screen_Text(16, 0, "Loop") && screen_Cursor(0)
+           && (htim4.Instance->CR1 & TIM_CR1_CEN);
+    keys_Check("menu long", "", "", same);
+
+    return !keys_ok;
+}
+
+//旋钮：按格雷码序列改变Encoder_A（PB13）、Encoder_B（PB15）电平，每次电平变化调用一次knob_Edge（双边沿中断）
+static int knob_ok;
+static uint8_t knob_phase;                  //当前AB相状态 A << 1 | B
+
+static void knob_Pins(uint8_t phase) {
+    sim_gpiob.IDR = (sim_gpiob.IDR & ~(uint32_t) (Encoder_A_Pin | Encoder_B_Pin))
+                    | ((phase & 2) ? Encoder_A_Pin : 0) | ((phase & 1) ? Encoder_B_Pin : 0);
+    knob_phase = phase;
+}
+
+//转动detents格（负数逆时针），两格间隔gap_ms；bounce为每次变化前变化的那一相随机抖动的最多次数
+static void knob_Turn(int32_t detents, uint32_t gap_ms, uint32_t bounce) {
+    static const uint8_t next_cw[4] = {2, 0, 3, 1};     //00 -> 10 -> 11 -> 01 -> 00
+    static const uint8_t next_ccw[4] = {1, 3, 0, 2};
+    uint32_t quarters = (uint32_t) (detents < 0 ? -detents : detents) * KNOB_STEPS_PER_DETENT;
+
+    while (quarters--) {
+        uint8_t target = detents > 0 ? next_cw[knob_phase] : next_ccw[knob_phase];
+        uint8_t from = knob_phase;
+        uint32_t chatter = bounce ? (uint32_t) rand() % (bounce + 1) : 0;
+        for (uint32_t k = 0; k < chatter; k++) {
+            knob_Pins(k & 1 ? from : target);
+            knob_Edge();
+        }
+        knob_Pins(target);
+        knob_Edge();
+        sim_cycles += (uint64_t) gap_ms * (SystemCoreClock / 1000) / KNOB_STEPS_PER_DETENT;
+    }
+}
+
+static void knob_Idle(uint32_t ms) {
+    sim_cycles += (uint64_t) ms * (SystemCoreClock / 1000);
+}
+
+static void knob_Check(const char* name, KnobDelta delta, int16_t detents, int16_t steps, int ok) {
+    ok = ok && delta.detents == detents && delta.steps == steps;
+    printf("{\"case\":\"%s\",\"detents\":%d,\"steps\":%d,\"invalid\":%u,\"ok\":%s}\n", name, delta.detents,
+           delta.steps, knob_Invalid(), ok ? "true" : "false");
+    knob_ok &= ok;
+}
+
+static int run_knob(uint32_t iterations) {
+    KnobDelta delta = {0, 0};
+    int same;
+
+    knob_ok = 1;
+    sim_ResetPeripherals();
+    knob_Pins(3);
+    knob_Init();
+
+    knob_Idle(500);
+    knob_Turn(10, 200, 0);
+    knob_Check("cw 10 slow", knob_Read(), 10, 10, 1);
+    knob_Check("read clears", knob_Read(), 0, 0, 1);
+    knob_Idle(500);
+    knob_Turn(-7, 200, 0);
+    knob_Check("ccw 7 slow", knob_Read(), -7, -7, 1);
+
+    //转到半格后退回：不计数
+    knob_Pins(2);
+    knob_Edge();
+    knob_Pins(0);
+    knob_Edge();
+    knob_Pins(2);
+    knob_Edge();
+    knob_Pins(3);
+    knob_Edge();
+    knob_Check("half and back", knob_Read(), 0, 0, knob_Invalid() == 0);
+
+    //每次电平变化前随机抖动：格数与方向都不能错
+    same = 1;
+    for (uint32_t k = 0; k < iterations && same; k++) {
+        srand(k);
+        int32_t n = 1 + (int32_t) (k % 5);
+        if (k & 1)
+            n = -n;
+        knob_Idle(500);
+        knob_Turn(n, 200, 1 + k % 8);
+        delta = knob_Read();
+        same = delta.detents == n && delta.steps == n && knob_Invalid() == 0;
+    }
+    knob_Check("bouncy edges", delta, delta.detents, delta.steps, same);
+
+    //漏掉一次中断：AB同时变化（11 -> 00）被丢弃，不会反向计数，之后的格照常计数
+    knob_Idle(500);
+    knob_Turn(1, 200, 0);
+    knob_Pins(0);
+    knob_Edge();
+    knob_Turn(3, 200, 0);
+    knob_Check("missed edge", knob_Read(), 4, 4, knob_Invalid() == 1);
+    knob_Pins(3);
+    knob_Init();
+
+    //加速：第一格距上一格很久倍率为1，此后按间隔加速
+    knob_Idle(500);
+    knob_Turn(10, 20, 0);
+    knob_Check("fast spin", knob_Read(), 10, 1 + 9 * KNOB_FAST_GAIN, 1);
+    knob_Idle(500);
+    knob_Turn(-10, 60, 0);
+    knob_Check("medium spin", knob_Read(), -10, -(1 + 9 * KNOB_MEDIUM_GAIN), 1);
+
+    //菜单：移动光标按实际格数，编辑数值按加速后的格数
+    sim_ResetPeripherals();
+    sim_gpiob.IDR |= Key_OK_Pin | Key_ON_Pin;
+    knob_Pins(3);
+    Menu_Init();
+    mg513_EncoderInit();
+    knob_Idle(500);
+    knob_Turn(7, 20, 0);
+    Menu();
+    same = screen_Cursor(0);
+    MenuEvent ok = {MENU_EVENT_OK, 0};
+    Menu_Handle(&ok);
+    Menu_Handle(&ok);
+    knob_Idle(500);
+    knob_Turn(10, 20, 0);
+    Menu();
+    same = same && screen_Text(92, 9, "+0460");
+    knob_Check("menu", knob_Read(), 0, 0, same);
+
+    return !knob_ok;
+}
+
+//堆占用：glibc已分配字节数
+int32_t bench_HeapUsed(void) {
+    return (int32_t) mallinfo2().uordblks;
+}
+
+//在基准文件中查找函数的ns基准，没有返回0
+static float bench_Baseline(FILE* file, const char* name) {
+    char line[128], key[64];
+    float ns;
+
+    if (file == NULL)
+        return 0;
+    rewind(file);
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "%63s %f", key, &ns) == 2 && strcmp(key, name) == 0)
+            return ns;
+    }
+    return 0;
+}
+
+//中值滤波：与逐次排序的参考实现比较，参考实现只保留最近FILTER_SIZE个有限样本
+static int filter_ok;
+
+typedef struct {
+    float buf[FILTER_SIZE];
+    uint8_t count, index;
+}MedianRef;
+
+static float median_Ref(MedianRef* r, float x) {
+    float s[FILTER_SIZE];
+
+    if (isfinite(x)) {
+        r->buf[r->index] = x;
+        r->index = (uint8_t) ((r->index + 1) % FILTER_SIZE);
+        if (r->count < FILTER_SIZE)
+            r->count++;
+    }
+    if (r->count == 0)
+        return 0;
+    for (uint8_t k = 0; k < r->count; k++) {
+        uint8_t i = k;
+        while (i > 0 && s[i - 1] > r->buf[k]) {
+            s[i] = s[i - 1];
+            i--;
+        }
+        s[i] = r->buf[k];
+    }
+    return s[r->count / 2];
+}
+
+//随机输入，nonfinite为每个样本是NaN/Inf的概率（百分比）；corrupt非0时每隔corrupt个样本把有序数组改写为NaN
+static void filter_Case(const char* name, uint32_t samples, int nonfinite, uint32_t corrupt) {
+    static const float bad[] = {NAN, INFINITY, -INFINITY};
+    Median f;
+    MedianRef r = {{0}, 0, 0};
+    uint32_t mismatches = 0;
+
+    initMedian(&f);
+    for (uint32_t k = 0; k < samples; k++) {
+        float x = (float) (rand() % 200 - 100) * 0.5f;
+        if (rand() % 100 < nonfinite)
+            x = bad[rand() % 3];
+        if (corrupt && k % corrupt == corrupt - 1 && f.count == FILTER_SIZE) {
+            for (uint8_t i = 0; i < FILTER_SIZE; i++)
+                f.sorted[i] = NAN;
+        }
+        if (updateMedian(&f, x) != median_Ref(&r, x))
+            mismatches++;
+    }
+    printf("{\"case\":\"%s\",\"samples\":%u,\"mismatches\":%u,\"ok\":%s}\n", name, samples, mismatches,
+           mismatches == 0 ? "true" : "false");
+    filter_ok &= mismatches == 0;
+}
+
+static int run_filter(uint32_t iterations) {
+    filter_ok = 1;
+    srand(1);
+    filter_Case("finite", iterations, 0, 0);
+    filter_Case("nan inf", iterations, 10, 0);
+    filter_Case("all nan", 100, 100, 0);
+    filter_Case("corrupted sorted", iterations, 0, 97);
+    return !filter_ok;
+}
+
+//遥测回环：帧经环形缓冲和模拟DMA发出，字节流加入误码、丢字节、插入杂散字节后送入上位机解码器
+#define LOOP_FRAMES         200             //突发前后各发送的帧数
+#define LOOP_BURST          40              //不等DMA完成连续发送的帧数，超出缓冲区的部分丢弃
+#define LOOP_MAX_SEQ        (2 * LOOP_FRAMES + LOOP_BURST)
+#define LOOP_ERRORS         5               //DMA发送出错次数，每次出错前不等DMA完成连续发送LOOP_ERROR_FRAMES帧
+#define LOOP_ERROR_FRAMES   7
+
+static int loop_ok;
+static uint16_t loop_k;                     //下一帧的序号，与telemetry_Init后的帧序号一致
+
+//第k帧的通道数据，解码后按序号核对
+static void loop_Channels(uint16_t k, float* ch) {
+    ch[0] = (float) k;
+    ch[1] = (float) k * 0.5f;
+    ch[2] = -(float) k;
+}
+
+static void loop_Send(uint32_t n, int service) {
+    float ch[TELEMETRY_CHANNELS];
+
+    for (uint32_t i = 0; i < n; i++) {
+        loop_Channels(loop_k++, ch);
+        telemetry_Send(Speed_Control, ch, TELEMETRY_CHANNELS);
+        if (service)
+            sim_UartService();
+    }
+}
+
+//bytes解码，检查帧数、丢帧数、每帧内容；crc_min为至少应有的CRC错误次数
+static void loop_Decode(const char* name, const uint8_t* bytes, size_t len, unsigned long frames,
+                        unsigned long lost, unsigned long crc_min) {
+    TelemetryDecoder d;
+    TelemetryFrame frame;
+    float ch[TELEMETRY_CHANNELS], got[TELEMETRY_CHANNELS];
+    int ok = 1, last = -1;
+
+    decoder_Init(&d);
+    for (size_t i = 0; i < len; i++) {
+        if (!decoder_Feed(&d, bytes[i], &frame))
+            continue;
+        loop_Channels(frame.seq, ch);
+        memcpy(got, frame.ch, sizeof(got));
+        ok &= frame.seq > last && frame.mode == Speed_Control && frame.count == TELEMETRY_CHANNELS
+              && memcmp(ch, got, sizeof(ch)) == 0;
+        last = frame.seq;
+    }
+    ok &= d.frames == frames && d.lost == lost && d.crc_errors >= crc_min;
+    printf("{\"case\":\"%s\",\"frames\":%lu,\"lost\":%lu,\"crc_errors\":%lu,\"ok\":%s}\n", name, d.frames,
+           d.lost, d.crc_errors, ok ? "true" : "false");
+    loop_ok &= ok;
+}
+
+//DMA发送出错：出错的一段连同首尾被截断的帧丢弃并计入丢帧，之后继续发送
+//上一段发出的半帧留在字节流中，解码器应重新同步，丢帧数仍由序号间隔完整统计
+static void loop_DmaError(void) {
+    FILE* saved = sim_telemetry;
+    static uint8_t bytes[LOOP_MAX_SEQ * sizeof(TelemetryFrame)];
+    size_t len;
+    uint32_t dropped;
+
+    if ((sim_telemetry = tmpfile()) == NULL) {
+        perror("tmpfile");
+        loop_ok = 0;
+        return;
+    }
+    sim_ResetPeripherals();
+    telemetry_Init();
+    loop_k = 0;
+    loop_Send(LOOP_FRAMES, 1);
+    for (int i = 0; i < LOOP_ERRORS; i++) {
+        loop_Send(LOOP_ERROR_FRAMES, 0);
+        sim_UartError();
+    }
+    loop_Send(LOOP_FRAMES, 1);
+    sim_UartService();
+    dropped = telemetry_Dropped();
+
+    rewind(sim_telemetry);
+    len = fread(bytes, 1, sizeof(bytes), sim_telemetry);
+    fclose(sim_telemetry);
+    sim_telemetry = saved;
+
+    loop_ok &= dropped >= LOOP_ERRORS;
+    loop_Decode("dma error", bytes, len, loop_k - dropped, dropped, 0);
+}
+
+static int run_telemetry(void) {
+    FILE* saved = sim_telemetry;
+    static uint8_t bytes[LOOP_MAX_SEQ * sizeof(TelemetryFrame)];
+    static uint8_t bad[LOOP_MAX_SEQ * sizeof(TelemetryFrame) * 2];
+    size_t len, n = 0;
+    uint32_t dropped;
+    unsigned long flipped = 0, removed = 0, inserted = 0;
+    const size_t size = sizeof(TelemetryFrame);
+
+    loop_ok = 1;
+    if ((sim_telemetry = tmpfile()) == NULL) {
+        perror("tmpfile");
+        return 1;
+    }
+    sim_ResetPeripherals();
+    telemetry_Init();
+    loop_k = 0;
+    loop_Send(LOOP_FRAMES, 1);
+    loop_Send(LOOP_BURST, 0);
+    for (int i = 0; i < LOOP_BURST; i++)
+        sim_UartService();
+    loop_Send(LOOP_FRAMES, 1);
+    sim_UartService();
+    dropped = telemetry_Dropped();
+
+    rewind(sim_telemetry);
+    len = fread(bytes, 1, sizeof(bytes), sim_telemetry);
+    fclose(sim_telemetry);
+    sim_telemetry = saved;
+
+    //突发中缓冲区放得下的帧发出，其余丢弃（DMA分段发送时可能还占着一部分），序号间隔即为丢弃的帧数
+    loop_ok &= dropped > 0 && dropped < LOOP_BURST && len % size == 0;
+    loop_Decode("clean", bytes, len, len / size, dropped, 0);
+
+    //逐帧改写字节流：数据位翻转（CRC拒收）、丢一个字节、帧前插入以帧头开始的杂散字节（不应丢帧）
+    //首尾两帧不改，丢帧数可由序号间隔完整统计
+    for (size_t f = 0; f < len / size; f++) {
+        const uint8_t* src = bytes + f * size;
+        if (f > 0 && f + 1 < len / size && f % 17 == 5) {
+            memcpy(bad + n, src, size);
+            bad[n + 8 + f % 14] ^= (uint8_t) (1u << (f % 8));
+            n += size;
+            flipped++;
+        } else if (f > 0 && f + 1 < len / size && f % 17 == 11) {
+            size_t skip = f % size;
+            memcpy(bad + n, src, skip);
+            memcpy(bad + n + skip, src + skip + 1, size - skip - 1);
+            n += size - 1;
+            removed++;
+        } else if (f > 0 && f % 17 == 14) {
+            bad[n++] = TELEMETRY_HEAD0;
+            bad[n++] = TELEMETRY_HEAD1;
+            bad[n++] = (uint8_t) f;
+            memcpy(bad + n, src, size);
+            n += size;
+            inserted++;
+        } else {
+            memcpy(bad + n, src, size);
+            n += size;
+        }
+    }
+    loop_Decode("corrupted", bad, n, len / size - flipped - removed, dropped + flipped + removed,
+                flipped + inserted);
+    loop_DmaError();
+    return !loop_ok;
+}
+
+//S曲线查表：与解析的s(x) = 1 / (1 + exp(-x))比较，允许误差按pid.h中的插值误差估计
+#define CURVE_TOL           ((2 * CURVE_TABLE_RANGE / CURVE_TABLE_SIZE) * (2 * CURVE_TABLE_RANGE / CURVE_TABLE_SIZE) / 80)
+
+static int curve_ok;
+
+static double curve_Sigmoid(double x) {
+    return 1.0 / (1.0 + exp(-x));
+}
+
+//err为与解析值之差的最大值，bound为允许误差
+static void curve_Check(const char* name, uint32_t points, double err, double bound) {
+    int ok = err <= bound;
+    printf("{\"case\":\"%s\",\"points\":%u,\"max_err\":%.3g,\"bound\":%.3g,\"ok\":%s}\n", name, points, err,
+           bound, ok ? "true" : "false");
+    curve_ok &= ok;
+}
+
+static int run_curve(void) {
+    Curve c;
+    double err = 0;
+    uint32_t n = 0;
+
+    curve_ok = 1;
+    initCurveTable();
+
+    //查表本身：覆盖表的范围和范围之外（取端点值）
+    for (double x = -CURVE_TABLE_RANGE - 4; x <= CURVE_TABLE_RANGE + 4; x += 1e-3, n++)
+        err = fmax(err, fabs(sigmoidLookup((float) x) - curve_Sigmoid(x)));
+    curve_Check("sigmoid table", n, err, CURVE_TOL);
+
+    //速度曲线：每个节拍与用exp计算的同一条曲线比较，误差按幅值放大；最后到达目标
+    memset(&c, 0, sizeof(c));
+    setCurve(&c, 0, 200, 1, 380);
+    err = 0;
+    n = 0;
+    do {
+        VelocityCurve(&c);
+        if (c.maxTimes != 0) {
+            double t = (double) c.aTimes - 1 - c.maxTimes * 0.5;
+            err = fmax(err, fabs(c.current - (c.A * curve_Sigmoid(c.B * t) + c.C)) / fabs(c.A));
+        }
+        n++;
+    } while (c.maxTimes != 0 && n < 100000);
+    curve_Check("velocity curve", n, c.current == c.target ? err : 1, CURVE_TOL + 1e-6);
+
+    //位置曲线：加速、减速段查表，中间段为直线
+    memset(&c, 0, sizeof(c));
+    setCurve(&c, 0, 3600, 0, 2);
+    err = 0;
+    n = 0;
+    do {
+        PositionCurve(&c);
+        if (c.maxTimes != 0) {
+            double t = (double) c.aTimes - 1, ref;
+            if (t <= c.C)
+                ref = c.A * curve_Sigmoid(c.B * (t - c.C)) + c.D;
+            else if (t >= c.maxTimes - c.C)
+                ref = c.A * curve_Sigmoid(c.B * (t - c.maxTimes + c.C)) + c.target - c.A * 0.5;
+            else
+                ref = c.Max * (t - c.C) + c.A * 0.5;
+            err = fmax(err, fabs(c.current - ref) / fabs(c.A));
+        }
+        n++;
+    } while (c.maxTimes != 0 && n < 100000);
+    curve_Check("position curve", n, err, CURVE_TOL + 1e-6);
+
+    return !curve_ok;
+}
+
+//编码器：M/T测速输入合成的边沿时刻序列，每1ms采样一次，检查估计值
+//参数与MG513相同：4倍频、减速比28、13线，每个A相边沿2个计数
+#define MT_CYCLES_PER_MS    72000
+#define MT_COUNT_TO_RPM     (60000.0f / (4 * 28 * 13))
+#define MT_EDGE_COUNTS      2.0f
+
+static int encoder_ok;
+
+//合成的编码器：time为DWT周期（64位，取低32位即为CYCCNT），phase为到下一个边沿的计数进度
+typedef struct {
+    EdgeTimer edge;
+    uint64_t time;
+    uint16_t count;
+    double phase;
+    float v;                            //估计值  rpm
+    uint8_t measuring;                  //1：起点之后已有边沿，估计值为测量结果
+}MtSim;
+
+//以rpm匀速转动ms毫秒（负数反转），每1ms估计一次；tol>0时每次估计都要在rpm的±tol之内（起点之后的边沿开始）
+static int mt_Run(MtSim* m, float rpm, uint32_t ms, float tol) {
+    double counts_per_cycle = rpm / MT_COUNT_TO_RPM / MT_CYCLES_PER_MS;
+    int ok = 1;
+
+    for (uint32_t k = 0; k < ms; k++) {
+        uint64_t end = m->time + MT_CYCLES_PER_MS;
+        if (counts_per_cycle != 0) {
+            //本毫秒内的边沿：每走过MT_EDGE_COUNTS个计数一个
+            double step = MT_EDGE_COUNTS / fabs(counts_per_cycle);
+            while (m->time + (uint64_t) ((1 - m->phase) * step) < end) {
+                m->time += (uint64_t) ((1 - m->phase) * step);
+                m->phase = 0;
+                m->count += (uint16_t) (int16_t) (rpm > 0 ? MT_EDGE_COUNTS : -MT_EDGE_COUNTS);
+                m->edge.edge_time = (uint32_t) m->time;
+                m->edge.edge_count = m->count;
+                m->edge.edge_seq++;
+            }
+            m->phase += (double) (end - m->time) / step;
+        }
+        m->time = end;
+        uint8_t primed = m->edge.primed;
+        uint16_t seq = m->edge.last_seq;
+        m->v = estimateVelocity(&m->edge, (uint32_t) m->time, MT_COUNT_TO_RPM, MT_CYCLES_PER_MS, MT_EDGE_COUNTS,
+                                m->v);
+        m->measuring = m->edge.primed && (m->measuring || (primed && m->edge.last_seq != seq));
+        if (tol > 0 && m->measuring && fabsf(m->v - rpm) > tol)
+            ok = 0;
+    }
+    return ok;
+}
+
+static void mt_Init(MtSim* m, uint64_t time) {
+    memset(m, 0, sizeof(*m));
+    m->time = time;
+    m->edge.last_seq = m->edge.edge_seq;
+}
+
+static void encoder_Check(const char* name, float v, int ok) {
+    printf("{\"case\":\"%s\",\"v\":%.3f,\"ok\":%s}\n", name, v, ok ? "true" : "false");
+    encoder_ok &= ok;
+}
+
+//编码器溢出：读64位计数的同时计数器回绕，更新中断可能在任意两次寄存器访问之间执行（主循环读），
+//或者在读完之后才执行（同优先级的控制中断里读，读的时候UIF挂起）
+#define RACE_READS          200000
+#define RACE_MAX_STEP       40              //两次寄存器访问之间最多走过的计数，远小于半圈，不会连续回绕两次
+
+static Encoder race_ecd;
+static int64_t race_pos;                    //实际位置  计数
+static int race_dir;
+static uint8_t race_preempt;                //1：更新中断可以打断读
+static uint8_t race_in_isr;
+
+//更新中断：与HAL_TIM_IRQHandler相同，先清UIF再调用回调
+static void race_Isr(void) {
+    race_in_isr = 1;
+    htim2.Instance->SR &= ~(uint32_t) TIM_FLAG_UPDATE;
+    encoderOverflow(&race_ecd);
+    race_in_isr = 0;
+}
+
+//走到实际位置next，CNT = 实际位置 + 零点，跨越0/65535时置UIF
+static void race_Move(TIM_TypeDef* tim, int64_t next) {
+    int64_t raw = race_pos + ENCODER_COUNT_ORIGIN;
+    if (((next + ENCODER_COUNT_ORIGIN) >> 16) != (raw >> 16))
+        tim->SR |= TIM_FLAG_UPDATE;
+    race_pos = next;
+    tim->CNT = (uint16_t) (next + ENCODER_COUNT_ORIGIN);
+}
+
+//每次读CNT、SR之前：编码器走过0~RACE_MAX_STEP个计数，跨越0/65535时置UIF；可打断时随机执行挂起的中断
+static void race_Hook(TIM_TypeDef* tim) {
+    if (tim != htim2.Instance || race_in_isr)
+        return;
+    race_Move(tim, race_pos + race_dir * (rand() % (RACE_MAX_STEP + 1)));
+    if (race_preempt && (tim->SR & TIM_FLAG_UPDATE) && rand() % 2)
+        race_Isr();
+}
+
+//从start开始按dir方向转动，反复读encoderCount64：读数在读之前和读之后的实际位置之间，并且单调
+static void race_Case(const char* name, int64_t start, int dir, uint8_t preempt) {
+    int64_t last = start, count = start;
+    int ok = 1;
+
+    sim_ResetPeripherals();
+    initEncoder(&race_ecd, (Parameter) {4, 13, 28, 0.065f, &htim2});
+    race_ecd.counter.count_overflow = (int32_t) ((start + ENCODER_COUNT_ORIGIN) >> 16);
+    htim2.Instance->CNT = (uint16_t) (start + ENCODER_COUNT_ORIGIN);
+    htim2.Instance->SR = 0;
+    race_pos = start;
+    race_dir = dir;
+    race_preempt = preempt;
+    sim_tim_hook = race_Hook;
+
+    for (uint32_t k = 0; k < RACE_READS; k++) {
+        int64_t before = race_pos;
+        count = encoderCount64(&race_ecd);
+        int64_t after = race_pos;
+        if (dir > 0 ? (count < before || count > after || count < last)
+                    : (count > before || count < after || count > last))
+            ok = 0;
+        last = count;
+        //读完后执行挂起的中断
+        if (htim2.Instance->SR & TIM_FLAG_UPDATE)
+            race_Isr();
+    }
+    sim_tim_hook = NULL;
+    ok &= encoderCount64(&race_ecd) == race_pos;
+    printf("{\"case\":\"%s\",\"reads\":%d,\"count\":%lld,\"ok\":%s}\n", name, RACE_READS, (long long) count,
+           ok ? "true" : "false");
+    encoder_ok &= ok;
+}
+
+//停在零点附近抖动：每次读之前位置随机落在-RACE_DITHER~RACE_DITHER，在控制中断里读，
+//更新中断被推迟，每RACE_DITHER_ISR次读才执行一次
+#define RACE_DITHER         3
+#define RACE_DITHER_ISR     16
+
+static void race_Dither(const char* name) {
+    int64_t count = 0;
+    int ok = 1;
+
+    sim_ResetPeripherals();
+    initEncoder(&race_ecd, (Parameter) {4, 13, 28, 0.065f, &htim2});
+    restEncoder(&race_ecd);
+    race_pos = 0;
+    race_dir = 0;
+    race_preempt = 0;
+
+    for (uint32_t k = 0; k < RACE_READS; k++) {
+        race_Move(htim2.Instance, rand() % (2 * RACE_DITHER + 1) - RACE_DITHER);
+        count = encoderCount64(&race_ecd);
+        if (count != race_pos)
+            ok = 0;
+        if (k % RACE_DITHER_ISR == 0 && (htim2.Instance->SR & TIM_FLAG_UPDATE))
+            race_Isr();
+    }
+    ok &= race_ecd.counter.count_overflow == 0;
+    printf("{\"case\":\"%s\",\"reads\":%d,\"count\":%lld,\"ok\":%s}\n", name, RACE_READS, (long long) count,
+           ok ? "true" : "false");
+    encoder_ok &= ok;
+}
+
+static int run_encoder(void) {
+    MtSim m;
+    int ok;
+
+    encoder_ok = 1;
+
+    //匀速：第一个边沿只作为起点，此后每次估计误差在0.5%以内
+    mt_Init(&m, 0);
+    ok = mt_Run(&m, 200, 5, 0) && mt_Run(&m, 200, 500, 1.0f);
+    encoder_Check("200 rpm", m.v, ok);
+
+    //极低速：边沿间隔约82ms，远大于采样周期，边沿之间保持上次估计
+    mt_Init(&m, 0);
+    ok = mt_Run(&m, 1, 200, 0) && mt_Run(&m, 1, 2000, 0.01f);
+    encoder_Check("1 rpm", m.v, ok);
+
+    //采样间隔内没有边沿：估计值不超过“一个边沿间隔/距上个边沿的时间”，单调收敛，1s后为0
+    mt_Init(&m, 0);
+    mt_Run(&m, 200, 100, 0);
+    ok = 1;
+    for (uint32_t k = 1; k <= 1100; k++) {
+        float last = m.v;
+        mt_Run(&m, 0, 1, 0);
+        float bound = MT_EDGE_COUNTS * MT_COUNT_TO_RPM * MT_CYCLES_PER_MS
+                      / (float) ((uint32_t) m.time - m.edge.last_time);
+        ok &= m.v <= last && (k > 1000 ? m.v == 0 : m.v <= bound * 1.0001f);
+    }
+    encoder_Check("no edges", m.v, ok);
+
+    //停转1s后再转：第一个边沿只作为起点，不会按1s以上的时间差算出错误速度
+    ok = mt_Run(&m, 50, 2, 0) && m.v == 0 && mt_Run(&m, 50, 300, 0.5f);
+    encoder_Check("restart after timeout", m.v, ok);
+
+    //restEncoder清零计数器后、下一个边沿之前测速：清零前记录的边沿不能作为起点，否则计数差为清零前后之差
+    Encoder ecd;
+    sim_ResetPeripherals();
+    initEncoder(&ecd, (Parameter) {4, 13, 28, 0.065f, &htim2});
+    mt_Init(&m, 0);
+    m.count = 30000;
+    mt_Run(&m, 200, 100, 0);
+    ecd.edge = m.edge;
+    restEncoder(&ecd);
+    m.edge = ecd.edge;
+    m.count = 0;
+    m.measuring = 0;
+    ok = mt_Run(&m, 0, 1, 0) && m.v == 0 && mt_Run(&m, 200, 100, 1.0f);
+    encoder_Check("reset", m.v, ok);
+
+    //反转：换向后几个采样内符号正确，随后收敛到-200rpm
+    mt_Init(&m, 0);
+    mt_Run(&m, 200, 200, 0);
+    mt_Run(&m, -200, 3, 0);
+    ok = m.v < 0 && mt_Run(&m, -200, 300, 1.0f);
+    encoder_Check("reversal", m.v, ok);
+
+    //CYCCNT回绕：跨越0xFFFFFFFF匀速转动，估计值不受影响
+    mt_Init(&m, 0xFFFFFFFFull - 50 * MT_CYCLES_PER_MS);
+    ok = mt_Run(&m, 200, 5, 0) && mt_Run(&m, 200, 200, 1.0f);
+    encoder_Check("cyccnt wrap", m.v, ok);
+
+    //停转超过一次回绕（约59.6s）后再转：时间差按32位计算会显得很短，不能因此算出高速
+    mt_Run(&m, 0, 60000, 0);
+    ok = m.v == 0 && mt_Run(&m, 20, 2, 0) && m.v == 0 && mt_Run(&m, 20, 500, 0.5f);
+    encoder_Check("stop longer than wrap", m.v, ok);
+
+    //溢出与读竞争：正反两个方向（含负数计数），更新中断可打断读、读时UIF挂起
+    race_Case("overflow up preempt", 0, 1, 1);
+    race_Case("overflow down preempt", 0, -1, 1);
+    race_Case("overflow up pending", -3 * 65536, 1, 0);
+    race_Case("overflow down pending", 3 * 65536, -1, 0);
+    race_Dither("dither at rest");
+
+    return !encoder_ok;
+}
+
+//定点pid：同一输入序列分别送入浮点和Q16.16实现，比较输出
+//输出为PWM比较值（整数），差小于半个计数即不影响控制；ki较小时Q16.16的参数量化误差约1e-5，积分项中累积
+#define FIXED_TOL           0.5f
+#define FIXED_STEPS         20000
+
+static int fixed_ok;
+
+//输入序列：阶跃后带噪声的一阶响应，base为输入的基准值（位置环用于检验大角度）
+static float fixed_Input(uint32_t k, float base, float target) {
+    float x = target * (1 - expf(-(float) k / 300.0f));
+    return base + x + ((float) rand() / (float) RAND_MAX - 0.5f) * 0.02f * target;
+}
+
+static void fixed_Case(const char* name, int position, float kp, float ki, float kd, float max_output,
+                       float max_integral, float base, float target) {
+    PID ref = {0}, q = {0};
+    float diff = 0, peak = 0;
+
+    initPID(&ref, max_output, max_integral);
+    initPID(&q, max_output, max_integral);
+    setPIDParam(&ref, kp, ki, kd);
+    setPIDParam(&q, kp, ki, kd);
+    setPIDFixed(&q, 1);
+    setPIDTarget(&ref, base + target);
+    setPIDTarget(&q, base + target);
+
+    srand(1);
+    for (uint32_t k = 0; k < FIXED_STEPS; k++) {
+        float input = fixed_Input(k, base, target);
+        if (position) {
+            updatePID_Position(&ref, input);
+            updatePID_Position(&q, input);
+        } else {
+            updatePID_Speed(&ref, input);
+            updatePID_Speed(&q, input);
+        }
+        diff = fmaxf(diff, fabsf(q.output - ref.output));
+        peak = fmaxf(peak, fabsf(ref.output));
+    }
+
+    int ok = diff < FIXED_TOL;
+    printf("{\"case\":\"%s\",\"steps\":%u,\"max_diff\":%.5f,\"peak\":%.1f,\"ok\":%s}\n", name,
+           FIXED_STEPS, diff, peak, ok ? "true" : "false");
+    fixed_ok &= ok;
+}
+
+static int run_fixed(void) {
+    fixed_ok = 1;
+    //速度环：模式表中的参数（按1ms内环、10ms外环换算），PWM限幅2000
+    fixed_Case("speed 1ms", 0, 4.95f, 0.08f, 50, 2000, 4000, 0, 200);
+    fixed_Case("speed 10ms", 0, 5, 0.8f, 6, 2000, 4000, 0, 200);
+    fixed_Case("speed reverse", 0, 10, 1.5f, 0, 2000, 4000, 0, -300);
+    //位置环：起点在100圈（超出Q16.16范围）处仍与浮点一致
+    fixed_Case("position", 1, 0.5f, 0.01f, 0.1f, 2000, 4000, 0, 360);
+    fixed_Case("position 100 turns", 1, 10, 0.2f, 0.1f, 2000, 4000, 36000, 360);
+    return !fixed_ok;
+}
+
+//运动规划：逐段积分检查终点位置、速度，以及速度、加速度、加加速度上限
+#define PLAN_DT             1e-4f       //检查上限的步长 s
+#define PLAN_TOL_P          0.05f       //终点位置允许误差 °，另加路程的PLAN_TOL_PATH倍（单精度各段累积）
+#define PLAN_TOL_PATH       1e-4f
+#define PLAN_TOL_V          0.05f       //终点速度允许误差 °/s
+#define PLAN_TOL_LIMIT      1.001f      //上限允许的相对误差
+
+static int planner_ok;
+
+//规划结果
+typedef struct {
+    uint8_t ok;                         //planner_Position的返回值
+    float p, v;                         //终点状态
+    float vpeak, apeak, jpeak;          //速度、加速度、加加速度绝对值的最大值
+    float path;                         //路程
+    uint8_t cruise;                     //1：有匀速段
+}PlanCheck;
+
+static PlanCheck planner_Run(float p0, float v0, float p1, float v1, float vmax, float amax, float jmax) {
+    MotionPlan plan, step;
+    PlanCheck c = {0};
+
+    planner_Reset(&plan, p0, v0);
+    c.ok = planner_Position(&plan, p1, v1, vmax, amax, jmax);
+    if (!c.ok)
+        return c;
+
+    for (uint8_t i = 0; i < plan.count; i++) {
+        c.jpeak = fmaxf(c.jpeak, fabsf(plan.seg[i].j));
+        c.cruise |= plan.seg[i].j == 0 && plan.seg[i].a0 == 0;
+    }
+
+    //一步走完全部时长得到终点，小步长推进得到峰值
+    step = plan;
+    planner_Step(&step, planner_Duration(&plan));
+    c.p = step.p;
+    c.v = step.v;
+    step = plan;
+    c.vpeak = fabsf(v0);
+    while (!step.done) {
+        planner_Step(&step, PLAN_DT);
+        c.vpeak = fmaxf(c.vpeak, fabsf(step.v));
+        c.apeak = fmaxf(c.apeak, fabsf(step.a));
+        c.path += fabsf(step.v) * PLAN_DT;
+    }
+    return c;
+}
+
+//规划成功时终点和上限都必须满足；vmax在起点速度已超限时按起点速度
+static int planner_Valid(const PlanCheck* c, float v0, float p1, float v1, float vmax, float amax, float jmax) {
+    return c->ok && fabsf(c->p - p1) < PLAN_TOL_P + PLAN_TOL_PATH * c->path && fabsf(c->v - v1) < PLAN_TOL_V
+           && c->vpeak <= fmaxf(vmax, fabsf(v0)) * PLAN_TOL_LIMIT && c->apeak <= amax * PLAN_TOL_LIMIT
+           && (jmax <= 0 || c->jpeak <= jmax * PLAN_TOL_LIMIT);
+}
+
+static void planner_Check(const char* name, const PlanCheck* c, int ok) {
+    printf("{\"case\":\"%s\",\"p\":%.3f,\"v\":%.3f,\"vpeak\":%.1f,\"apeak\":%.1f,\"jpeak\":%.1f,\"ok\":%s}\n",
+           name, c->p, c->v, c->vpeak, c->apeak, c->jpeak, ok ? "true" : "false");
+    planner_ok &= ok;
+}
+
+static float planner_Rand(float min, float max) {
+    return min + (max - min) * (float) rand() / (float) RAND_MAX;
+}
+
+//指令队列：两条同向指令衔接（第一段末速度不为0），运行到clear_at秒后清空队列，再运行10s
+//轴必须在第一段终点之后减速停下，不能以衔接速度一直走下去
+static PlanCheck planner_Queue(float clear_at, float vmax, float amax, float jmax, float* held) {
+    static MotionQueue queue;
+    MotionPlan plan;
+    MotionCommand cmd = {360, vmax, amax, jmax};
+    PlanCheck c = {0};
+    const float dt = 0.01f;
+    float p_hold = 0;
+
+    memset(&queue, 0, sizeof(queue));
+    planner_Reset(&plan, 0, 0);
+    motion_Push(&queue, &cmd);
+    cmd.target = 720;
+    motion_Push(&queue, &cmd);
+    c.ok = 1;
+    for (float t = 0; t < clear_at + 10; t += dt) {
+        motion_Run(&queue, &plan, dt);
+        if (t >= clear_at && motion_Count(&queue) != 0)
+            motion_Clear(&queue);
+        c.vpeak = fmaxf(c.vpeak, fabsf(plan.v));
+        c.apeak = fmaxf(c.apeak, fabsf(plan.a));
+        if (t < clear_at + 9)
+            p_hold = plan.p;
+    }
+    c.p = plan.p;
+    c.v = plan.v;
+    *held = fabsf(plan.p - p_hold);
+    return c;
+}
+
+static int run_planner(uint32_t iterations) {
+    const float vmax = 720, amax = 3600, jmax = 36000;
+    PlanCheck c;
+    uint32_t failed = 0, rejected = 0;
+
+    planner_ok = 1;
+
+    //梯形：达到最大速度，加速度为方波
+    c = planner_Run(0, 0, 360, 0, vmax, amax, 0);
+    planner_Check("trapezoid", &c, planner_Valid(&c, 0, 360, 0, vmax, amax, 0)
+                  && c.cruise && c.vpeak > vmax * 0.999f);
+
+    //S曲线：7段，达到最大速度和最大加速度
+    c = planner_Run(0, 0, -720, 0, vmax, amax, jmax);
+    planner_Check("s-curve", &c, planner_Valid(&c, 0, -720, 0, vmax, amax, jmax)
+                  && c.cruise && c.vpeak > vmax * 0.999f && c.apeak > amax * 0.999f);
+
+    //距离短，达不到最大速度：没有匀速段
+    c = planner_Run(10, 0, 100, 0, vmax, amax, jmax);
+    planner_Check("no cruise", &c, planner_Valid(&c, 0, 100, 0, vmax, amax, jmax)
+                  && !c.cruise && c.vpeak < vmax * 0.99f);
+
+    //起点速度高、距离只够减速：只有减速段，速度单调下降
+    c = planner_Run(0, 500, 70, 0, vmax, amax, jmax);
+    planner_Check("decel only", &c, planner_Valid(&c, 500, 70, 0, vmax, amax, jmax)
+                  && !c.cruise && c.vpeak <= 500 * PLAN_TOL_LIMIT);
+
+    //距离不足以减速到末速度：规划失败
+    c = planner_Run(0, 700, 10, 0, vmax, amax, jmax);
+    planner_Check("too short", &c, !c.ok);
+
+    //最大加速度远大于jmax下的可达值，缩小PLAN_MAX_ITERATION次仍不收敛：规划失败，不能输出负时长的段
+    c = planner_Run(0, 0, 1, 0, vmax, 1e6f, 100);
+    planner_Check("no convergence", &c, !c.ok);
+
+    //队列在第一段执行中被清空：第一段按衔接速度规划，走完后减速停在360°之后、720°之前，停住不动
+    for (int k = 0; k < 2; k++) {
+        float drift;
+        c = planner_Queue(k ? 0.3f : 0, vmax, amax, k ? jmax : 0, &drift);
+        planner_Check(k ? "queue cleared s-curve" : "queue cleared trapezoid", &c,
+                      c.v == 0 && drift == 0 && c.p > 360 && c.p < 720 && c.vpeak <= vmax * PLAN_TOL_LIMIT
+                      && c.apeak <= amax * PLAN_TOL_LIMIT);
+    }
+
+    //随机起点速度、距离、末速度和上限：规划失败可以接受，成功时必须到达终点且不超限
+    srand(1);
+    for (uint32_t k = 0; k < iterations; k++) {
+        float a = planner_Rand(100, 10000), j = (k & 1) ? a * planner_Rand(2, 50) : 0;
+        float v = planner_Rand(50, 1500), v0 = planner_Rand(-v, v), v1 = planner_Rand(-v, v) * (k % 3 == 0);
+        float p1 = planner_Rand(-1000, 1000);
+        c = planner_Run(0, v0, p1, v1, v, a, j);
+        if (!c.ok)
+            rejected++;
+        else if (!planner_Valid(&c, v0, p1, v1, v, a, j) && failed++ == 0)
+            fprintf(stderr, "planner: v0 %g p1 %g v1 %g vmax %g amax %g jmax %g -> p %g v %g peaks %g %g %g\n",
+                    v0, p1, v1, v, a, j, c.p, c.v, c.vpeak, c.apeak, c.jpeak);
+    }
+    printf("{\"case\":\"random\",\"cases\":%u,\"rejected\":%u,\"failed\":%u,\"ok\":%s}\n", iterations,
+           rejected, failed, failed == 0 ? "true" : "false");
+    planner_ok &= failed == 0;
+    return !planner_ok;
+}
+
+//运行基准测试，返回退出码
+static int run_bench(uint32_t iterations, float tolerance, const char* baseline, const char* save) {
+    BenchResult result[BENCH_MAX_CASES];
+    FILE* base = NULL;
+    FILE* out = NULL;
+    int regressed = 0;
+
+    if (baseline != NULL && (base = fopen(baseline, "r")) == NULL) {
+        perror(baseline);
+        return 1;
+    }
+    if (save != NULL && (out = fopen(save, "w")) == NULL) {
+        perror(save);
+        return 1;
+    }
+
+    sim_ResetPeripherals();
+    uint8_t count = bench_Run(result, BENCH_MAX_CASES, iterations);
+    for (uint8_t k = 0; k < count; k++) {
+        float ns = bench_Baseline(base, result[k].name);
+        uint8_t slow = bench_Check(&result[k], ns, tolerance);
+        regressed |= slow;
+        printf("{\"bench\":\"%s\",\"ns_per_call\":%.2f,\"heap_delta\":%d,\"baseline\":%.2f,\"regressed\":%s}\n",
+               result[k].name, result[k].ns_per_call, (int) result[k].heap_delta, ns, slow ? "true" : "false");
+        if (out != NULL)
+            fprintf(out, "%s %.2f\n", result[k].name, result[k].ns_per_call);
+    }
+
+    if (base != NULL)
+        fclose(base);
+    if (out != NULL)
+        fclose(out);
+    return count == 0 || regressed;
+}
+
+int main(int argc, char** argv) {
+    uint32_t duration_ms = 3000;
+    int selected = 0;
+    const char* names[16];
+    int bench = 0, text = 0, format = 0, shapes = 0, keys = 0, knob = 0, planner = 0, filter = 0;
+    uint32_t iterations = 1000000;
+    float tolerance = 0.25f;
+    const char* baseline = NULL;
+    const char* save = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            if ((sim_telemetry = fopen(argv[++i], "wb")) == NULL) {
+                perror(argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            duration_ms = (uint32_t) (atof(argv[++i]) * 1000);
+        } else if (strcmp(argv[i], "--oled") == 0) {
+            return run_oled();
+        } else if (strcmp(argv[i], "--encoder") == 0) {
+            return run_encoder();
+        } else if (strcmp(argv[i], "--fixed") == 0) {
+            return run_fixed();
+        } else if (strcmp(argv[i], "--planner") == 0) {
+            planner = 1;
+        } else if (strcmp(argv[i], "--telemetry") == 0) {
+            return run_telemetry();
+        } else if (strcmp(argv[i], "--curve") == 0) {
+            return run_curve();
+        } else if (strcmp(argv[i], "--filter") == 0) {
+            filter = 1;
+        } else if (strcmp(argv[i], "--disturb") == 0) {
+            return run_disturb();
+        } else if (strcmp(argv[i], "--restart") == 0) {
+            return run_restart();
+        } else if (strcmp(argv[i], "--tune") == 0) {
+            return run_tune();
+        } else if (strcmp(argv[i], "--menu") == 0) {
+            return run_menu();
+        } else if (strcmp(argv[i], "--keys") == 0) {
+            keys = 1;
+        } else if (strcmp(argv[i], "--knob") == 0) {
+            knob = 1;
+        } else if (strcmp(argv[i], "--shapes") == 0) {
+            shapes = 1;
+        } else if (strcmp(argv[i], "--format") == 0) {
+            format = 1;
+        } else if (strcmp(argv[i], "--text") == 0) {
+            text = 1;
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench = 1;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = (uint32_t) atol(argv[++i]);
+        } else if (strcmp(argv[i], "--tol") == 0 && i + 1 < argc) {
+            tolerance = (float) atof(argv[++i]);
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save = argv[++i];
+        } else if (selected < 16) {
+            names[selected++] = argv[i];
+        }
+    }
+    if (text)
+        return run_text(iterations);
+    if (format)
+        return run_format(iterations > 100000 ? 100000 : iterations);
+    if (knob)
+        return run_knob(iterations > 10000 ? 10000 : iterations);
+    if (keys)
+        return run_keys(iterations > 10000 ? 10000 : iterations);
+    if (planner)
+        return run_planner(iterations > 20000 ? 20000 : iterations);
+    if (filter)
+        return run_filter(iterations > 100000 ? 100000 : iterations);
+    if (shapes)
+        return run_shapes(iterations > 20000 ? 20000 : iterations);
+    if (bench)
+        return run_bench(iterations, tolerance, baseline, save);
+    if (duration_ms == 0)
+        duration_ms = 1;
+
+    for (size_t k = 0; k < sizeof(scenarios) / sizeof(scenarios[0]); k++) {
+        const Scenario* sc = &scenarios[k];
+        int run = selected == 0;
+        for (int i = 0; i < selected; i++) {
+            if (strcmp(names[i], sc->name) == 0)
+                run = 1;
+        }
+        if (!run)
+            continue;
+
+        double* y = run_scenario(sc, duration_ms);
+        report(sc, y, duration_ms);
+        free(y);
+    }
+
+    if (sim_telemetry != NULL)
+        fclose(sim_telemetry);
+    return 0;
+}
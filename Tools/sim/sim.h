@@ -0,0 +1,25 @@
+//仿真公共接口
+#ifndef __SIM_H__
+#define __SIM_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+extern uint64_t sim_cycles;                 //仿真时间  CPU周期（72MHz）
+extern FILE* sim_telemetry;                 //遥测输出文件，NULL表示丢弃
+
+extern uint8_t sim_oled[8][128];            //模拟OLED屏幕内容（由I2C字节流解析）
+extern uint32_t sim_oled_errors;            //非法控制字节、地址错误次数
+extern uint32_t sim_gpio_writes;            //GPIO写次数（HAL_GPIO_WritePin、BSRR）
+
+void sim_ResetPeripherals(void);            //外设寄存器恢复上电状态
+void sim_UartService(void);                 //完成进行中的DMA发送
+void sim_UartError(void);                   //进行中的DMA发送出错，这一段没有发出
+
+//OLED图形绘制的逐点参考实现（oled_ref.c），参数与OLED_DrawXxx相同
+void ref_DrawTriangle(int16_t X0, int16_t Y0, int16_t X1, int16_t Y1, int16_t X2, int16_t Y2, uint8_t IsFilled);
+void ref_DrawCircle(int16_t X, int16_t Y, uint8_t Radius, uint8_t IsFilled);
+void ref_DrawEllipse(int16_t X, int16_t Y, uint8_t A, uint8_t B, uint8_t IsFilled);
+void ref_DrawArc(int16_t X, int16_t Y, uint8_t Radius, int16_t StartAngle, int16_t EndAngle, uint8_t IsFilled);
+
+#endif //__SIM_H__
@@ -0,0 +1,228 @@
+//仿真用HAL桩实现：外设寄存器、句柄及User/Src调用到的HAL函数
+#include "main.h"
+#include "tim.h"
+#include "usart.h"
+#include "gpio.h"
+#include "sim.h"
+#include "OLED.h"
+
+DWT_Type sim_dwt;
+CoreDebug_Type sim_coredebug;
+RCC_TypeDef sim_rcc;
+GPIO_TypeDef sim_gpioa, sim_gpiob;
+uint32_t sim_gpio_writes;
+uint32_t SystemCoreClock = 72000000;
+uint32_t sim_primask;
+void (*sim_tim_hook)(TIM_TypeDef* tim);
+
+uint64_t sim_cycles;
+FILE* sim_telemetry;
+
+static TIM_TypeDef tim1_regs, tim2_regs, tim3_regs, tim4_regs;
+
+//与Core/Src/tim.c中的配置一致
+TIM_HandleTypeDef htim1 = {&tim1_regs, {72 - 1, 2000}};
+TIM_HandleTypeDef htim2 = {&tim2_regs, {0, 65535}};
+TIM_HandleTypeDef htim3 = {&tim3_regs, {0, 65535}};
+TIM_HandleTypeDef htim4 = {&tim4_regs, {72 - 1, 1000 - 1}};
+UART_HandleTypeDef huart3;
+
+static const uint8_t* uart_data;            //DMA正在发送的数据
+static uint16_t uart_pending;               //DMA正在发送的字节数
+
+void sim_ResetPeripherals(void) {
+    TIM_HandleTypeDef* handles[] = {&htim1, &htim2, &htim3, &htim4};
+    for (int i = 0; i < 4; i++) {
+        TIM_TypeDef* tim = handles[i]->Instance;
+        *tim = (TIM_TypeDef) {0};
+        tim->PSC = handles[i]->Init.Prescaler;
+        tim->ARR = handles[i]->Init.Period;
+        tim->SR = TIM_FLAG_UPDATE;          //初始化时UG置位的更新标志
+    }
+    sim_gpioa = (GPIO_TypeDef) {0};
+    sim_gpiob = (GPIO_TypeDef) {0};
+    sim_rcc.CFGR = RCC_CFGR_PPRE1_DIV2;     //APB1 = 36MHz，定时器时钟72MHz
+    uart_pending = 0;
+    huart3.ErrorCode = HAL_UART_ERROR_NONE;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) {
+    return SystemCoreClock / 2;
+}
+
+void MX_GPIO_Init(void) {
+}
+
+static void oled_Bus(GPIO_TypeDef* port);
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state) {
+    if (state == GPIO_PIN_SET)
+        port->ODR |= pin;
+    else
+        port->ODR &= ~(uint32_t) pin;
+    sim_gpio_writes++;
+    oled_Bus(port);
+}
+
+void sim_GpioBsrr(GPIO_TypeDef* port, uint32_t value) {
+    port->BSRR = value;
+    port->ODR = (port->ODR | (value & 0xFFFF)) & ~(value >> 16);
+    sim_gpio_writes++;
+    oled_Bus(port);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin) {
+    return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim) {
+    htim->Instance->DIER |= TIM_IT_UPDATE;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim) {
+    htim->Instance->DIER &= ~TIM_IT_UPDATE;
+    htim->Instance->CR1 &= ~TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+//CCER每通道一位，表示输出使能
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef* htim, uint32_t channel) {
+    htim->Instance->CCER |= 1u << (channel >> 2);
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef* htim, uint32_t channel) {
+    htim->Instance->CCER &= ~(1u << (channel >> 2));
+    if ((htim->Instance->CCER & 0xF) == 0)
+        htim->Instance->CR1 &= ~TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef* htim, uint32_t channel) {
+    (void) channel;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Stop(TIM_HandleTypeDef* htim, uint32_t channel) {
+    (void) channel;
+    htim->Instance->CR1 &= ~TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+//DMA发送：下一次sim_UartService时写入遥测文件并完成，sim_UartError时丢弃
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size) {
+    if (uart_pending)
+        return HAL_BUSY;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    uart_data = data;
+    uart_pending = size;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size) {
+    (void) huart;
+    (void) data;
+    (void) size;
+    return HAL_OK;
+}
+
+void sim_UartService(void) {
+    if (uart_pending) {
+        if (sim_telemetry != NULL)
+            fwrite(uart_data, 1, uart_pending, sim_telemetry);
+        uart_pending = 0;
+        HAL_UART_TxCpltCallback(&huart3);
+    }
+}
+
+void sim_UartError(void) {
+    if (uart_pending) {
+        uart_pending = 0;
+        huart3.ErrorCode |= HAL_UART_ERROR_DMA;
+        HAL_UART_ErrorCallback(&huart3);
+    }
+}
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t) (sim_cycles / (SystemCoreClock / 1000));
+}
+
+void HAL_Delay(uint32_t ms) {
+    sim_cycles += (uint64_t) ms * (SystemCoreClock / 1000);
+}
+
+//模拟SSD1306 I2C从机：页寻址模式，解析设置光标命令，数据写入sim_oled
+//硬件I2C后端经OLED_HostTransmit直接送入，软件I2C后端由PB8/PB9引脚波形解析
+uint8_t sim_oled[8][128];
+uint32_t sim_oled_errors;
+static uint8_t oled_page, oled_col, oled_arg;
+
+static void oled_Frame(uint8_t control, const uint8_t* data, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t b = data[i];
+        if (control == 0x40) {
+            sim_oled[oled_page][oled_col] = b;
+            oled_col = (oled_col + 1) & 0x7F;       //页寻址模式：列在本页内回绕
+        } else if (control != 0x00) {
+            sim_oled_errors++;
+            return;
+        } else if (oled_arg) {
+            oled_arg = 0;                           //上一条命令的参数
+        } else if ((b & 0xF8) == 0xB0) {
+            oled_page = b & 0x07;
+        } else if ((b & 0xF0) == 0x10) {
+            oled_col = (uint8_t) ((oled_col & 0x0F) | ((b & 0x07) << 4));
+        } else if ((b & 0xF0) == 0x00) {
+            oled_col = (uint8_t) ((oled_col & 0x70) | (b & 0x0F));
+        } else if (b == 0x81 || b == 0x8D || b == 0xA8 || b == 0xD3 || b == 0xD5 || b == 0xD9 || b == 0xDA ||
+                   b == 0xDB) {
+            oled_arg = 1;                           //带一个参数的命令
+        }
+    }
+}
+
+void OLED_HostTransmit(uint8_t Control, const uint8_t* Data, uint8_t Count) {
+    oled_Frame(Control, Data, Count);
+}
+
+//I2C引脚波形解析：SCL高时SDA下降为起始、上升为终止，SCL上升沿采样，第9位为应答
+static struct {
+    uint8_t scl, sda, active, bits, byte;
+    uint16_t len;
+    uint8_t buf[2 + 256];
+}bus;
+
+static void oled_Bus(GPIO_TypeDef* port) {
+    if (port != OLED_SCL_GPIO_Port)
+        return;
+    uint8_t scl = (port->ODR & OLED_SCL_Pin) != 0;
+    uint8_t sda = (port->ODR & OLED_SDA_Pin) != 0;
+
+    if (scl && bus.scl && sda != bus.sda) {
+        if (!sda) {
+            bus.active = 1;
+            bus.bits = 0;
+            bus.len = 0;
+        } else if (bus.active) {
+            bus.active = 0;
+            if (bus.len < 2 || bus.buf[0] != 0x78)
+                sim_oled_errors++;
+            else
+                oled_Frame(bus.buf[1], bus.buf + 2, bus.len - 2);
+        }
+    } else if (scl && !bus.scl && bus.active) {
+        if (bus.bits < 8)
+            bus.byte = (uint8_t) (bus.byte << 1 | sda);
+        if (++bus.bits == 9) {
+            if (bus.len < sizeof(bus.buf))
+                bus.buf[bus.len++] = bus.byte;
+            bus.bits = 0;
+        }
+    }
+    bus.scl = scl;
+    bus.sda = sda;
+}
@@ -0,0 +1,7 @@
+//仿真用HAL桩：替代stm32f1xx_hal.h，外设定义见main.h
+#ifndef __STM32F1xx_HAL_H
+#define __STM32F1xx_HAL_H
+
+#include "main.h"
+
+#endif //__STM32F1xx_HAL_H
@@ -0,0 +1,12 @@
+//仿真用HAL桩：替代Core/Inc/tim.h
+#ifndef __TIM_H__
+#define __TIM_H__
+
+#include "main.h"
+
+extern TIM_HandleTypeDef htim1;
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim4;
+
+#endif //__TIM_H__
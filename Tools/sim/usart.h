@@ -0,0 +1,9 @@
+//仿真用HAL桩：替代Core/Inc/usart.h
+#ifndef __USART_H__
+#define __USART_H__
+
+#include "main.h"
+
+extern UART_HandleTypeDef huart3;
+
+#endif //__USART_H__
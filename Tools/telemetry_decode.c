@@ -0,0 +1,40 @@
+//上位机遥测解码：把USART3上的二进制遥测帧还原为CSV
+//编译：gcc -O2 -IUser/Inc -o telemetry_decode Tools/telemetry_decode.c Tools/telemetry_decoder.c
+//用法：telemetry_decode [串口抓包文件]   不带参数时从stdin读取
+//输出：seq,timestamp,mode,ch0,ch1,ch2   丢帧、校验错误统计输出到stderr
+
+#include <stdio.h>
+#include "telemetry_decoder.h"
+
+int main(int argc, char** argv) {
+    FILE* in = stdin;
+    TelemetryDecoder d;
+    TelemetryFrame frame;
+    int c;
+
+    if (argc > 1 && (in = fopen(argv[1], "rb")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    decoder_Init(&d);
+    printf("seq,timestamp,mode,ch0,ch1,ch2\n");
+    while ((c = getc(in)) != EOF) {
+        if (!decoder_Feed(&d, (uint8_t) c, &frame))
+            continue;
+
+        printf("%u,%u,%u", frame.seq, frame.timestamp, frame.mode);
+        for (int i = 0; i < TELEMETRY_CHANNELS; i++) {
+            if (i < frame.count)
+                printf(",%.4f", frame.ch[i]);
+            else
+                printf(",");
+        }
+        printf("\n");
+    }
+
+    fprintf(stderr, "frames %lu, lost %lu, crc errors %lu\n", d.frames, d.lost, d.crc_errors);
+    if (in != stdin)
+        fclose(in);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <string.h>
+#include "telemetry_decoder.h"
+
+static uint16_t crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t) (*data++) << 8;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ 0x1021) : (uint16_t) (crc << 1);
+    }
+    return crc;
+}
+
+void decoder_Init(TelemetryDecoder* d) {
+    memset(d, 0, sizeof(*d));
+}
+
+//收满一帧长度后检查帧头和CRC，不对就滑动一个字节等下一个字节，正确的帧不会被错误的帧吞掉
+int decoder_Feed(TelemetryDecoder* d, uint8_t byte, TelemetryFrame* frame) {
+    d->buf[d->fill++] = byte;
+    if (d->fill < sizeof(d->buf))
+        return 0;
+
+    //帧头同步
+    if (d->buf[0] != TELEMETRY_HEAD0 || d->buf[1] != TELEMETRY_HEAD1) {
+        memmove(d->buf, d->buf + 1, --d->fill);
+        return 0;
+    }
+
+    memcpy(frame, d->buf, sizeof(*frame));
+    if (crc16(d->buf, sizeof(*frame) - sizeof(frame->crc)) != frame->crc) {
+        //校验失败，滑动一个字节重新同步
+        d->crc_errors++;
+        memmove(d->buf, d->buf + 1, --d->fill);
+        return 0;
+    }
+    d->fill = 0;
+
+    if (d->have_seq && frame->seq != d->next_seq)
+        d->lost += (uint16_t) (frame->seq - d->next_seq);
+    d->next_seq = frame->seq + 1;
+    d->have_seq = 1;
+    d->frames++;
+    return 1;
+}
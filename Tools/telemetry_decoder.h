@@ -0,0 +1,22 @@
+//遥测帧逐字节解码：帧头同步、CRC校验、按帧序号统计丢帧
+//telemetry_decode和仿真（mg513_sim --telemetry）共用
+#ifndef __TELEMETRY_DECODER_H__
+#define __TELEMETRY_DECODER_H__
+
+#include <stddef.h>
+#include "telemetry.h"
+
+typedef struct {
+    uint8_t buf[sizeof(TelemetryFrame)];    //待校验的字节
+    size_t fill;                            //已有字节数
+    int have_seq;                           //0：还没有收到过正确的帧
+    uint16_t next_seq;                      //期望的下一帧序号
+    unsigned long frames;                   //正确的帧数
+    unsigned long lost;                     //按序号间隔统计的丢帧数
+    unsigned long crc_errors;               //帧头正确但CRC错误的次数
+}TelemetryDecoder;
+
+void decoder_Init(TelemetryDecoder* d);
+int decoder_Feed(TelemetryDecoder* d, uint8_t byte, TelemetryFrame* frame);   //收到一帧正确的帧时返回1
+
+#endif //__TELEMETRY_DECODER_H__
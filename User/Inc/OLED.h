@@ -11,6 +11,35 @@
 #define OLED_8X16				8
 #define OLED_6X8				6
 
+/*通信后端*/
+/*OLED_BACKEND_SOFT：PB8/PB9软件模拟I2C，经HAL_GPIO_WritePin写引脚，阻塞发送*/
+/*OLED_BACKEND_FAST：PB8/PB9软件模拟I2C，直接写GPIOB->BSRR，阻塞发送*/
+/*OLED_BACKEND_I2C1：I2C1重映射到PB8/PB9，400kHz，DMA1通道6发送，OLED_Update不等待发送完成*/
+/*                   尚未在目标板上验证，需编译时定义OLED_BACKEND=1选用*/
+/*OLED_BACKEND_HOST：主机仿真，每一帧交给OLED_HostTransmit*/
+#define OLED_BACKEND_SOFT		0
+#define OLED_BACKEND_I2C1		1
+#define OLED_BACKEND_HOST		2
+#define OLED_BACKEND_FAST		3
+
+#ifndef OLED_BACKEND
+#if defined(__arm__)
+#define OLED_BACKEND			OLED_BACKEND_FAST
+#else
+#define OLED_BACKEND			OLED_BACKEND_HOST
+#endif
+#endif
+
+#define OLED_I2C_SPEED			400000	//硬件I2C时钟 Hz
+#define OLED_TIMEOUT_MS			50		//硬件I2C一次更新的最长时间，超时后复位I2C1
+#define OLED_STOP_WAIT			1000	//硬件I2C开始发送前等待上一次终止条件发出的最多查询次数
+#define OLED_FAST_DELAY			4		//BSRR软件I2C每次写SCL后的空指令数，72MHz下SCL约1MHz
+#define OLED_MAX_TRANSFERS		32		//传输队列长度，每个修改段占用两次传输（设置光标、数据）
+
+/*OLED_Update合并发送的最大间隔：两段修改之间相同字节不超过此数时一起发送*/
+/*重新设置光标需3条命令约12字节，间隔小于此值时合并更省*/
+#define OLED_MERGE_GAP			8
+
 /*IsFilled参数数值*/
 #define OLED_UNFILLED			0
 #define OLED_FILLED				1
@@ -26,6 +55,21 @@ void OLED_Init(void);
 /*更新函数*/
 void OLED_Update(void);
 void OLED_UpdateArea(int16_t X, int16_t Y, uint8_t Width, uint8_t Height);
+void OLED_Invalidate(void);
+uint8_t OLED_IsBusy(void);
+void OLED_WaitIdle(void);
+void OLED_UpdateCallback(void);
+uint32_t OLED_GetTxCount(void);
+uint32_t OLED_GetErrorCount(void);
+
+/*通信后端接口*/
+#if OLED_BACKEND == OLED_BACKEND_I2C1
+void OLED_I2C1_Init(void);
+void OLED_I2C_EventIRQHandler(void);
+void OLED_I2C_ErrorIRQHandler(void);
+#elif OLED_BACKEND == OLED_BACKEND_HOST
+void OLED_HostTransmit(uint8_t Control, const uint8_t *Data, uint8_t Count);
+#endif
 
 /*显存控制函数*/
 void OLED_Clear(void);
@@ -40,7 +84,8 @@ void OLED_ShowNum(int16_t X, int16_t Y, uint32_t Number, uint8_t Length, uint8_t
 void OLED_ShowSignedNum(int16_t X, int16_t Y, int32_t Number, uint8_t Length, uint8_t FontSize);
 void OLED_ShowHexNum(int16_t X, int16_t Y, uint32_t Number, uint8_t Length, uint8_t FontSize);
 void OLED_ShowBinNum(int16_t X, int16_t Y, uint32_t Number, uint8_t Length, uint8_t FontSize);
-void OLED_ShowFloatNum(int16_t X, int16_t Y, double Number, uint8_t IntLength, uint8_t FraLength, uint8_t FontSize);
+void OLED_ShowFloatNum(int16_t X, int16_t Y, float Number, uint8_t IntLength, uint8_t FraLength, uint8_t FontSize);
+void OLED_ShowFixedNum(int16_t X, int16_t Y, int32_t Number, uint8_t FracBits, uint8_t IntLength, uint8_t FraLength, uint8_t FontSize);
 void OLED_ShowChinese(int16_t X, int16_t Y, char *Chinese);
 void OLED_ShowImage(int16_t X, int16_t Y, uint8_t Width, uint8_t Height, const uint8_t *Image);
 void OLED_Printf(int16_t X, int16_t Y, uint8_t FontSize, char *format, ...);
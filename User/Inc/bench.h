@@ -0,0 +1,25 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include "stdint.h"
+
+#define BENCH_MAX_CASES         16
+#define BENCH_CHUNK             1000    //每段计时的调用次数，避免32位计数回绕
+#define BENCH_TARGET_ITERATIONS 10000   //目标板上每项的调用次数
+#define BENCH_FRAME             0xB0    //上报帧mode字段：0xB0 | 序号   ch: 周期/次  ns/次  堆增量
+
+//一项基准测试结果
+typedef struct {
+    const char* name;
+    uint32_t calls;                     //调用次数
+    float ticks_per_call;               //每次调用的计数（目标板为CPU周期，主机为ns），已扣除循环开销
+    float ns_per_call;                  //每次调用耗时  ns
+    int32_t heap_delta;                 //运行前后堆占用变化  字节
+}BenchResult;
+
+uint8_t bench_Run(BenchResult* result, uint8_t max, uint32_t iterations);  //运行全部基准，返回项数；电机运行时返回0
+uint8_t bench_Check(const BenchResult* result, float baseline_ns, float tolerance);     //超过基准(1 + tolerance)倍返回1
+void bench_Report(const BenchResult* result, uint8_t count);                //通过遥测上报
+int32_t bench_HeapUsed(void);                                               //堆占用，弱定义，主机上重新实现
+
+#endif //__BENCH_H__
@@ -4,6 +4,8 @@
 #include "stdint.h"
 #include "tim.h"
 
+#define ENCODER_COUNT_ORIGIN 0x8000    //零点（复位后的TIMx_CNT），位于计数器中间
+
 typedef struct {
     uint8_t multiple;               //倍频
     float   reduction_ratio;        //电机减速比
@@ -25,17 +27,37 @@ typedef struct {
 }Position;
 
 typedef struct {
-    uint16_t count_now;               //编码器当前计数
-    uint16_t count_last;              //编码器上次计数
+    uint16_t count_now;               //编码器当前计数（总计数的低16位）
     int32_t count_increment;         //编码器两帧增量计数
-    int32_t count_total;             //编码器总计数
-
-    int64_t count_overflow;           //计数器寄存器 TIMx_CNT溢出次数     -正数-正转上溢出   -负数-反转下溢出
+    int64_t count_total;             //编码器总计数 = 溢出次数 * 65536 + TIMx_CNT - ENCODER_COUNT_ORIGIN
+    int64_t count_last;              //上次总计数
 
-    int32_t JUMP_THRESHOLD;           //计数器溢出阈值
-    uint32_t TIMx_MAX_COUNT;          //16bits-TIMx = 2^16 - 1      32bits-TIMx = 2^32 - 1
+    volatile int32_t count_overflow;  //TIMx_CNT溢出次数，由定时器更新中断维护   -正数-正转上溢出   -负数-反转下溢出
 }Counter;
 
+//换算系数，initEncoder中预先算好，循环中只做单精度乘法
+typedef struct {
+    float count_to_rot;            //计数 -> 圈数          1 / (multiple * reduction_ratio * ppr)
+    float count_to_rpm;            //计数/ms -> rpm        60000 / (multiple * reduction_ratio * ppr)
+    float rpm_to_linear;           //rpm -> m/s            2 * PI * r / 60
+    float period;                  //上次调用周期  ms
+    float inv_period;              //1 / period
+    float cycles_per_ms;           //DWT周期计数器每ms周期数
+    float edge_counts;             //相邻两个A相边沿之间的计数    multiple / 2
+}Scale;
+
+//M/T测速：A相边沿时刻由EXTI中断记录，控制中断取用
+//两个中断同优先级不会互相打断，边沿时刻与计数成对读写不会撕裂
+typedef struct {
+    volatile uint32_t edge_time;    //最近一个边沿的时刻   DWT周期
+    volatile uint16_t edge_count;   //该边沿处的计数器值
+    volatile uint16_t edge_seq;     //边沿序号
+    uint32_t last_time;             //上次测速所用边沿
+    uint16_t last_count;
+    uint16_t last_seq;
+    uint8_t primed;                 //1：last_*有效，0：等待下一个边沿作为起点（复位、停转后）
+}EdgeTimer;
+
 typedef enum{
     UP=0,       //前进
     DOWN=1,     //后退
@@ -52,10 +74,20 @@ typedef struct {
     Position position;
 
     Counter counter;
+
+    Scale scale;
+
+    EdgeTimer edge;
 }Encoder;
 
 void initEncoder(Encoder* ecd, const Parameter param);          //初始化编码器
 void restEncoder(Encoder* ecd);          //编码器计数器清零
-void updateEncoderLoop(Encoder* ecd, uint8_t loop_period);      //在循环函数中更新编码器状态
+void updateEncoderLoop(Encoder* ecd, float loop_period);        //在循环函数中更新编码器状态（周期 ms）
+void encoderOverflow(Encoder* ecd);                             //定时器更新中断中调用，记录溢出
+int64_t encoderCount64(Encoder* ecd);                           //读取64位总计数，任意上下文可调用
+int32_t encoderCount32(Encoder* ecd);                           //读取32位总计数（回绕）
+void encoderEdge(Encoder* ecd);                                 //A相边沿中断中调用，记录边沿时刻
+float estimateVelocity(EdgeTimer* edge, uint32_t now, float count_to_rpm, float cycles_per_ms,
+                       float edge_counts, float velocity);      //M/T测速  rpm
 
 #endif //__ENCODER_H__
@@ -3,10 +3,55 @@
 
 #include "main.h"
 
-#define FILTER_SIZE 5 // 滤波器的大小
+#define FILTER_SIZE 5 // 滑动平均、中值滤波器的窗口大小
 
-float lowPassFilter(float new_value);           //低通滤波器
-float movingAverageFilter(float new_value);     //滑动平均滤波器
-float medianFilter(float new_value);            //中值滤波器
+//每个滤波器实例自带状态，不同电机、不同控制环互不影响
+
+//一阶低通   y += alpha * (x - y)
+typedef struct {
+    float alpha;                    //滤波系数 0~1，越小越平滑
+    float y;                        //上次输出
+    uint8_t primed;                 //0：第一个样本直接作为输出
+}LowPass;
+
+//滑动平均
+typedef struct {
+    float buf[FILTER_SIZE];         //环形缓冲
+    float sum;                      //窗口累加值
+    uint8_t index;                  //下一个写入位置
+    uint8_t count;                  //已有样本数
+}MovingAverage;
+
+//滑动中值：环形缓冲记录到达顺序，有序数组增量维护
+typedef struct {
+    float ring[FILTER_SIZE];        //按到达顺序
+    float sorted[FILTER_SIZE];      //升序
+    uint8_t index;                  //下一个写入位置
+    uint8_t count;                  //已有样本数
+}Median;
+
+//二阶IIR（直接II型）
+//w[n] = x[n] - a1*w[n-1] - a2*w[n-2]
+//y[n] = b0*w[n] + b1*w[n-1] + b2*w[n-2]
+typedef struct {
+    float b0, b1, b2;               //分子系数
+    float a1, a2;                   //分母系数（a0归一化为1）
+    float w1, w2;                   //延迟单元
+}Biquad;
+
+void initLowPass(LowPass* f, float cutoff, float period);      //截止频率 Hz，采样周期 ms
+void setLowPassAlpha(LowPass* f, float alpha);                  //直接设置滤波系数
+float updateLowPass(LowPass* f, float x);
+
+void initMovingAverage(MovingAverage* f);
+float updateMovingAverage(MovingAverage* f, float x);
+
+void initMedian(Median* f);
+float updateMedian(Median* f, float x);
+
+void initBiquad(Biquad* f, float b0, float b1, float b2, float a1, float a2);
+void initBiquadLowPass(Biquad* f, float cutoff, float period, float q);    //巴特沃斯取q = 0.7071
+void resetBiquad(Biquad* f);
+float updateBiquad(Biquad* f, float x);
 
 #endif //__FILTER_H__
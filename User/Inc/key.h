@@ -3,7 +3,33 @@
 
 #include "main.h"
 
-uint16_t ReadKey2State();
-GPIO_PinState ReadKeyState();
+#define KEY_SAMPLE_MS       5       //采样周期 ms
+#define KEY_LONG_MS         800     //按住超过该时间产生长按事件 ms
+#define KEY_REPEAT_MS       200     //长按后自动重复的周期 ms
+#define KEY_QUEUE_SIZE      16      //事件队列长度，必须为2的幂
+
+//按键（低电平为按下）
+typedef enum {
+    KEY_OK,                 //PB5
+    KEY_ON,                 //PB3   ON/OFF
+    KEY_COUNT
+}KeyId;
+
+typedef enum {
+    KEY_EVENT_PRESS,        //按下（消抖后）
+    KEY_EVENT_RELEASE,      //松开（消抖后）
+    KEY_EVENT_LONG,         //按住KEY_LONG_MS
+    KEY_EVENT_REPEAT        //长按后每KEY_REPEAT_MS一次
+}KeyEventType;
+
+typedef struct {
+    uint8_t key;            //KeyId
+    uint8_t type;           //KeyEventType
+}KeyEvent;
+
+void key_Init(void);                    //清空状态与事件队列
+void key_Tick(void);                    //1ms周期调用（SysTick中断）：采样、消抖、产生事件
+uint8_t key_Read(KeyEvent* event);      //主循环中调用：取出一个事件，队列空返回0
+uint32_t key_Dropped(void);             //队列满丢弃的事件数
 
 #endif //__KEY_H__
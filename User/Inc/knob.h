@@ -0,0 +1,23 @@
+#ifndef __KNOB_H__
+#define __KNOB_H__
+
+#include "main.h"
+
+#define KNOB_STEPS_PER_DETENT   4       //每格的AB相状态变化次数
+#define KNOB_FAST_MS            40      //两格间隔小于该值时倍率为KNOB_FAST_GAIN ms
+#define KNOB_FAST_GAIN          5
+#define KNOB_MEDIUM_MS          100     //两格间隔小于该值时倍率为KNOB_MEDIUM_GAIN ms
+#define KNOB_MEDIUM_GAIN        2
+
+//旋钮增量：正数为顺时针
+typedef struct {
+    int16_t detents;        //实际转过的格数，移动光标使用
+    int16_t steps;          //按转速加速后的格数，修改数值使用
+}KnobDelta;
+
+void knob_Init(void);               //读取AB相初始状态并清零计数
+void knob_Edge(void);               //AB相任一边沿中断中调用（上升、下降沿）
+KnobDelta knob_Read(void);          //主循环中调用：取出累计的增量并清零（关中断读取）
+uint32_t knob_Invalid(void);        //AB相同时变化（漏中断或干扰）被丢弃的次数
+
+#endif //__KNOB_H__
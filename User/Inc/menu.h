@@ -3,8 +3,26 @@
 
 #include "main.h"
 
-void Menu_Init(void);
+//菜单输入事件
+typedef enum {
+    MENU_EVENT_KNOB,        //旋钮转动，delta为格数，正数光标向下
+    MENU_EVENT_OK,          //OK键（松开时）
+    MENU_EVENT_ON_OFF,      //ON/OFF键按下
+    MENU_EVENT_TUNE,        //OK键长按：模式页上打开参数整定页
+    MENU_EVENT_REFRESH      //周期检查实时数据
+}MenuEventType;
 
-void Menu(void);
+typedef struct {
+    MenuEventType type;
+    int16_t delta;
+}MenuEvent;
+
+void Menu_Init(void);                       //初始化屏幕并显示主页
+
+void Menu(void);                            //主循环中调用：处理输入事件，没有事件时休眠
+
+void Menu_Handle(const MenuEvent* event);   //处理一个事件，显示有变化时刷新屏幕
+
+uint32_t Menu_GetFlushCount(void);          //刷新屏幕次数
 
 #endif //__MENU_H__
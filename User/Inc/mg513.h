@@ -2,6 +2,9 @@
 #define __MG513_H__
 
 #include "main.h"
+#include "pid.h"
+#include "planner.h"
+#include "motion.h"
 
 typedef enum {
     LEFT = 0,
@@ -19,16 +22,89 @@ typedef enum {
     Position_CurveControl
 }MotorMode;
 
+//控制环所在的调度层
+typedef enum {
+    OUTER_LOOP = 0,     //外环，每outer_div个节拍执行一次
+    INNER_LOOP = 1      //内环，每个节拍执行
+}ControlLoop;
+
+//模式参数：控制环及其kp ki kd（按PID_TUNE_PERIOD整定）
+typedef struct {
+    PID* pid;
+    float kp, ki, kd;
+    ControlLoop loop;
+    uint8_t fixed;                  //1：该环使用定点pid
+}ModeGain;
+
+#define MODE_MAX_GAINS 2
+
+//模式描述：进入、内外环控制步、退出钩子及参数组
+typedef struct {
+    void (*init)(void);             //进入模式（可为NULL）
+    void (*inner)(void);            //内环，每个控制节拍执行
+    void (*outer)(void);            //外环，每outer_div个节拍执行
+    void (*teardown)(void);         //退出模式（可为NULL）
+    ModeGain gains[MODE_MAX_GAINS]; //pid参数组，pid为NULL表示结束
+}ModeDesc;
+
+//在线整定的控制环
+typedef enum {
+    TUNE_VEC_L,
+    TUNE_VEC_R,
+    TUNE_ANG_L,
+    TUNE_ANG_R,
+    TUNE_LOOPS
+}TuneLoop;
+
+//在线整定参数：kp ki kd为所在控制环实际周期下的值，与PID结构中相同
+typedef struct {
+    float kp, ki, kd;
+    float max_output;               //输出限幅
+    float max_integral;             //误差积分限幅
+}PIDTune;
+
+//多速率调度
+typedef struct {
+    float inner_period;             //内环周期 ms，由TIM4的PSC/ARR与时钟推算
+    float outer_period;             //外环周期 ms
+    uint8_t outer_div;              //外环分频
+    uint8_t count;                  //分频计数
+}ControlSchedule;
+
+#define PID_TUNE_PERIOD     10.0f   //模式表中pid参数整定时的控制周期 ms
+#define OUTER_DIV_DEFAULT   10      //默认外环分频：1kHz内环 / 10 = 100Hz外环
+#define VELOCITY_CUTOFF     16.0f   //速度反馈低通截止频率 Hz（10ms周期下alpha约0.5）
+
+//曲线模式默认运动参数（menu传入<=0时使用）
+#define PLAN_SPEED_VMAX     380.0f  //速度曲线目标上限 rpm
+#define PLAN_SPEED_AMAX     1000.0f //速度曲线加速度 rpm/s
+#define PLAN_POSITION_VMAX  1800.0f //位置曲线最大速度 °/s
+#define PLAN_POSITION_AMAX  7200.0f //位置曲线加速度 °/s²
+#define PLAN_JERK_RATIO     10.0f   //默认加加速度 = 加速度 * 10/s（加速度爬升100ms）
+
 //控制电机状态
 #define AIN1(state) HAL_GPIO_WritePin(AIN1_GPIO_Port, AIN1_Pin, (GPIO_PinState)(state));
 #define AIN2(state) HAL_GPIO_WritePin(AIN2_GPIO_Port, AIN2_Pin, (GPIO_PinState)(state));
 #define BIN1(state) HAL_GPIO_WritePin(BIN1_GPIO_Port, BIN1_Pin, (GPIO_PinState)(state));
 #define BIN2(state) HAL_GPIO_WritePin(BIN2_GPIO_Port, BIN2_Pin, (GPIO_PinState)(state));
 
-void mg513_Start(void);         //打开电机
+void mg513_Start(void);         //打开电机（清空当前模式控制环的积分和上次输出）
 void mg513_Stop(void);          //暂停电机
 void mg513_EncoderInit(void);   //编码器初始化
+void mg513_EncoderEdge(uint16_t GPIO_Pin);  //编码器A相边沿（EXTI回调中调用）
 void mg513_InitPID(void);       //初始化电机控制环
+void mg513_PWM(Motor l_or_r, int16_t pwm_val);  //电机PWM驱动
 void mg513_SetPID(MotorMode);   //设置电机控制环参数
+void mg513_SetMode(MotorMode);  //切换电机模式（周期边界生效，与当前模式相同时重新进入）
+void mg513_ApplyMode(MotorMode);//立即切换电机模式
+void mg513_SetOuterDivider(uint8_t div);   //设置外环分频（下次切换模式时生效）
+const ControlSchedule* mg513_GetSchedule(void);   //读取当前调度周期
+void mg513_PlanSpeed(float target, float amax, float jmax);                 //速度曲线目标 rpm
+uint8_t mg513_PlanPosition(float target, float vmax, float amax, float jmax);   //追加位置指令 °，队列满返回0
+void mg513_ClearPosition(void);                                             //清空位置指令队列
+const MotionQueue* mg513_GetMotionQueue(void);                              //位置指令队列状态
+void mg513_GetTune(TuneLoop loop, PIDTune* tune);                           //读取控制环当前参数
+void mg513_Tune(TuneLoop loop, const PIDTune* tune);                        //提交新参数，下一个控制周期开始时无扰生效
+void mg513_Service(void);                                                   //主循环内调用：运行上位机请求的耗时任务
 
 #endif //__MG513_H__
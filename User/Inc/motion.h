@@ -0,0 +1,30 @@
+#ifndef __MOTION_H__
+#define __MOTION_H__
+
+#include "stdint.h"
+#include "planner.h"
+
+#define MOTION_QUEUE_SIZE   16          //指令队列长度，必须为2的幂
+
+//位置运动指令
+typedef struct {
+    float target;                       //目标位置
+    float vmax, amax, jmax;             //运动参数，jmax <= 0 为梯形轨迹
+}MotionCommand;
+
+//单轴指令队列：菜单/串口写入，控制中断取出执行
+typedef struct {
+    MotionCommand cmd[MOTION_QUEUE_SIZE];
+    volatile uint8_t head;              //写入位置（自由计数）
+    volatile uint8_t tail;              //读取位置（自由计数），只由控制中断修改
+    volatile uint8_t underrun;          //1：队列取空，轴已停止等待新指令
+    uint8_t active;                     //1：正在执行队列中的指令
+    float amax, jmax;                   //最近一条指令的加速度、加加速度，队列取空时按此减速停下
+}MotionQueue;
+
+void motion_Clear(MotionQueue* queue);                              //清空队列
+uint8_t motion_Push(MotionQueue* queue, const MotionCommand* cmd);  //追加指令，队列满返回0
+uint8_t motion_Count(const MotionQueue* queue);                     //队列占用（未开始执行的指令数）
+void motion_Run(MotionQueue* queue, MotionPlan* plan, float dt);    //控制中断内调用：取指令、规划并推进dt秒
+
+#endif //__MOTION_H__
@@ -11,6 +11,21 @@ typedef struct {
     float integral;     //累积误差
 }Error;
 
+//旧的S曲线（setCurve/VelocityCurve/PositionCurve）：mg513的曲线模式已改用planner.c，固件中没有调用
+//目标板上默认不编译（省去约1KB的查表RAM），主机仿真编译，用于查表误差测试和基准比较
+#ifndef PID_CURVE
+#if defined(__arm__)
+#define PID_CURVE           0
+#else
+#define PID_CURVE           1
+#endif
+#endif
+
+//S曲线查表：表长与采样范围，表占用 (CURVE_TABLE_SIZE + 1) * 4 字节RAM
+//插值误差约为 (2 * RANGE / SIZE)^2 / 80，256点/±12时约1.1e-4（相对幅值）
+#define CURVE_TABLE_SIZE    256
+#define CURVE_TABLE_RANGE   12.0f
+
 //曲线
 typedef struct {
     float start;       //初始
@@ -23,6 +38,34 @@ typedef struct {
     float A,B,C,D;
 }Curve;
 
+//------定点数 Q16.16------//
+typedef int32_t q16_t;
+
+#define Q16_ONE         ((q16_t) 0x00010000)
+#define Q16_MAX         ((q16_t) 0x7FFFFFFF)
+#define Q16_MIN         ((q16_t) 0x80000000)
+#define Q16(x)          ((q16_t) ((x) * 65536.0f))     //编译期常量转换
+
+q16_t q16_FromFloat(float x);       //浮点转定点（饱和）
+float q16_ToFloat(q16_t x);         //定点转浮点
+
+//定点误差
+typedef struct {
+    q16_t now;
+    q16_t last;
+    q16_t pre;
+    q16_t integral;
+}ErrorQ;
+
+//定点pid，结构与PID一致，全部运算为饱和整数运算
+typedef struct {
+    q16_t kp, ki, kd;
+    q16_t target, input, output, output_last;
+    ErrorQ error;
+    q16_t MAX_OUTPUT;
+    q16_t MAX_ERROR_INTEGRAL;
+}PIDQ;
+
 typedef struct {
     // kp ki kd
     float kp, ki, kd;
@@ -39,15 +82,33 @@ typedef struct {
     //limit
     float MAX_OUTPUT;
     float MAX_ERROR_INTEGRAL;
+
+    //定点运算
+    uint8_t fixed;      //1：使用定点实现计算
+    PIDQ q;
 }PID;
 
 void initPID(PID* pid, const float MAX_OUTPUT, const float MAX_E_I);
+void resetPID(PID* pid);
 void setPIDParam(PID* pid, float kp, float ki, float kd);
 void setPIDTarget(PID* pid, float target);
-void setCurve(Curve* curve, float start, float target, float acceleration, float Max);
 void updatePID_Position(PID* pid, float input);
 void updatePID_Speed(PID* pid, float input);
+#if PID_CURVE
+void setCurve(Curve* curve, float start, float target, float acceleration, float Max);
+void initCurveTable(void);
+float sigmoidLookup(float x);
 void VelocityCurve(Curve *curve);
 void PositionCurve(Curve* curve);
+#endif
+void setPIDFixed(PID* pid, uint8_t fixed);
+void setPIDLimit(PID* pid, float MAX_OUTPUT, float MAX_E_I);
+void setPIDParamBumpless(PID* pid, float kp, float ki, float kd);
+
+void initPIDQ(PIDQ* pid, const float MAX_OUTPUT, const float MAX_E_I);
+void setPIDQParam(PIDQ* pid, float kp, float ki, float kd);
+void setPIDQTarget(PIDQ* pid, q16_t target);
+void updatePIDQ_Speed(PIDQ* pid, q16_t input);
+void updatePIDQ_Position(PIDQ* pid, q16_t input);
 
 #endif //__PID_H__
@@ -0,0 +1,31 @@
+#ifndef __PLANNER_H__
+#define __PLANNER_H__
+
+#include "stdint.h"
+
+#define PLAN_MAX_SEGMENTS   7           //S曲线最多7段
+
+//轨迹段：段内加加速度恒定
+typedef struct {
+    float T;                            //段时长  s
+    float j;                            //加加速度
+    float p0, v0, a0;                   //段起点状态
+}PlanSegment;
+
+//运动规划结果及执行状态
+typedef struct {
+    PlanSegment seg[PLAN_MAX_SEGMENTS];
+    uint8_t count;                      //段数
+    uint8_t index;                      //当前段
+    float t;                            //当前段内时间  s
+    float p, v, a;                      //当前规划状态
+    uint8_t done;                       //1：规划执行完毕，保持末速度
+}MotionPlan;
+
+void planner_Reset(MotionPlan* plan, float p, float v);        //停在指定状态
+uint8_t planner_Velocity(MotionPlan* plan, float v1, float amax, float jmax);
+uint8_t planner_Position(MotionPlan* plan, float p1, float v1, float vmax, float amax, float jmax);
+void planner_Step(MotionPlan* plan, float dt);                  //推进dt秒并更新p v a
+float planner_Duration(const MotionPlan* plan);                 //总时长  s
+
+#endif //__PLANNER_H__
@@ -0,0 +1,39 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include "stdint.h"
+
+#define PROFILER_MAX_MODES      8       //按MotorMode统计
+#define PROFILER_HIST_BINS      8       //起始抖动直方图格数，最后一格为溢出格
+#define PROFILER_HIST_SHIFT     6       //每格宽度 2^6 = 64 周期（72MHz下约0.9us）
+#define PROFILER_REPORT_TICKS   1000    //每隔多少个控制节拍上报一次
+
+//上报帧的mode字段：高位标记统计帧，低位为MotorMode
+#define PROFILER_FRAME_TIMING   0x80    //ch: min, max, mean   （周期数）
+#define PROFILER_FRAME_OVERRUN  0x90    //ch: overrun, count, 最大抖动（周期数）
+
+//控制步耗时统计
+typedef struct {
+    uint32_t min;                       //最短耗时  周期
+    uint32_t max;                       //最长耗时  周期
+    uint64_t sum;                       //累计耗时  周期
+    uint32_t count;                     //统计次数
+    uint32_t overrun;                   //超过控制周期的次数
+    uint32_t jitter_max;                //最大起始抖动  周期
+    uint32_t hist[PROFILER_HIST_BINS];  //起始抖动直方图
+}ProfilerStats;
+
+void profiler_Init(void);                       //打开周期计数器并清空统计
+void profiler_SetPeriod(uint32_t cycles);       //设置控制周期（周期数）
+void profiler_Resync(void);                     //定时器重新启动后丢弃第一次间隔
+void profiler_Reset(void);                      //清空统计
+void profiler_Begin(void);                      //控制中断入口调用
+void profiler_End(uint8_t mode);                //控制中断出口调用
+void profiler_Report(uint8_t mode);             //上报一个模式的统计（控制中断内调用）
+uint32_t profiler_Mean(const ProfilerStats* stats);             //平均耗时
+uint32_t profiler_CyclesToUs(uint32_t cycles);                  //周期数换算为us
+const ProfilerStats* profiler_Get(uint8_t mode);                //读取统计
+uint32_t profiler_Now(void);                                    //当前计数（目标板为CPU周期，主机为ns）
+uint32_t profiler_ClockHz(void);                                //计数频率
+
+#endif //__PROFILER_H__
@@ -0,0 +1,34 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "stdint.h"
+
+#define TELEMETRY_HEAD0     0xAA        //帧头
+#define TELEMETRY_HEAD1     0x55
+#define TELEMETRY_CHANNELS  3           //每帧通道数
+#define TELEMETRY_BUF_SIZE  512         //发送环形缓冲区大小，必须为2的幂
+
+//遥测帧（小端，定长24字节）
+typedef struct __attribute__((packed)) {
+    uint8_t  head[2];                   //帧头 0xAA 0x55
+    uint8_t  mode;                      //电机模式 MotorMode
+    uint8_t  count;                     //有效通道数
+    uint16_t seq;                       //帧序号
+    uint32_t timestamp;                 //时间戳    ms
+    float    ch[TELEMETRY_CHANNELS];    //通道数据
+    uint16_t crc;                       //CRC16-CCITT(0xFFFF)，校验head~ch
+}TelemetryFrame;
+
+//上位机指令：与遥测帧格式相同，mode字段为指令号，ch为参数
+#define TELEMETRY_CMD_MOVE      0x40    //追加位置指令  ch: 目标角度°  最大速度°/s  加速度°/s²
+#define TELEMETRY_CMD_CLEAR     0x41    //清空指令队列
+#define TELEMETRY_CMD_BENCH     0x42    //运行基准测试（电机停止时，主循环内运行），结果帧 0xB0 | 序号
+#define TELEMETRY_CMD_ACK       0xA0    //应答帧  ch: 队列占用  欠载标志  指令是否接受
+
+void telemetry_Init(void);                                          //初始化遥测
+void telemetry_Send(uint8_t mode, const float* ch, uint8_t count); //写入一帧（控制中断内调用）
+uint32_t telemetry_Dropped(void);                                  //缓冲区满丢弃的帧数
+uint16_t telemetry_CRC16(const uint8_t* data, uint16_t len);       //CRC16-CCITT
+void telemetry_Command(uint8_t cmd, const float* arg, uint8_t count);   //收到上位机指令（串口中断内调用，弱定义）
+
+#endif //__TELEMETRY_H__
@@ -22,8 +22,6 @@
 #include "gpio.h"
 #include "../Inc/OLED.h"
 #include <string.h>
-#include <math.h>
-#include <stdio.h>
 #include <stdarg.h>
 
 /**
@@ -82,11 +80,25 @@
   */
 uint8_t OLED_DisplayBuf[8][128];
 
+/**
+  * 屏幕内容副本及脏区
+  * OLED_ShadowBuf记录已经发送到OLED硬件的数据
+  * 显存控制、显示、绘图函数修改显存时，在OLED_DirtyX0/OLED_DirtyX1中记录每页被修改的列范围
+  * OLED_Update只比较脏区内与副本不同的字节，只发送这些字节
+  */
+static uint8_t OLED_ShadowBuf[8][128];
+static uint8_t OLED_DirtyX0[8];			//每页脏区起始列，大于OLED_DirtyX1表示该页无修改
+static uint8_t OLED_DirtyX1[8];			//每页脏区结束列（含）
+static uint8_t OLED_ShadowValid;		//0：副本与屏幕不一致（上电、强制刷新），脏区全部发送
+static uint32_t OLED_TxCount;			//累计发送字节数（含地址、控制字节）
+
 /*********************全局变量*/
 
 
 /*引脚配置*********************/
 
+#if OLED_BACKEND == OLED_BACKEND_SOFT
+
 /**
   * 函    数：OLED写SCL高低电平
   * 参    数：要写入SCL的电平值，范围：0/1
@@ -121,12 +133,56 @@ void OLED_W_SDA(uint8_t BitValue)
 	//...
 }
 
+#elif OLED_BACKEND == OLED_BACKEND_FAST
+
+/*SCL、SDA同在GPIOB，BSRR低16位置位、高16位复位，一次写入即可改变引脚，无需读改写*/
+#define OLED_SCL_SET			((uint32_t) OLED_SCL_Pin)
+#define OLED_SCL_RESET			((uint32_t) OLED_SCL_Pin << 16)
+#define OLED_SDA_SET			((uint32_t) OLED_SDA_Pin)
+#define OLED_SDA_RESET			((uint32_t) OLED_SDA_Pin << 16)
+
+/*写BSRR，主机仿真时由桩头文件重新定义以便解析引脚波形*/
+#ifndef OLED_BSRR_WRITE
+#define OLED_BSRR_WRITE(Value)	(OLED_SCL_GPIO_Port->BSRR = (Value))
+#endif
+
+/**
+  * 函    数：OLED写SCL高低电平
+  * 参    数：要写入SCL的电平值，范围：0/1
+  * 返 回 值：无
+  * 说    明：直接写BSRR，之后延时OLED_FAST_DELAY个空指令，保证SCL高低电平时间
+  */
+static inline void OLED_W_SCL(uint8_t BitValue)
+{
+	uint8_t i;
+	
+	OLED_BSRR_WRITE(BitValue ? OLED_SCL_SET : OLED_SCL_RESET);
+	for (i = 0; i < OLED_FAST_DELAY; i ++)
+	{
+		__NOP();
+	}
+}
+
+/**
+  * 函    数：OLED写SDA高低电平
+  * 参    数：要写入SDA的电平值，范围：0/1
+  * 返 回 值：无
+  * 说    明：直接写BSRR，SDA只在SCL低电平期间改变，不需要额外延时
+  */
+static inline void OLED_W_SDA(uint8_t BitValue)
+{
+	OLED_BSRR_WRITE(BitValue ? OLED_SDA_SET : OLED_SDA_RESET);
+}
+
+#endif
+
 /**
   * 函    数：OLED引脚初始化
   * 参    数：无
   * 返 回 值：无
   * 说    明：当上层函数需要初始化时，此函数会被调用
-  *           用户需要将SCL和SDA引脚初始化为开漏模式，并释放引脚
+  *           软件I2C：SCL和SDA引脚已由MX_GPIO_Init初始化，在此释放引脚
+  *           硬件I2C：PB8/PB9重映射为I2C1复用开漏，配置400kHz快速模式、DMA通道和中断
   */
 void OLED_GPIO_Init(void)
 {
@@ -139,16 +195,99 @@ void OLED_GPIO_Init(void)
 	}
     MX_GPIO_Init();
 
+#if OLED_BACKEND == OLED_BACKEND_SOFT || OLED_BACKEND == OLED_BACKEND_FAST
 	/*释放SCL和SDA*/
 	OLED_W_SCL(1);
 	OLED_W_SDA(1);
+#elif OLED_BACKEND == OLED_BACKEND_I2C1
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	
+	/*PB8 SCL、PB9 SDA：I2C1重映射*/
+	__HAL_RCC_AFIO_CLK_ENABLE();
+	__HAL_AFIO_REMAP_I2C1_ENABLE();
+	GPIO_InitStruct.Pin = OLED_SCL_Pin | OLED_SDA_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_OD;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+	HAL_GPIO_Init(OLED_SCL_GPIO_Port, &GPIO_InitStruct);
+	
+	OLED_I2C1_Init();
+#endif
+}
+
+#if OLED_BACKEND == OLED_BACKEND_I2C1
+/**
+  * 函    数：I2C1及其DMA通道初始化
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：上电初始化和通信超时后调用
+  */
+void OLED_I2C1_Init(void)
+{
+	uint32_t PCLK1 = HAL_RCC_GetPCLK1Freq();
+	
+	/*复位I2C1，清除引脚切换时可能锁住的BUSY标志*/
+	__HAL_RCC_I2C1_CLK_ENABLE();
+	I2C1->CR1 = I2C_CR1_SWRST;
+	I2C1->CR1 = 0;
+	
+	/*快速模式，Tlow:Thigh = 2:1，SCL周期 = 3 * CCR / PCLK1*/
+	I2C1->CR2 = PCLK1 / 1000000;
+	I2C1->CCR = I2C_CCR_FS | (PCLK1 / (3 * OLED_I2C_SPEED));
+	I2C1->TRISE = PCLK1 / 1000000 * 300 / 1000 + 1;		//上升时间最大300ns
+	I2C1->CR1 = I2C_CR1_PE;
+	
+	/*DMA1通道6为I2C1_TX：存储器到外设，存储器地址递增*/
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	DMA1_Channel6->CCR = 0;
+	DMA1_Channel6->CPAR = (uint32_t) &I2C1->DR;
+	DMA1_Channel6->CCR = DMA_CCR_DIR | DMA_CCR_MINC;
+	
+	/*事件和错误中断，优先级低于控制节拍*/
+	HAL_NVIC_SetPriority(I2C1_EV_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+	HAL_NVIC_SetPriority(I2C1_ER_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
 }
+#endif
 
 /*********************引脚配置*/
 
 
 /*通信协议*********************/
 
+/**
+  * 传输队列
+  * 一次传输为一个完整的I2C帧：起始、从机地址、控制字节、Count个字节、终止
+  * OLED_Update把需要发送的段整理成队列后立即返回，由后端依次发送
+  * 数据取自OLED_ShadowBuf，发送期间上层可以继续在OLED_DisplayBuf中绘制
+  */
+typedef struct
+{
+	uint8_t Control;			//控制字节，0x00：命令，0x40：数据
+	uint8_t Count;				//字节数
+	const uint8_t *Data;		//数据
+} OLED_Transfer;
+
+static OLED_Transfer OLED_Queue[OLED_MAX_TRANSFERS];
+static uint8_t OLED_CursorCmd[OLED_MAX_TRANSFERS / 2][3];	//每段的设置光标命令
+static volatile uint8_t OLED_QueueIndex;	//正在发送的传输
+static volatile uint8_t OLED_QueueCount;	//队列中的传输数
+static volatile uint8_t OLED_Busy;			//1：正在发送
+static uint32_t OLED_ErrorCount;			//通信错误次数（无应答、总线错误、超时）
+static volatile uint8_t OLED_Lost;			//1：发送出错，屏幕内容未知，下次更新发送整个屏幕
+
+/**
+  * 函    数：发送完成回调
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：队列全部发送完毕后调用，硬件I2C时在中断中调用，弱定义，可在其他文件中重新实现
+  */
+__weak void OLED_UpdateCallback(void)
+{
+}
+
+#if OLED_BACKEND == OLED_BACKEND_SOFT || OLED_BACKEND == OLED_BACKEND_FAST
+
 /**
   * 函    数：I2C起始
   * 参    数：无
@@ -197,6 +336,256 @@ void OLED_I2C_SendByte(uint8_t Byte)
 	OLED_W_SCL(0);
 }
 
+/**
+  * 函    数：发送队列
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：软件I2C没有后台发送能力，在此依次发送完全部传输后返回
+  */
+static void OLED_StartQueue(void)
+{
+	uint8_t i, k;
+	
+	for (k = 0; k < OLED_QueueCount; k ++)
+	{
+		OLED_I2C_Start();							//I2C起始
+		OLED_I2C_SendByte(0x78);					//发送OLED的I2C从机地址
+		OLED_I2C_SendByte(OLED_Queue[k].Control);	//控制字节
+		for (i = 0; i < OLED_Queue[k].Count; i ++)
+		{
+			OLED_I2C_SendByte(OLED_Queue[k].Data[i]);
+		}
+		OLED_I2C_Stop();							//I2C终止
+	}
+	OLED_QueueCount = 0;
+	OLED_Busy = 0;
+	OLED_UpdateCallback();
+}
+
+#elif OLED_BACKEND == OLED_BACKEND_I2C1
+
+/**
+  * 函    数：结束当前队列
+  * 参    数：Error 1：因通信错误结束
+  * 返 回 值：无
+  * 说    明：出错时屏幕内容未知，下次更新发送整个屏幕
+  */
+static void OLED_FinishQueue(uint8_t Error)
+{
+	I2C1->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITERREN | I2C_CR2_DMAEN);
+	DMA1_Channel6->CCR &= ~DMA_CCR_EN;
+	OLED_QueueCount = 0;
+	OLED_Busy = 0;
+	if (Error)
+	{
+		OLED_ErrorCount ++;
+		OLED_Lost = 1;
+	}
+	OLED_UpdateCallback();
+}
+
+/**
+  * 函    数：发送队列
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：产生第一个起始条件后立即返回，其余步骤在I2C1事件中断中完成
+  *           上一次队列的终止条件未能发出时（总线被占用）放弃本次队列并复位I2C1
+  */
+static void OLED_StartQueue(void)
+{
+	uint16_t i;
+	
+	for (i = 0; I2C1->CR1 & I2C_CR1_STOP; i ++)
+	{
+		if (i >= OLED_STOP_WAIT)
+		{
+			OLED_FinishQueue(1);
+			OLED_I2C1_Init();
+			return;
+		}
+	}
+	
+	OLED_QueueIndex = 0;
+	I2C1->CR2 |= I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+	I2C1->CR1 |= I2C_CR1_START;
+}
+
+/**
+  * 函    数：I2C1事件中断处理
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：在I2C1_EV_IRQHandler中调用
+  *           SB：发送从机地址
+  *           ADDR：写入控制字节，剩余字节交给DMA
+  *           BTF且DMA发送完毕：以重复起始条件开始下一帧，或终止并结束队列
+  *           BTF而DMA未发送完毕：DMA未及时写入，由CPU写入下一个字节
+  */
+void OLED_I2C_EventIRQHandler(void)
+{
+	uint32_t SR1 = I2C1->SR1;
+	const OLED_Transfer *Transfer = &OLED_Queue[OLED_QueueIndex];
+	
+	if (SR1 & I2C_SR1_SB)
+	{
+		I2C1->DR = 0x78;							//发送OLED的I2C从机地址
+	}
+	else if (SR1 & I2C_SR1_ADDR)
+	{
+		(void) I2C1->SR2;							//读SR1后读SR2，清除ADDR
+		I2C1->DR = Transfer->Control;				//控制字节
+		if (Transfer->Count > 0)
+		{
+			DMA1_Channel6->CCR &= ~DMA_CCR_EN;
+			DMA1_Channel6->CMAR = (uint32_t) Transfer->Data;
+			DMA1_Channel6->CNDTR = Transfer->Count;
+			DMA1_Channel6->CCR |= DMA_CCR_EN;
+			I2C1->CR2 |= I2C_CR2_DMAEN;
+		}
+	}
+	else if (SR1 & I2C_SR1_BTF)
+	{
+		uint16_t Left = DMA1_Channel6->CNDTR;
+		
+		if (Left > 0)
+		{
+			/*停止DMA后重新读取剩余字节数：停止前DMA可能刚写入一个字节*/
+			DMA1_Channel6->CCR &= ~DMA_CCR_EN;
+			Left = DMA1_Channel6->CNDTR;
+			if (Left > 0)
+			{
+				const uint8_t *Next = &Transfer->Data[Transfer->Count - Left];
+				
+				I2C1->DR = *Next;						//写DR清除BTF
+				if (-- Left > 0)
+				{
+					DMA1_Channel6->CMAR = (uint32_t) (Next + 1);
+					DMA1_Channel6->CNDTR = Left;
+					DMA1_Channel6->CCR |= DMA_CCR_EN;
+				}
+			}
+			return;
+		}
+		
+		I2C1->CR2 &= ~I2C_CR2_DMAEN;
+		DMA1_Channel6->CCR &= ~DMA_CCR_EN;
+		
+		if (++ OLED_QueueIndex < OLED_QueueCount)
+		{
+			/*重复起始条件，BTF随之清除，下一帧的从机地址在随后的SB事件中发送，中断内不等待终止条件*/
+			I2C1->CR1 |= I2C_CR1_START;
+		}
+		else
+		{
+			I2C1->CR1 |= I2C_CR1_STOP;				//终止，BTF随之清除
+			OLED_FinishQueue(0);
+		}
+	}
+}
+
+/**
+  * 函    数：I2C1错误中断处理
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：在I2C1_ER_IRQHandler中调用，无应答（OLED未连接）、总线错误、仲裁丢失时放弃队列
+  */
+void OLED_I2C_ErrorIRQHandler(void)
+{
+	I2C1->SR1 &= ~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR);
+	I2C1->CR1 |= I2C_CR1_STOP;
+	OLED_FinishQueue(1);
+}
+
+#else
+
+/**
+  * 函    数：发送队列
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：主机仿真，每一帧交给OLED_HostTransmit（由仿真程序实现的模拟I2C从机）
+  */
+static void OLED_StartQueue(void)
+{
+	uint8_t k;
+	
+	for (k = 0; k < OLED_QueueCount; k ++)
+	{
+		OLED_HostTransmit(OLED_Queue[k].Control, OLED_Queue[k].Data, OLED_Queue[k].Count);
+	}
+	OLED_QueueCount = 0;
+	OLED_Busy = 0;
+	OLED_UpdateCallback();
+}
+
+#endif
+
+/**
+  * 函    数：查询是否正在发送
+  * 参    数：无
+  * 返 回 值：1：上一次更新还在发送，0：空闲
+  */
+uint8_t OLED_IsBusy(void)
+{
+	return OLED_Busy;
+}
+
+/**
+  * 函    数：等待发送完成
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：硬件I2C超过OLED_TIMEOUT_MS仍未完成时复位I2C1并放弃队列
+  */
+void OLED_WaitIdle(void)
+{
+#if OLED_BACKEND == OLED_BACKEND_I2C1
+	uint32_t Start = HAL_GetTick();
+	
+	while (OLED_Busy)
+	{
+		if (HAL_GetTick() - Start > OLED_TIMEOUT_MS)
+		{
+			HAL_NVIC_DisableIRQ(I2C1_EV_IRQn);
+			OLED_FinishQueue(1);
+			OLED_I2C1_Init();
+			break;
+		}
+	}
+#else
+	while (OLED_Busy);
+#endif
+}
+
+/**
+  * 函    数：追加一次传输
+  * 参    数：Control 控制字节，0x00：命令，0x40：数据
+  * 参    数：Data 要写入数据的起始地址，发送完成前不能修改
+  * 参    数：Count 要写入数据的数量
+  * 返 回 值：无
+  * 说    明：调用前需保证队列空闲且未满
+  */
+static void OLED_Queue_Push(uint8_t Control, const uint8_t *Data, uint8_t Count)
+{
+	OLED_Queue[OLED_QueueCount].Control = Control;
+	OLED_Queue[OLED_QueueCount].Data = Data;
+	OLED_Queue[OLED_QueueCount].Count = Count;
+	OLED_QueueCount ++;
+	OLED_TxCount += 2 + Count;		//从机地址、控制字节和数据
+}
+
+/**
+  * 函    数：发送已追加的传输并等待完成
+  * 参    数：无
+  * 返 回 值：无
+  */
+static void OLED_Queue_Flush(void)
+{
+	if (OLED_QueueCount > 0)
+	{
+		OLED_Busy = 1;
+		OLED_StartQueue();
+		OLED_WaitIdle();
+	}
+}
+
 /**
   * 函    数：OLED写命令
   * 参    数：Command 要写入的命令值，范围：0x00~0xFF
@@ -204,11 +593,26 @@ void OLED_I2C_SendByte(uint8_t Byte)
   */
 void OLED_WriteCommand(uint8_t Command)
 {
-	OLED_I2C_Start();				//I2C起始
-	OLED_I2C_SendByte(0x78);		//发送OLED的I2C从机地址
-	OLED_I2C_SendByte(0x00);		//控制字节，给0x00，表示即将写命令
-	OLED_I2C_SendByte(Command);		//写入指定的命令
-	OLED_I2C_Stop();				//I2C终止
+	static uint8_t Buffer;
+	
+	OLED_WaitIdle();
+	Buffer = Command;
+	OLED_Queue_Push(0x00, &Buffer, 1);		//控制字节0x00，表示写命令
+	OLED_Queue_Flush();
+}
+
+/**
+  * 函    数：OLED连续写多条命令
+  * 参    数：Command 要写入的命令序列（含命令参数）
+  * 参    数：Count 命令序列的字节数
+  * 返 回 值：无
+  * 说    明：控制字节0x00之后的所有字节都按命令解析，整个序列只需一次起始和终止
+  */
+void OLED_WriteCommands(const uint8_t *Command, uint8_t Count)
+{
+	OLED_WaitIdle();
+	OLED_Queue_Push(0x00, Command, Count);
+	OLED_Queue_Flush();
 }
 
 /**
@@ -219,17 +623,30 @@ void OLED_WriteCommand(uint8_t Command)
   */
 void OLED_WriteData(uint8_t *Data, uint8_t Count)
 {
-	uint8_t i;
-	
-	OLED_I2C_Start();				//I2C起始
-	OLED_I2C_SendByte(0x78);		//发送OLED的I2C从机地址
-	OLED_I2C_SendByte(0x40);		//控制字节，给0x40，表示即将写数据
-	/*循环Count次，进行连续的数据写入*/
-	for (i = 0; i < Count; i ++)
-	{
-		OLED_I2C_SendByte(Data[i]);	//依次发送Data的每一个数据
-	}
-	OLED_I2C_Stop();				//I2C终止
+	OLED_WaitIdle();
+	OLED_Queue_Push(0x40, Data, Count);		//控制字节0x40，表示写数据
+	OLED_Queue_Flush();
+}
+
+/**
+  * 函    数：读取累计发送字节数
+  * 参    数：无
+  * 返 回 值：自上电以来经I2C发送的字节数，含从机地址和控制字节
+  * 说    明：两次读取之差即为一帧的通信量，用于评估刷新开销
+  */
+uint32_t OLED_GetTxCount(void)
+{
+	return OLED_TxCount;
+}
+
+/**
+  * 函    数：读取通信错误次数
+  * 参    数：无
+  * 返 回 值：无应答、总线错误、超时的累计次数
+  */
+uint32_t OLED_GetErrorCount(void)
+{
+	return OLED_ErrorCount;
 }
 
 /*********************通信协议*/
@@ -247,57 +664,62 @@ void OLED_Init(void)
 {
 	OLED_GPIO_Init();			//先调用底层的端口初始化
 	
-	/*写入一系列的命令，对OLED进行初始化配置*/
-	OLED_WriteCommand(0xAE);	//设置显示开启/关闭，0xAE关闭，0xAF开启
-	
-	OLED_WriteCommand(0xD5);	//设置显示时钟分频比/振荡器频率
-	OLED_WriteCommand(0x80);	//0x00~0xFF
-	
-	OLED_WriteCommand(0xA8);	//设置多路复用率
-	OLED_WriteCommand(0x3F);	//0x0E~0x3F
-	
-	OLED_WriteCommand(0xD3);	//设置显示偏移
-	OLED_WriteCommand(0x00);	//0x00~0x7F
-	
-	OLED_WriteCommand(0x40);	//设置显示开始行，0x40~0x7F
-	
-	OLED_WriteCommand(0xA1);	//设置左右方向，0xA1正常，0xA0左右反置
-	
-	OLED_WriteCommand(0xC8);	//设置上下方向，0xC8正常，0xC0上下反置
+	/*写入一系列的命令，对OLED进行初始化配置，全部命令在同一帧中发送*/
+	static const uint8_t InitCommand[] = {
+		0xAE,		//设置显示开启/关闭，0xAE关闭，0xAF开启
 
-	OLED_WriteCommand(0xDA);	//设置COM引脚硬件配置
-	OLED_WriteCommand(0x12);
-	
-	OLED_WriteCommand(0x81);	//设置对比度
-	OLED_WriteCommand(0xCF);	//0x00~0xFF
+		0xD5,		//设置显示时钟分频比/振荡器频率
+		0x80,		//0x00~0xFF
+
+		0xA8,		//设置多路复用率
+		0x3F,		//0x0E~0x3F
+
+		0xD3,		//设置显示偏移
+		0x00,		//0x00~0x7F
+
+		0x40,		//设置显示开始行，0x40~0x7F
+
+		0xA1,		//设置左右方向，0xA1正常，0xA0左右反置
+
+		0xC8,		//设置上下方向，0xC8正常，0xC0上下反置
+
+		0xDA,		//设置COM引脚硬件配置
+		0x12,
 
-	OLED_WriteCommand(0xD9);	//设置预充电周期
-	OLED_WriteCommand(0xF1);
+		0x81,		//设置对比度
+		0xCF,		//0x00~0xFF
 
-	OLED_WriteCommand(0xDB);	//设置VCOMH取消选择级别
-	OLED_WriteCommand(0x30);
+		0xD9,		//设置预充电周期
+		0xF1,
 
-	OLED_WriteCommand(0xA4);	//设置整个显示打开/关闭
+		0xDB,		//设置VCOMH取消选择级别
+		0x30,
 
-	OLED_WriteCommand(0xA6);	//设置正常/反色显示，0xA6正常，0xA7反色
+		0xA4,		//设置整个显示打开/关闭
 
-	OLED_WriteCommand(0x8D);	//设置充电泵
-	OLED_WriteCommand(0x14);
+		0xA6,		//设置正常/反色显示，0xA6正常，0xA7反色
 
-	OLED_WriteCommand(0xAF);	//开启显示
+		0x8D,		//设置充电泵
+		0x14,
+
+		0xAF,		//开启显示
+	};
+	
+	OLED_WriteCommands(InitCommand, sizeof(InitCommand));
 	
 	OLED_Clear();				//清空显存数组
+	OLED_Invalidate();			//屏幕内容未知，全部发送
 	OLED_Update();				//更新显示，清屏，防止初始化后未显示内容时花屏
 }
 
 /**
-  * 函    数：OLED设置显示光标位置
+  * 函    数：生成设置光标位置的命令
+  * 参    数：Command 命令缓冲，3字节
   * 参    数：Page 指定光标所在的页，范围：0~7
   * 参    数：X 指定光标所在的X轴坐标，范围：0~127
   * 返 回 值：无
-  * 说    明：OLED默认的Y轴，只能8个Bit为一组写入，即1页等于8个Y轴坐标
   */
-void OLED_SetCursor(uint8_t Page, uint8_t X)
+static void OLED_CursorCommand(uint8_t *Command, uint8_t Page, uint8_t X)
 {
 	/*如果使用此程序驱动1.3寸的OLED显示屏，则需要解除此注释*/
 	/*因为1.3寸的OLED驱动芯片（SH1106）有132列*/
@@ -306,9 +728,26 @@ void OLED_SetCursor(uint8_t Page, uint8_t X)
 //	X += 2;
 	
 	/*通过指令设置页地址和列地址*/
-	OLED_WriteCommand(0xB0 | Page);					//设置页位置
-	OLED_WriteCommand(0x10 | ((X & 0xF0) >> 4));	//设置X位置高4位
-	OLED_WriteCommand(0x00 | (X & 0x0F));			//设置X位置低4位
+	Command[0] = 0xB0 | Page;					//设置页位置
+	Command[1] = 0x10 | ((X & 0xF0) >> 4);		//设置X位置高4位
+	Command[2] = 0x00 | (X & 0x0F);				//设置X位置低4位
+}
+
+/**
+  * 函    数：OLED设置显示光标位置
+  * 参    数：Page 指定光标所在的页，范围：0~7
+  * 参    数：X 指定光标所在的X轴坐标，范围：0~127
+  * 返 回 值：无
+  * 说    明：OLED默认的Y轴，只能8个Bit为一组写入，即1页等于8个Y轴坐标
+  */
+void OLED_SetCursor(uint8_t Page, uint8_t X)
+{
+	static uint8_t Command[3];
+	
+	OLED_WaitIdle();
+	OLED_CursorCommand(Command, Page, X);
+	OLED_Queue_Push(0x00, Command, 3);		//三条命令在同一帧中发送
+	OLED_Queue_Flush();
 }
 
 /*********************硬件配置*/
@@ -319,73 +758,329 @@ void OLED_SetCursor(uint8_t Page, uint8_t X)
 /*工具函数仅供内部部分函数使用*/
 
 /**
-  * 函    数：次方函数
-  * 参    数：X 底数
-  * 参    数：Y 指数
-  * 返 回 值：等于X的Y次方
+  * 函    数：标记显存修改区域
+  * 参    数：X 区域左上角的横坐标，范围：-32768~32767
+  * 参    数：Y 区域左上角的纵坐标，范围：-32768~32767
+  * 参    数：Width 区域宽度
+  * 参    数：Height 区域高度
+  * 返 回 值：无
+  * 说    明：区域裁剪到屏幕内，按页合并到该页的脏区列范围
   */
-uint32_t OLED_Pow(uint32_t X, uint32_t Y)
+void OLED_MarkDirty(int16_t X, int16_t Y, int16_t Width, int16_t Height)
 {
-	uint32_t Result = 1;	//结果默认为1
-	while (Y --)			//累乘Y次
+	int16_t X1 = X + Width - 1, Y1 = Y + Height - 1;
+	int16_t j;
+	
+	if (X < 0) {X = 0;}
+	if (Y < 0) {Y = 0;}
+	if (X1 > 127) {X1 = 127;}
+	if (Y1 > 63) {Y1 = 63;}
+	if (X > X1 || Y > Y1) {return;}		//完全在屏幕外
+	
+	for (j = Y / 8; j <= Y1 / 8; j ++)
 	{
-		Result *= X;		//每次把X累乘到结果上
+		if (X < OLED_DirtyX0[j]) {OLED_DirtyX0[j] = X;}
+		if (X1 > OLED_DirtyX1[j]) {OLED_DirtyX1[j] = X1;}
 	}
-	return Result;
 }
 
+/*十进制各位的权：OLED_Pow10[i]等于10的i次方，取代逐位连乘*/
+static const uint32_t OLED_Pow10[10] =
+{
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
 /**
-  * 函    数：判断指定点是否在指定多边形内部
-  * 参    数：nvert 多边形的顶点数
-  * 参    数：vertx verty 包含多边形顶点的x和y坐标的数组
-  * 参    数：testx testy 测试点的X和y坐标
-  * 返 回 值：指定点是否在指定多边形内部，1：在内部，0：不在内部
+  * 函    数：计算数字的位数
+  * 参    数：Number 数字
+  * 参    数：Base 进制，10或16
+  * 返 回 值：不含前导零的位数，0的位数为1
   */
-uint8_t OLED_pnpoly(uint8_t nvert, int16_t *vertx, int16_t *verty, int16_t testx, int16_t testy)
+static uint8_t OLED_Digits(uint32_t Number, uint8_t Base)
 {
-	int16_t i, j, c = 0;
+	uint8_t Count = 1;
 	
-	/*此算法由W. Randolph Franklin提出*/
-	/*参考链接：https://wrfranklin.org/Research/Short_Notes/pnpoly.html*/
-	for (i = 0, j = nvert - 1; i < nvert; j = i++)
+	if (Base == 16)
+	{
+		while (Count < 8 && (Number >> (Count * 4)) != 0) {Count ++;}
+	}
+	else
 	{
-		if (((verty[i] > testy) != (verty[j] > testy)) &&
-			(testx < (vertx[j] - vertx[i]) * (testy - verty[i]) / (verty[j] - verty[i]) + vertx[i]))
+		while (Count < 10 && Number >= OLED_Pow10[Count]) {Count ++;}
+	}
+	return Count;
+}
+
+/**
+  * 函    数：将浮点数拆分为整数部分和指定位数的小数部分
+  * 参    数：Mantissa 尾数（含隐含的最高位），不超过53位
+  * 参    数：Exponent 指数，数值 = Mantissa * 2^Exponent
+  * 参    数：FraLength 小数位数，范围：0~9
+  * 参    数：IntNum 整数部分，超过32位时饱和
+  * 参    数：FraNum 小数部分，已按FraLength位四舍六入五成双，与printf一致
+  * 返 回 值：无
+  * 说    明：只用整数运算，不需要浮点库；小数乘以10^FraLength的积最多83位，用两个64位数精确表示
+  */
+static void OLED_SplitReal(uint64_t Mantissa, int16_t Exponent, uint8_t FraLength, uint32_t *IntNum, uint32_t *FraNum)
+{
+	uint64_t Int, Frac, Hi, Lo, Half;
+	uint32_t Pow = OLED_Pow10[FraLength];
+	int8_t Round = -1;			//舍去部分与0.5比较：-1小于，0等于，1大于
+	uint16_t n;
+	
+	*FraNum = 0;
+	if (Exponent >= 0)
+	{
+		Int = Exponent >= 64 || (Mantissa << Exponent) >> Exponent != Mantissa ? UINT64_MAX : Mantissa << Exponent;
+	}
+	else
+	{
+		n = -Exponent;
+		Int = n >= 64 ? 0 : Mantissa >> n;
+		Frac = n >= 64 ? Mantissa : Mantissa & (((uint64_t) 1 << n) - 1);	//小数 = Frac / 2^n
+		
+		/*Frac * 10^FraLength右移n位为保留的小数，移出的余数与2^(n-1)比较决定舍入*/
+		if (n <= 32)
+		{
+			Lo = Frac * Pow;
+			*FraNum = (uint32_t) (Lo >> n);
+			Lo &= ((uint64_t) 1 << n) - 1;
+			Half = (uint64_t) 1 << (n - 1);
+			Round = Lo < Half ? -1 : Lo > Half;
+		}
+		else if (n < 84)		//n >= 84时积小于2^83，余数必小于0.5
 		{
-			c = !c;
+			Lo = (Frac & 0xFFFFFFFFu) * Pow;
+			Hi = (Frac >> 32) * Pow + (Lo >> 32);		//积 = Hi * 2^32 + Lo
+			Lo &= 0xFFFFFFFFu;
+			*FraNum = (uint32_t) (Hi >> (n - 32));
+			Hi &= ((uint64_t) 1 << (n - 32)) - 1;
+			Half = (uint64_t) 1 << (n - 33);
+			Round = Hi < Half ? -1 : (Hi > Half || Lo != 0);
 		}
 	}
-	return c;
+	
+	/*大于0.5进位，恰好等于0.5时进位到偶数*/
+	if (Round > 0 || (Round == 0 && ((FraLength ? *FraNum : (uint32_t) Int) & 1)))
+	{
+		*FraNum += 1;
+		if (*FraNum >= Pow)		//进位到整数
+		{
+			*FraNum = 0;
+			Int ++;
+		}
+	}
+	*IntNum = Int > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t) Int;
+}
+
+/*圆弧边界方向：OLED_ArcCos[k]、OLED_ArcSin[k]为k * 3.14 / 180弧度的余弦和正弦，Q30定点数*/
+/*角度按3.14换算，与原先由atan2(Y, X) / 3.14 * 180计算角度的判断结果逐点一致*/
+static const int32_t OLED_ArcCos[181] =
+{
+	1073741824, 1073578454, 1073088392, 1072271789, 1071128893, 1069660051, 1067865711, 1065746418,
+	1063302817, 1060535653, 1057445766, 1054034098, 1050301686, 1046249667, 1041879272, 1037191833,
+	1032188776, 1026871622, 1021241991, 1015301594, 1009052240, 1002495831, 995634362, 988469920,
+	981004685, 973240930, 965181017, 956827398, 948182616, 939249301, 930030172, 920528034,
+	910745778, 900686381, 890352905, 879748493, 868876373, 857739854, 846342323, 834687249,
+	822778179, 810618738, 798212624, 785563613, 772675555, 759552370, 746198054, 732616668,
+	718812347, 704789290, 690551765, 676104105, 661450705, 646596026, 631544587, 616300968,
+	600869808, 585255803, 569463704, 553498317, 537364499, 521067161, 504611262, 488001810,
+	471243858, 454342506, 437302897, 420130216, 402829689, 385406581, 367866194, 350213864,
+	332454964, 314594898, 296639100, 278593034, 260462193, 242252092, 223968274, 205616302,
+	187201761, 168730255, 150207403, 131638844, 113030226, 94387213, 75715478, 57020703,
+	38308577, 19584793, 855049, -17874954, -36599519, -55312946, -74009541, -92683616,
+	-111329486, -129941479, -148513930, -167041189, -185517617, -203937591, -222295508, -240585779,
+	-258802840, -276941147, -294995181, -312959447, -330828479, -348596841, -366259123, -383809953,
+	-401243989, -418555926, -435740496, -452792470, -469706659, -486477915, -503101136, -519571263,
+	-535883284, -552032235, -568013202, -583821322, -599451784, -614899833, -630160768, -645229943,
+	-660102775, -674774737, -689241365, -703498255, -717541071, -731365537, -744967449, -758342667,
+	-771487120, -784396809, -797067805, -809496253, -821678370, -833610450, -845288861, -856710050,
+	-867870542, -878766939, -889395927, -899754272, -909838820, -919646503, -929174337, -938419422,
+	-947378946, -956050181, -964430489, -972517320, -980308213, -987800798, -994992794, -1001882012,
+	-1008466357, -1014743825, -1020712505, -1026370581, -1031716332, -1036748131, -1041464446, -1045863843,
+	-1049944982, -1053706623, -1057147619, -1060266924, -1063063589, -1065536763, -1067685693, -1069509725,
+	-1071008305, -1072180975, -1073027380, -1073547262, -1073740462
+};
+
+static const int32_t OLED_ArcSin[181] =
+{
+	0, 18729880, 37454060, 56166843, 74862534, 93535444, 112179892, 130790203,
+	149360714, 167885775, 186359748, 204777012, 223131962, 241419012, 259632599, 277767179,
+	295817234, 313777272, 331641827, 349405463, 367062775, 384608389, 402036967, 419343204,
+	436521835, 453567632, 470475407, 487240017, 503856359, 520319377, 536624062, 552765451,
+	568738633, 584538748, 600160986, 615600596, 630852877, 645913189, 660776950, 675439635,
+	689896784, 704143996, 718176936, 731991335, 745582988, 758947759, 772081582, 784980460,
+	797640467, 810057752, 822228535, 834149114, 845815860, 857225224, 868373733, 879257995,
+	889874698, 900220612, 910292587, 920087560, 929602549, 938834659, 947781081, 956439093,
+	964806059, 972879434, 980656760, 988135672, 995313893, 1002189239, 1008759619, 1015023031,
+	1020977571, 1026621427, 1031952881, 1036970311, 1041672190, 1046057087, 1050123667, 1053870695,
+	1057297028, 1060401625, 1063183540, 1065641928, 1067776040, 1069585227, 1071068938, 1072226722,
+	1073058227, 1073563198, 1073741484, 1073593028, 1073117878, 1072316177, 1071188169, 1069734197,
+	1067954704, 1065850232, 1063421420, 1060669009, 1057593834, 1054196833, 1050479039, 1046441583,
+	1042085694, 1037412698, 1032424016, 1027121166, 1021505762, 1015579513, 1009344222, 1002801787,
+	995954199, 988803540, 981351988, 973601810, 965555363, 957215097, 948583550, 939663348,
+	930457205, 920967924, 911198391, 901151579, 890830547, 880238433, 869378463, 858253939,
+	846868249, 835224855, 823327302, 811179209, 798784274, 786146268, 773269037, 760156500,
+	746812646, 733241537, 719447301, 705434137, 691206309, 676768146, 662124041, 647278452,
+	632235896, 617000949, 601578248, 585972487, 570188414, 554230831, 538104596, 521814615,
+	505365846, 488763293, 472012009, 455117091, 438083681, 420916962, 403622157, 386204529,
+	368669379, 351022043, 333267890, 315412324, 297460777, 279418713, 261291621, 243085019,
+	224804445, 206455463, 188043656, 169574627, 151053997, 132487401, 113880489, 95238923,
+	76568375, 57874528, 39163070, 20439694, 1710098
+};
+
+/**
+  * 函    数：判断指定点的方向角是否大于边界角
+  * 参    数：X Y 指定点相对圆心的坐标，范围：-255~255
+  * 参    数：K 边界角，单位为3.14/180弧度，范围：-181~181，不为0
+  * 返 回 值：1：指定点的方向角大于边界角，0：小于边界角
+  * 说    明：方向角范围与atan2相同，为(-π, π]，原点为0
+  *           点与边界在上下不同半平面时直接比较，在同一半平面时由边界向量与点的叉积符号判断
+  *           边界角不为0时，半径255以内的整数点离边界至少5e-7，Q30的误差不影响判断，不会恰好落在边界上
+  */
+static uint8_t OLED_AngleAbove(int16_t X, int16_t Y, int16_t K)
+{
+	int8_t Half, KHalf;
+	
+	if (K >= 181) {return 0;}		//边界超过π，任何点都不大于边界角
+	if (K <= -181) {return 1;}
+	
+	/*所在半平面：(0, π]为1，0为0，(-π, 0)为-1*/
+	Half = (Y > 0 || (Y == 0 && X < 0)) ? 1 : (Y == 0 ? 0 : -1);
+	KHalf = K > 0 ? 1 : -1;
+	if (Half != KHalf)
+	{
+		return Half > KHalf;
+	}
+	
+	/*叉积为正，则点在边界的顺时针方向（屏幕Y轴向下），方向角更大*/
+	if (K > 0)
+	{
+		return (int64_t) OLED_ArcCos[K] * Y - (int64_t) OLED_ArcSin[K] * X > 0;
+	}
+	return (int64_t) OLED_ArcCos[-K] * Y + (int64_t) OLED_ArcSin[-K] * X > 0;
 }
 
 /**
   * 函    数：判断指定点是否在指定角度内部
-  * 参    数：X Y 指定点的坐标
+  * 参    数：X Y 指定点相对圆心的坐标，范围：-255~255
   * 参    数：StartAngle EndAngle 起始角度和终止角度，范围：-180~180
   *           水平向右为0度，水平向左为180度或-180度，下方为正数，上方为负数，顺时针旋转
   * 返 回 值：指定点是否在指定角度内部，1：在内部，0：不在内部
+  * 说    明：点的角度向0取整后与起止角度比较，换算为与边界角的比较，不使用atan2
   */
 uint8_t OLED_IsInAngle(int16_t X, int16_t Y, int16_t StartAngle, int16_t EndAngle)
 {
-	int16_t PointAngle;
-	PointAngle = atan2(Y, X) / 3.14 * 180;	//计算指定点的弧度，并转换为角度表示
+	uint8_t AfterStart, BeforeEnd;
+	
+	/*取整后的角度 >= StartAngle，等价于方向角大于边界StartAngle（正数）或StartAngle - 1（非正数）*/
+	AfterStart = OLED_AngleAbove(X, Y, StartAngle > 0 ? StartAngle : StartAngle - 1);
+	/*取整后的角度 <= EndAngle，等价于方向角小于边界EndAngle + 1（非负数）或EndAngle（负数）*/
+	BeforeEnd = !OLED_AngleAbove(X, Y, EndAngle >= 0 ? EndAngle + 1 : EndAngle);
+	
 	if (StartAngle < EndAngle)	//起始角度小于终止角度的情况
 	{
-		/*如果指定角度在起始终止角度之间，则判定指定点在指定角度*/
-		if (PointAngle >= StartAngle && PointAngle <= EndAngle)
-		{
-			return 1;
-		}
+		return AfterStart && BeforeEnd;
 	}
-	else			//起始角度大于于终止角度的情况
+	else			//起始角度大于等于终止角度的情况
 	{
-		/*如果指定角度大于起始角度或者小于终止角度，则判定指定点在指定角度*/
-		if (PointAngle >= StartAngle || PointAngle <= EndAngle)
+		return AfterStart || BeforeEnd;
+	}
+}
+
+/**
+  * 函    数：将一列中的连续像素置1
+  * 参    数：X 列的横坐标，范围：-32768~32767，屏幕区域：0~127
+  * 参    数：Y0 Y1 起止纵坐标（包含），范围：-32768~32767，屏幕区域：0~63
+  * 返 回 值：无
+  * 说    明：首尾页用掩码，中间页整字节写入，不逐点计算页地址
+  *           不标记脏区，由调用者按图形的外接矩形标记
+  */
+static void OLED_FillColumn(int16_t X, int16_t Y0, int16_t Y1)
+{
+	uint8_t Page0, Page1, Mask0, Mask1, j;
+	
+	if (X < 0 || X > 127) {return;}
+	if (Y0 < 0) {Y0 = 0;}
+	if (Y1 > 63) {Y1 = 63;}
+	if (Y0 > Y1) {return;}
+	
+	Page0 = Y0 / 8;
+	Page1 = Y1 / 8;
+	Mask0 = 0xFF << (Y0 % 8);
+	Mask1 = 0xFF >> (7 - Y1 % 8);
+	if (Page0 == Page1)
+	{
+		OLED_DisplayBuf[Page0][X] |= Mask0 & Mask1;
+		return;
+	}
+	OLED_DisplayBuf[Page0][X] |= Mask0;
+	for (j = Page0 + 1; j < Page1; j ++)
+	{
+		OLED_DisplayBuf[j][X] = 0xFF;
+	}
+	OLED_DisplayBuf[Page1][X] |= Mask1;
+}
+
+/**
+  * 函    数：将一行中的连续像素置1
+  * 参    数：X0 X1 起止横坐标（包含），范围：-32768~32767，屏幕区域：0~127
+  * 参    数：Y 行的纵坐标，范围：-32768~32767，屏幕区域：0~63
+  * 返 回 值：无
+  * 说    明：不标记脏区，由调用者按图形的外接矩形标记
+  */
+static void OLED_FillRow(int16_t X0, int16_t X1, int16_t Y)
+{
+	uint8_t Mask, *Data;
+	int16_t i;
+	
+	if (Y < 0 || Y > 63) {return;}
+	if (X0 < 0) {X0 = 0;}
+	if (X1 > 127) {X1 = 127;}
+	
+	Mask = 0x01 << (Y % 8);
+	Data = OLED_DisplayBuf[Y / 8];
+	for (i = X0; i <= X1; i ++)
+	{
+		Data[i] |= Mask;
+	}
+}
+
+/**
+  * 函    数：填充扇形的一列
+  * 参    数：X Y 圆心坐标
+  * 参    数：x 该列相对圆心的横坐标
+  * 参    数：j0 j1 该列相对圆心的纵坐标范围，j0 <= j < j1
+  * 参    数：StartAngle EndAngle 起始角度和终止角度，范围：-180~180
+  * 返 回 值：无
+  * 说    明：逐点判断角度，连续在角度内部的点合并为一段按列填充；屏幕外的部分不判断
+  */
+static void OLED_FillArcColumn(int16_t X, int16_t Y, int16_t x, int16_t j0, int16_t j1,
+							   int16_t StartAngle, int16_t EndAngle)
+{
+	int16_t j, Run = 0;
+	uint8_t InRun = 0;
+	
+	if (X + x < 0 || X + x > 127) {return;}
+	if (j0 < -Y) {j0 = -Y;}
+	if (j1 > 64 - Y) {j1 = 64 - Y;}
+	
+	for (j = j0; j < j1; j ++)
+	{
+		if (OLED_IsInAngle(x, j, StartAngle, EndAngle))
+		{
+			if (!InRun) {Run = j; InRun = 1;}
+		}
+		else if (InRun)
 		{
-			return 1;
+			OLED_FillColumn(X + x, Y + Run, Y + j - 1);
+			InRun = 0;
 		}
 	}
-	return 0;		//不满足以上条件，则判断判定指定点不在指定角度
+	if (InRun)
+	{
+		OLED_FillColumn(X + x, Y + Run, Y + j1 - 1);
+	}
 }
 
 /*********************工具函数*/
@@ -404,17 +1099,79 @@ uint8_t OLED_IsInAngle(int16_t X, int16_t Y, int16_t StartAngle, int16_t EndAngl
   */
 void OLED_Update(void)
 {
-	uint8_t j;
+	uint8_t i, j, Start, End;
+	
+	/*等待上一次更新发送完成，之后OLED_ShadowBuf可以修改*/
+	OLED_WaitIdle();
+	if (OLED_Lost)
+	{
+		OLED_Lost = 0;
+		OLED_Invalidate();
+	}
+	
 	/*遍历每一页*/
 	for (j = 0; j < 8; j ++)
 	{
-		/*设置光标位置为每一页的第一列*/
-		OLED_SetCursor(j, 0);
-		/*连续写入128个数据，将显存数组的数据写入到OLED硬件*/
-		OLED_WriteData(OLED_DisplayBuf[j], 128);
+		/*在脏区内查找与屏幕内容不同的连续字节段*/
+		i = OLED_DirtyX0[j];
+		while (i <= OLED_DirtyX1[j])
+		{
+			if (OLED_ShadowValid && OLED_DisplayBuf[j][i] == OLED_ShadowBuf[j][i])
+			{
+				i ++;
+				continue;
+			}
+			
+			/*队列已满，先发送已有的段并等待完成*/
+			if (OLED_QueueCount + 2 > OLED_MAX_TRANSFERS)
+			{
+				OLED_Queue_Flush();
+			}
+			
+			/*间隔不超过OLED_MERGE_GAP个相同字节的两段合并发送，比重新设置光标更省*/
+			Start = End = i;
+			for (i ++; i <= OLED_DirtyX1[j] && i - End <= OLED_MERGE_GAP; i ++)
+			{
+				if (!OLED_ShadowValid || OLED_DisplayBuf[j][i] != OLED_ShadowBuf[j][i])
+				{
+					End = i;
+				}
+			}
+			
+			/*更新屏幕内容副本，设置光标位置后从副本连续写入该段数据*/
+			memcpy(&OLED_ShadowBuf[j][Start], &OLED_DisplayBuf[j][Start], End - Start + 1);
+			OLED_CursorCommand(OLED_CursorCmd[OLED_QueueCount / 2], j, Start);
+			OLED_Queue_Push(0x00, OLED_CursorCmd[OLED_QueueCount / 2], 3);
+			OLED_Queue_Push(0x40, &OLED_ShadowBuf[j][Start], End - Start + 1);
+			i = End + 1;
+		}
+		
+		/*该页已与屏幕一致，清除脏区*/
+		OLED_DirtyX0[j] = 128;
+		OLED_DirtyX1[j] = 0;
+	}
+	OLED_ShadowValid = 1;
+	
+	/*开始发送，硬件I2C时立即返回，完成后调用OLED_UpdateCallback*/
+	if (OLED_QueueCount > 0)
+	{
+		OLED_Busy = 1;
+		OLED_StartQueue();
 	}
 }
 
+/**
+  * 函    数：强制下次更新发送整个屏幕
+  * 参    数：无
+  * 返 回 值：无
+  * 说    明：屏幕内容与显存副本可能不一致时调用，例如OLED重新上电
+  */
+void OLED_Invalidate(void)
+{
+	OLED_ShadowValid = 0;
+	OLED_MarkDirty(0, 0, 128, 64);
+}
+
 /**
   * 函    数：将OLED显存数组部分更新到OLED屏幕
   * 参    数：X 指定区域左上角的横坐标，范围：-32768~32767，屏幕区域：0~127
@@ -444,6 +1201,12 @@ void OLED_UpdateArea(int16_t X, int16_t Y, uint8_t Width, uint8_t Height)
 		Page1 -= 1;
 	}
 	
+	/*超出屏幕右边界的列不发送，否则会写入下一页的数据，并使屏幕内容副本失效*/
+	if (X + Width > 128)
+	{
+		Width = X < 128 ? 128 - X : 0;
+	}
+	
 	/*遍历指定区域涉及的相关页*/
 	for (j = Page; j < Page1; j ++)
 	{
@@ -453,6 +1216,8 @@ void OLED_UpdateArea(int16_t X, int16_t Y, uint8_t Width, uint8_t Height)
 			OLED_SetCursor(j, X);
 			/*连续写入Width个数据，将显存数组的数据写入到OLED硬件*/
 			OLED_WriteData(&OLED_DisplayBuf[j][X], Width);
+			/*同步屏幕内容副本*/
+			memcpy(&OLED_ShadowBuf[j][X], &OLED_DisplayBuf[j][X], Width);
 		}
 	}
 }
@@ -473,6 +1238,7 @@ void OLED_Clear(void)
 			OLED_DisplayBuf[j][i] = 0x00;	//将显存数组数据全部清零
 		}
 	}
+	OLED_MarkDirty(0, 0, 128, 64);
 }
 
 /**
@@ -498,6 +1264,7 @@ void OLED_ClearArea(int16_t X, int16_t Y, uint8_t Width, uint8_t Height)
 			}
 		}
 	}
+	OLED_MarkDirty(X, Y, Width, Height);
 }
 
 /**
@@ -516,6 +1283,7 @@ void OLED_Reverse(void)
 			OLED_DisplayBuf[j][i] ^= 0xFF;	//将显存数组数据全部取反
 		}
 	}
+	OLED_MarkDirty(0, 0, 128, 64);
 }
 	
 /**
@@ -541,6 +1309,96 @@ void OLED_ReverseArea(int16_t X, int16_t Y, uint8_t Width, uint8_t Height)
 			}
 		}
 	}
+	OLED_MarkDirty(X, Y, Width, Height);
+}
+
+/**
+  * 函    数：OLED绘制一串字符
+  * 参    数：X 指定第一个字符左上角的横坐标，范围：-32768~32767，屏幕区域：0~127
+  * 参    数：Y 指定第一个字符左上角的纵坐标，范围：-32768~32767，屏幕区域：0~63
+  * 参    数：String 字符，不需要以'\0'结尾
+  * 参    数：Length 字符个数
+  * 参    数：FontSize 指定字体大小
+  * 返 回 值：无
+  * 说    明：所有ASCII文字显示函数都调用此函数，Y按页对齐时直接复制字模
+  */
+static void OLED_DrawText(int16_t X, int16_t Y, const char *String, uint8_t Length, uint8_t FontSize)
+{
+	const uint8_t *Font, *Glyph;
+	uint8_t Pages, LowMask, HighMask;
+	int16_t Page, Shift, X0, X1, Left, Start, End, c, x, p;
+	
+	/*字模：宽FontSize像素，每列Pages个字节，先第一页的所有列，再下一页*/
+	if (FontSize == OLED_8X16)
+	{
+		Font = OLED_F8x16[0];
+		Pages = 2;
+	}
+	else if (FontSize == OLED_6X8)
+	{
+		Font = OLED_F6x8[0];
+		Pages = 1;
+	}
+	else
+	{
+		return;
+	}
+	
+	/*整个字符串只裁剪一次：屏幕内的列范围[X0, X1)*/
+	X0 = X < 0 ? 0 : X;
+	X1 = X + Length * FontSize;
+	if (X1 > 128) {X1 = 128;}
+	if (X0 >= X1 || Y + Pages * 8 <= 0 || Y > 63) {return;}
+	
+	/*负数坐标在计算页地址和移位时需要加一个偏移，与OLED_ShowImage一致*/
+	Page = Y / 8;
+	Shift = Y % 8;
+	if (Y < 0)
+	{
+		Page -= 1;
+		Shift += 8;
+	}
+	
+	LowMask = 0xFF << Shift;
+	HighMask = 0xFF >> (8 - Shift);
+	
+	/*只遍历屏幕内的字符，Start、End为当前字符在屏幕内的列范围（相对字符左边）*/
+	for (c = (X0 - X) / FontSize; c * FontSize + X < X1; c ++)
+	{
+		Glyph = Font + (String[c] - ' ') * FontSize * Pages;
+		Left = X + c * FontSize;
+		Start = Left < X0 ? X0 - Left : 0;
+		End = Left + FontSize > X1 ? X1 - Left : FontSize;
+		
+		for (p = 0; p < Pages; p ++)
+		{
+			if (Shift == 0)
+			{
+				/*Y按页对齐：字模的每个字节正好是显存中的一个字节，直接复制*/
+				if (Page + p >= 0 && Page + p <= 7)
+				{
+					memcpy(&OLED_DisplayBuf[Page + p][Left + Start], &Glyph[p * FontSize + Start], End - Start);
+				}
+				continue;
+			}
+			
+			/*未对齐：字模每个字节拆成本页高位和下一页低位，先用掩码清除字符所占的行再写入*/
+			for (x = Start; x < End; x ++)
+			{
+				uint8_t Data = Glyph[p * FontSize + x];
+				if (Page + p >= 0 && Page + p <= 7)
+				{
+					OLED_DisplayBuf[Page + p][Left + x] = (OLED_DisplayBuf[Page + p][Left + x] & ~LowMask) | (Data << Shift);
+				}
+				if (Page + p + 1 >= 0 && Page + p + 1 <= 7)
+				{
+					OLED_DisplayBuf[Page + p + 1][Left + x] = (OLED_DisplayBuf[Page + p + 1][Left + x] & ~HighMask) | (Data >> (8 - Shift));
+				}
+			}
+		}
+	}
+	
+	OLED_MarkDirty(X0, Y, X1 - X0, Pages * 8);
 }
 
 /**
@@ -556,16 +1414,7 @@ void OLED_ReverseArea(int16_t X, int16_t Y, uint8_t Width, uint8_t Height)
   */
 void OLED_ShowChar(int16_t X, int16_t Y, char Char, uint8_t FontSize)
 {
-	if (FontSize == OLED_8X16)		//字体为宽8像素，高16像素
-	{
-		/*将ASCII字模库OLED_F8x16的指定数据以8*16的图像格式显示*/
-		OLED_ShowImage(X, Y, 8, 16, OLED_F8x16[Char - ' ']);
-	}
-	else if(FontSize == OLED_6X8)	//字体为宽6像素，高8像素
-	{
-		/*将ASCII字模库OLED_F6x8的指定数据以6*8的图像格式显示*/
-		OLED_ShowImage(X, Y, 6, 8, OLED_F6x8[Char - ' ']);
-	}
+	OLED_DrawText(X, Y, &Char, 1, FontSize);
 }
 
 /**
@@ -581,12 +1430,7 @@ void OLED_ShowChar(int16_t X, int16_t Y, char Char, uint8_t FontSize)
   */
 void OLED_ShowString(int16_t X, int16_t Y, char *String, uint8_t FontSize)
 {
-	uint8_t i;
-	for (i = 0; String[i] != '\0'; i++)		//遍历字符串的每个字符
-	{
-		/*调用OLED_ShowChar函数，依次显示每个字符*/
-		OLED_ShowChar(X + i * FontSize, Y, String[i], FontSize);
-	}
+	OLED_DrawText(X, Y, String, strlen(String), FontSize);
 }
 
 /**
@@ -603,13 +1447,14 @@ void OLED_ShowString(int16_t X, int16_t Y, char *String, uint8_t FontSize)
   */
 void OLED_ShowNum(int16_t X, int16_t Y, uint32_t Number, uint8_t Length, uint8_t FontSize)
 {
-	uint8_t i;
-	for (i = 0; i < Length; i++)		//遍历数字的每一位							
+	char Digit;
+	
+	/*从最低位开始，依次显示在从右到左的位置上，不需要计算10的次方*/
+	while (Length --)
 	{
-		/*调用OLED_ShowChar函数，依次显示每个数字*/
-		/*Number / OLED_Pow(10, Length - i - 1) % 10 可以十进制提取数字的每一位*/
-		/*+ '0' 可将数字转换为字符格式*/
-		OLED_ShowChar(X + i * FontSize, Y, Number / OLED_Pow(10, Length - i - 1) % 10 + '0', FontSize);
+		Digit = Number % 10 + '0';
+		OLED_DrawText(X + Length * FontSize, Y, &Digit, 1, FontSize);
+		Number /= 10;
 	}
 }
 
@@ -627,27 +1472,9 @@ void OLED_ShowNum(int16_t X, int16_t Y, uint32_t Number, uint8_t Length, uint8_t
   */
 void OLED_ShowSignedNum(int16_t X, int16_t Y, int32_t Number, uint8_t Length, uint8_t FontSize)
 {
-	uint8_t i;
-	uint32_t Number1;
-	
-	if (Number >= 0)						//数字大于等于0
-	{
-		OLED_ShowChar(X, Y, '+', FontSize);	//显示+号
-		Number1 = Number;					//Number1直接等于Number
-	}
-	else									//数字小于0
-	{
-		OLED_ShowChar(X, Y, '-', FontSize);	//显示-号
-		Number1 = -Number;					//Number1等于Number取负
-	}
-	
-	for (i = 0; i < Length; i++)			//遍历数字的每一位								
-	{
-		/*调用OLED_ShowChar函数，依次显示每个数字*/
-		/*Number1 / OLED_Pow(10, Length - i - 1) % 10 可以十进制提取数字的每一位*/
-		/*+ '0' 可将数字转换为字符格式*/
-		OLED_ShowChar(X + (i + 1) * FontSize, Y, Number1 / OLED_Pow(10, Length - i - 1) % 10 + '0', FontSize);
-	}
+	/*显示符号，再显示绝对值，-Number按无符号计算以覆盖-2147483648*/
+	OLED_ShowChar(X, Y, Number >= 0 ? '+' : '-', FontSize);
+	OLED_ShowNum(X + FontSize, Y, Number >= 0 ? (uint32_t) Number : -(uint32_t) Number, Length, FontSize);
 }
 
 /**
@@ -664,24 +1491,14 @@ void OLED_ShowSignedNum(int16_t X, int16_t Y, int32_t Number, uint8_t Length, ui
   */
 void OLED_ShowHexNum(int16_t X, int16_t Y, uint32_t Number, uint8_t Length, uint8_t FontSize)
 {
-	uint8_t i, SingleNumber;
-	for (i = 0; i < Length; i++)		//遍历数字的每一位
+	char Digit;
+	
+	/*从最低位开始，每4位一个十六进制数字*/
+	while (Length --)
 	{
-		/*以十六进制提取数字的每一位*/
-		SingleNumber = Number / OLED_Pow(16, Length - i - 1) % 16;
-		
-		if (SingleNumber < 10)			//单个数字小于10
-		{
-			/*调用OLED_ShowChar函数，显示此数字*/
-			/*+ '0' 可将数字转换为字符格式*/
-			OLED_ShowChar(X + i * FontSize, Y, SingleNumber + '0', FontSize);
-		}
-		else							//单个数字大于10
-		{
-			/*调用OLED_ShowChar函数，显示此数字*/
-			/*+ 'A' 可将数字转换为从A开始的十六进制字符*/
-			OLED_ShowChar(X + i * FontSize, Y, SingleNumber - 10 + 'A', FontSize);
-		}
+		Digit = "0123456789ABCDEF"[Number & 0x0F];
+		OLED_DrawText(X + Length * FontSize, Y, &Digit, 1, FontSize);
+		Number >>= 4;
 	}
 }
 
@@ -699,13 +1516,14 @@ void OLED_ShowHexNum(int16_t X, int16_t Y, uint32_t Number, uint8_t Length, uint
   */
 void OLED_ShowBinNum(int16_t X, int16_t Y, uint32_t Number, uint8_t Length, uint8_t FontSize)
 {
-	uint8_t i;
-	for (i = 0; i < Length; i++)		//遍历数字的每一位	
+	char Digit;
+	
+	/*从最低位开始，依次显示每一位*/
+	while (Length --)
 	{
-		/*调用OLED_ShowChar函数，依次显示每个数字*/
-		/*Number / OLED_Pow(2, Length - i - 1) % 2 可以二进制提取数字的每一位*/
-		/*+ '0' 可将数字转换为字符格式*/
-		OLED_ShowChar(X + i * FontSize, Y, Number / OLED_Pow(2, Length - i - 1) % 2 + '0', FontSize);
+		Digit = (Number & 0x01) + '0';
+		OLED_DrawText(X + Length * FontSize, Y, &Digit, 1, FontSize);
+		Number >>= 1;
 	}
 }
 
@@ -715,33 +1533,29 @@ void OLED_ShowBinNum(int16_t X, int16_t Y, uint32_t Number, uint8_t Length, uint
   * 参    数：Y 指定数字左上角的纵坐标，范围：-32768~32767，屏幕区域：0~63
   * 参    数：Number 指定要显示的数字，范围：-4294967295.0~4294967295.0
   * 参    数：IntLength 指定数字的整数位长度，范围：0~10
-  * 参    数：FraLength 指定数字的小数位长度，范围：0~9，小数进行四舍五入显示
+  * 参    数：FraLength 指定数字的小数位长度，范围：0~9，小数与printf相同四舍六入五成双
   * 参    数：FontSize 指定字体大小
   *           范围：OLED_8X16		宽8像素，高16像素
   *                 OLED_6X8		宽6像素，高8像素
   * 返 回 值：无
   * 说    明：调用此函数后，要想真正地呈现在屏幕上，还需调用更新函数
   */
-void OLED_ShowFloatNum(int16_t X, int16_t Y, double Number, uint8_t IntLength, uint8_t FraLength, uint8_t FontSize)
+void OLED_ShowFloatNum(int16_t X, int16_t Y, float Number, uint8_t IntLength, uint8_t FraLength, uint8_t FontSize)
 {
-	uint32_t PowNum, IntNum, FraNum;
+	uint32_t Bits, IntNum, FraNum;
+	uint8_t Exponent;
 	
-	if (Number >= 0)						//数字大于等于0
-	{
-		OLED_ShowChar(X, Y, '+', FontSize);	//显示+号
-	}
-	else									//数字小于0
-	{
-		OLED_ShowChar(X, Y, '-', FontSize);	//显示-号
-		Number = -Number;					//Number取负
-	}
+	/*直接解析单精度浮点数的符号、指数和尾数，不使用浮点运算*/
+	memcpy(&Bits, &Number, sizeof(Bits));
+	Exponent = (Bits >> 23) & 0xFF;
+	if (FraLength > 9) {FraLength = 9;}
 	
-	/*提取整数部分和小数部分*/
-	IntNum = Number;						//直接赋值给整型变量，提取整数
-	Number -= IntNum;						//将Number的整数减掉，防止之后将小数乘到整数时因数过大造成错误
-	PowNum = OLED_Pow(10, FraLength);		//根据指定小数的位数，确定乘数
-	FraNum = round(Number * PowNum);		//将小数乘到整数，同时四舍五入，避免显示误差
-	IntNum += FraNum / PowNum;				//若四舍五入造成了进位，则需要再加给整数
+	/*显示符号，-0.0显示为+*/
+	OLED_ShowChar(X, Y, (Bits & 0x80000000u) && (Bits & 0x7FFFFFFFu) ? '-' : '+', FontSize);
+	
+	/*提取整数部分和小数部分，小数四舍五入，进位加到整数*/
+	OLED_SplitReal(Exponent ? (Bits & 0x007FFFFFu) | 0x00800000u : (Bits & 0x007FFFFFu) << 1,
+				   (int16_t) Exponent - 150, FraLength, &IntNum, &FraNum);
 	
 	/*显示整数部分*/
 	OLED_ShowNum(X + FontSize, Y, IntNum, IntLength, FontSize);
@@ -753,6 +1567,32 @@ void OLED_ShowFloatNum(int16_t X, int16_t Y, double Number, uint8_t IntLength, u
 	OLED_ShowNum(X + (IntLength + 2) * FontSize, Y, FraNum, FraLength, FontSize);
 }
 
+/**
+  * 函    数：OLED显示定点数字（十进制，小数）
+  * 参    数：X 指定数字左上角的横坐标，范围：-32768~32767，屏幕区域：0~127
+  * 参    数：Y 指定数字左上角的纵坐标，范围：-32768~32767，屏幕区域：0~63
+  * 参    数：Number 指定要显示的定点数，数值 = Number / 2^FracBits，例如q16_t给FracBits = 16
+  * 参    数：FracBits 小数位的二进制位数，范围：0~31
+  * 参    数：IntLength 指定数字的整数位长度，范围：0~10
+  * 参    数：FraLength 指定数字的小数位长度，范围：0~9，小数与printf相同四舍六入五成双
+  * 参    数：FontSize 指定字体大小
+  *           范围：OLED_8X16		宽8像素，高16像素
+  *                 OLED_6X8		宽6像素，高8像素
+  * 返 回 值：无
+  * 说    明：显示格式与OLED_ShowFloatNum相同，调用此函数后，要想真正地呈现在屏幕上，还需调用更新函数
+  */
+void OLED_ShowFixedNum(int16_t X, int16_t Y, int32_t Number, uint8_t FracBits, uint8_t IntLength, uint8_t FraLength, uint8_t FontSize)
+{
+	uint32_t IntNum, FraNum;
+	
+	if (FraLength > 9) {FraLength = 9;}
+	OLED_ShowChar(X, Y, Number >= 0 ? '+' : '-', FontSize);
+	OLED_SplitReal(Number >= 0 ? (uint32_t) Number : -(uint32_t) Number, -(int16_t) FracBits, FraLength, &IntNum, &FraNum);
+	OLED_ShowNum(X + FontSize, Y, IntNum, IntLength, FontSize);
+	OLED_ShowChar(X + (IntLength + 1) * FontSize, Y, '.', FontSize);
+	OLED_ShowNum(X + (IntLength + 2) * FontSize, Y, FraNum, FraLength, FontSize);
+}
+
 /**
   * 函    数：OLED显示汉字串
   * 参    数：X 指定汉字串左上角的横坐标，范围：-32768~32767，屏幕区域：0~127
@@ -812,7 +1652,7 @@ void OLED_ShowImage(int16_t X, int16_t Y, uint8_t Width, uint8_t Height, const u
 	uint8_t i = 0, j = 0;
 	int16_t Page, Shift;
 	
-	/*将图像所在区域清空*/
+	/*将图像所在区域清空，同时标记脏区*/
 	OLED_ClearArea(X, Y, Width, Height);
 	
 	/*遍历指定图像涉及的相关页*/
@@ -849,6 +1689,90 @@ void OLED_ShowImage(int16_t X, int16_t Y, uint8_t Width, uint8_t Height, const u
 	}
 }
 
+/*OLED_Printf格式标志*/
+#define OLED_FMT_LEFT		0x01	//'-' 左对齐
+#define OLED_FMT_PLUS		0x02	//'+' 正数显示+号
+#define OLED_FMT_SPACE		0x04	//' ' 正数前留空格
+#define OLED_FMT_ZERO		0x08	//'0' 用0填充宽度
+#define OLED_FMT_UPPER		0x10	//十六进制大写
+
+/**
+  * 函    数：OLED逐字符显示，显示后横坐标右移一个字符
+  * 参    数：X 横坐标指针
+  * 参    数：Y 纵坐标
+  * 参    数：Char 字符
+  * 参    数：Count 重复次数
+  * 参    数：FontSize 字体大小
+  * 返 回 值：无
+  */
+static void OLED_PutChar(int16_t *X, int16_t Y, char Char, int16_t Count, uint8_t FontSize)
+{
+	while (Count -- > 0)
+	{
+		OLED_DrawText(*X, Y, &Char, 1, FontSize);
+		*X += FontSize;
+	}
+}
+
+/**
+  * 函    数：OLED按格式显示一个数字
+  * 参    数：X 横坐标指针，显示后右移
+  * 参    数：Y 纵坐标
+  * 参    数：Sign 符号字符，0表示不显示
+  * 参    数：IntNum 整数部分
+  * 参    数：FraNum 小数部分
+  * 参    数：FraLength 小数位数，小于0表示整数（不显示小数点）
+  * 参    数：Base 进制，10或16
+  * 参    数：MinDigits 整数部分的最少位数，不足补0
+  * 参    数：Width 最小宽度
+  * 参    数：Flags OLED_FMT_xxx
+  * 参    数：FontSize 字体大小
+  * 返 回 值：无
+  * 说    明：先算出总长度再从左到右直接显示，不需要字符缓冲
+  */
+static void OLED_PutNumber(int16_t *X, int16_t Y, char Sign, uint32_t IntNum, uint32_t FraNum, int8_t FraLength,
+						   uint8_t Base, uint8_t MinDigits, int16_t Width, uint8_t Flags, uint8_t FontSize)
+{
+	uint8_t Digits, i, d;
+	int16_t Length, Pad;
+	const char *Table = (Flags & OLED_FMT_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+	
+	Digits = (MinDigits == 0 && IntNum == 0) ? 0 : OLED_Digits(IntNum, Base);
+	if (Digits < MinDigits) {Digits = MinDigits;}
+	Length = (Sign != 0) + Digits + (FraLength >= 0 ? 1 + FraLength : 0);
+	Pad = Width > Length ? Width - Length : 0;
+	
+	if (!(Flags & (OLED_FMT_LEFT | OLED_FMT_ZERO))) {OLED_PutChar(X, Y, ' ', Pad, FontSize);}
+	if (Sign) {OLED_PutChar(X, Y, Sign, 1, FontSize);}
+	if (!(Flags & OLED_FMT_LEFT) && (Flags & OLED_FMT_ZERO)) {OLED_PutChar(X, Y, '0', Pad, FontSize);}
+	
+	/*整数部分从最高位开始显示，十进制用权值表取位*/
+	for (i = Digits; i > 0; i --)
+	{
+		if (Base == 16)
+		{
+			d = i > 8 ? 0 : (IntNum >> ((i - 1) * 4)) & 0x0F;
+		}
+		else
+		{
+			d = i > 10 ? 0 : IntNum / OLED_Pow10[i - 1] % 10;
+		}
+		OLED_PutChar(X, Y, Table[d], 1, FontSize);
+	}
+	
+	/*小数部分*/
+	if (FraLength >= 0)
+	{
+		OLED_PutChar(X, Y, '.', 1, FontSize);
+		for (i = FraLength; i > 0; i --)
+		{
+			OLED_PutChar(X, Y, '0' + FraNum / OLED_Pow10[i - 1] % 10, 1, FontSize);
+		}
+	}
+	
+	if (Flags & OLED_FMT_LEFT) {OLED_PutChar(X, Y, ' ', Pad, FontSize);}
+}
+
 /**
   * 函    数：OLED使用printf函数打印格式化字符串
   * 参    数：X 指定格式化字符串左上角的横坐标，范围：-32768~32767，屏幕区域：0~127
@@ -860,15 +1784,135 @@ void OLED_ShowImage(int16_t X, int16_t Y, uint8_t Width, uint8_t Height, const u
   * 参    数：... 格式化字符串参数列表
   * 返 回 值：无
   * 说    明：调用此函数后，要想真正地呈现在屏幕上，还需调用更新函数
+  * 说    明：不使用vsprintf，格式化结果直接显示到显存，不占用字符缓冲，也不链接浮点printf
+  *           支持 %d %i %u %x %X %c %s %f %%，标志 - + 空格 0，宽度和精度（可用*），长度修饰 l h（忽略）
+  *           %f 的精度最大为9，整数部分超过4294967295时显示4294967295，舍入方式与printf相同
+  *           不支持的转换原样显示
   */
 void OLED_Printf(int16_t X, int16_t Y, uint8_t FontSize, char *format, ...)
 {
-	char String[256];						//定义字符数组
 	va_list arg;							//定义可变参数列表数据类型的变量arg
+	uint8_t Flags, Long;
+	int16_t Width, Precision;
+	int32_t Signed;
+	uint32_t IntNum, FraNum;
+	uint64_t Bits;
+	double Real;
+	const char *String;
+	char Sign;
+	
 	va_start(arg, format);					//从format开始，接收参数列表到arg变量
-	vsprintf(String, format, arg);			//使用vsprintf打印格式化字符串和参数列表到字符数组中
+	for (; *format != '\0'; format ++)
+	{
+		if (*format != '%')
+		{
+			OLED_PutChar(&X, Y, *format, 1, FontSize);
+			continue;
+		}
+		
+		/*标志*/
+		Flags = 0;
+		for (format ++; ; format ++)
+		{
+			if (*format == '-') {Flags |= OLED_FMT_LEFT;}
+			else if (*format == '+') {Flags |= OLED_FMT_PLUS;}
+			else if (*format == ' ') {Flags |= OLED_FMT_SPACE;}
+			else if (*format == '0') {Flags |= OLED_FMT_ZERO;}
+			else {break;}
+		}
+		
+		/*宽度*/
+		Width = 0;
+		if (*format == '*')
+		{
+			Width = va_arg(arg, int);
+			if (Width < 0) {Flags |= OLED_FMT_LEFT; Width = -Width;}
+			format ++;
+		}
+		for (; *format >= '0' && *format <= '9'; format ++) {Width = Width * 10 + *format - '0';}
+		
+		/*精度，-1表示未指定*/
+		Precision = -1;
+		if (*format == '.')
+		{
+			Precision = 0;
+			format ++;
+			if (*format == '*')
+			{
+				Precision = va_arg(arg, int);
+				format ++;
+			}
+			for (; *format >= '0' && *format <= '9'; format ++) {Precision = Precision * 10 + *format - '0';}
+		}
+		
+		/*长度修饰：int为32位，l和h不改变显示*/
+		Long = 0;
+		for (; *format == 'l' || *format == 'h'; format ++) {Long |= *format == 'l';}
+		
+		Sign = 0;
+		switch (*format)
+		{
+			case 'd':
+			case 'i':
+				Signed = Long ? (int32_t) va_arg(arg, long) : va_arg(arg, int);
+				IntNum = Signed >= 0 ? (uint32_t) Signed : -(uint32_t) Signed;
+				Sign = Signed < 0 ? '-' : (Flags & OLED_FMT_PLUS) ? '+' : (Flags & OLED_FMT_SPACE) ? ' ' : 0;
+				if (Precision >= 0) {Flags &= ~OLED_FMT_ZERO;}
+				OLED_PutNumber(&X, Y, Sign, IntNum, 0, -1, 10, Precision < 0 ? 1 : Precision, Width, Flags, FontSize);
+				break;
+			
+			case 'u':
+			case 'x':
+			case 'X':
+				IntNum = Long ? (uint32_t) va_arg(arg, unsigned long) : va_arg(arg, unsigned int);
+				if (*format == 'X') {Flags |= OLED_FMT_UPPER;}
+				if (Precision >= 0) {Flags &= ~OLED_FMT_ZERO;}
+				OLED_PutNumber(&X, Y, 0, IntNum, 0, -1, *format == 'u' ? 10 : 16, Precision < 0 ? 1 : Precision, Width, Flags, FontSize);
+				break;
+			
+			case 'f':
+			case 'F':
+				/*直接解析双精度浮点数的符号、指数和尾数，不使用浮点运算*/
+				Real = va_arg(arg, double);
+				memcpy(&Bits, &Real, sizeof(Bits));
+				if (Precision < 0) {Precision = 6;}
+				if (Precision > 9) {Precision = 9;}
+				OLED_SplitReal(((Bits >> 52) & 0x7FF) ? (Bits & 0x000FFFFFFFFFFFFFull) | 0x0010000000000000ull
+													  : (Bits & 0x000FFFFFFFFFFFFFull) << 1,
+							   (int16_t) ((Bits >> 52) & 0x7FF) - 1075, Precision, &IntNum, &FraNum);
+				Sign = (Bits >> 63) ? '-' : (Flags & OLED_FMT_PLUS) ? '+' : (Flags & OLED_FMT_SPACE) ? ' ' : 0;
+				OLED_PutNumber(&X, Y, Sign, IntNum, FraNum, Precision ? Precision : -1, 10, 1, Width, Flags, FontSize);
+				break;
+			
+			case 'c':
+				if (!(Flags & OLED_FMT_LEFT)) {OLED_PutChar(&X, Y, ' ', Width - 1, FontSize);}
+				OLED_PutChar(&X, Y, (char) va_arg(arg, int), 1, FontSize);
+				if (Flags & OLED_FMT_LEFT) {OLED_PutChar(&X, Y, ' ', Width - 1, FontSize);}
+				break;
+			
+			case 's':
+				String = va_arg(arg, const char *);
+				for (Signed = 0; String[Signed] != '\0' && (Precision < 0 || Signed < Precision); Signed ++);
+				if (!(Flags & OLED_FMT_LEFT)) {OLED_PutChar(&X, Y, ' ', Width - Signed, FontSize);}
+				OLED_DrawText(X, Y, String, Signed, FontSize);
+				X += Signed * FontSize;
+				if (Flags & OLED_FMT_LEFT) {OLED_PutChar(&X, Y, ' ', Width - Signed, FontSize);}
+				break;
+			
+			case '%':
+				OLED_PutChar(&X, Y, '%', 1, FontSize);
+				break;
+			
+			case '\0':
+				format --;					//格式串在%后结束
+				break;
+			
+			default:
+				OLED_PutChar(&X, Y, *format, 1, FontSize);	//不支持的转换原样显示
+				break;
+		}
+	}
 	va_end(arg);							//结束变量arg
-	OLED_ShowString(X, Y, String, FontSize);//OLED显示字符数组（字符串）
 }
 
 /**
@@ -884,6 +1928,7 @@ void OLED_DrawPoint(int16_t X, int16_t Y)
 	{
 		/*将显存数组指定位置的一个Bit数据置1*/
 		OLED_DisplayBuf[Y / 8][X] |= 0x01 << (Y % 8);
+		OLED_MarkDirty(X, Y, 1, 1);
 	}
 }
 
@@ -1080,9 +2125,10 @@ void OLED_DrawRectangle(int16_t X, int16_t Y, uint8_t Width, uint8_t Height, uin
 void OLED_DrawTriangle(int16_t X0, int16_t Y0, int16_t X1, int16_t Y1, int16_t X2, int16_t Y2, uint8_t IsFilled)
 {
 	int16_t minx = X0, miny = Y0, maxx = X0, maxy = Y0;
-	int16_t i, j;
+	int16_t i, j, k, n;
 	int16_t vx[] = {X0, X1, X2};
 	int16_t vy[] = {Y0, Y1, Y2};
+	int32_t Cross[2];
 	
 	if (!IsFilled)			//指定三角形不填充
 	{
@@ -1106,18 +2152,29 @@ void OLED_DrawTriangle(int16_t X0, int16_t Y0, int16_t X1, int16_t Y1, int16_t X
 		if (Y2 > maxy) {maxy = Y2;}
 		
 		/*最小最大坐标之间的矩形为可能需要填充的区域*/
-		/*遍历此区域中所有的点*/
-		/*遍历X坐标*/		
-		for (i = minx; i <= maxx; i ++)
+		/*逐行计算三角形的边与该行的交点，两交点之间为填充部分*/
+		/*交点的判定和计算与pnpoly算法相同（W. Randolph Franklin）*/
+		/*参考链接：https://wrfranklin.org/Research/Short_Notes/pnpoly.html*/
+		for (j = miny < 0 ? 0 : miny; j <= maxy && j <= 63; j ++)
 		{
-			/*遍历Y坐标*/	
-			for (j = miny; j <= maxy; j ++)
+			/*跨过该行的边，在该行的交点横坐标，除法与pnpoly一样向0取整*/
+			n = 0;
+			for (i = 0, k = 2; i < 3; k = i ++)
 			{
-				/*调用OLED_pnpoly，判断指定点是否在指定三角形之中*/
-				/*如果在，则画点，如果不在，则不做处理*/
-				if (OLED_pnpoly(3, vx, vy, i, j)) {OLED_DrawPoint(i, j);}
+				if ((vy[i] > j) != (vy[k] > j))
+				{
+					Cross[n ++] = (int32_t) (vx[k] - vx[i]) * (j - vy[i]) / (vy[k] - vy[i]) + vx[i];
+				}
+			}
+			
+			/*三角形与一行的交点为0个或2个，pnpoly判定在内部的点满足 小交点 <= X < 大交点*/
+			if (n == 2)
+			{
+				if (Cross[0] > Cross[1]) {Cross[0] ^= Cross[1]; Cross[1] ^= Cross[0]; Cross[0] ^= Cross[1];}
+				OLED_FillRow(Cross[0] < minx ? minx : Cross[0], Cross[1] - 1 > maxx ? maxx : Cross[1] - 1, j);
 			}
 		}
+		OLED_MarkDirty(minx, miny, maxx - minx + 1, maxy - miny + 1);
 	}
 }
 
@@ -1134,7 +2191,7 @@ void OLED_DrawTriangle(int16_t X0, int16_t Y0, int16_t X1, int16_t Y1, int16_t X
   */
 void OLED_DrawCircle(int16_t X, int16_t Y, uint8_t Radius, uint8_t IsFilled)
 {
-	int16_t x, y, d, j;
+	int16_t x, y, d;
 	
 	/*使用Bresenham算法画圆，可以避免耗时的浮点运算，效率更高*/
 	/*参考文档：https://www.cs.montana.edu/courses/spring2009/425/dslectures/Bresenham.pdf*/
@@ -1152,12 +2209,9 @@ void OLED_DrawCircle(int16_t X, int16_t Y, uint8_t Radius, uint8_t IsFilled)
 	
 	if (IsFilled)		//指定圆填充
 	{
-		/*遍历起始点Y坐标*/
-		for (j = -y; j < y; j ++)
-		{
-			/*在指定区域画点，填充部分圆*/
-			OLED_DrawPoint(X, Y + j);
-		}
+		/*填充起始点所在的列*/
+		OLED_FillColumn(X, Y - y, Y + y - 1);
+		OLED_MarkDirty(X - Radius, Y - Radius, 2 * Radius + 1, 2 * Radius + 1);
 	}
 	
 	while (x < y)		//遍历X轴的每个点
@@ -1185,21 +2239,13 @@ void OLED_DrawCircle(int16_t X, int16_t Y, uint8_t Radius, uint8_t IsFilled)
 		
 		if (IsFilled)	//指定圆填充
 		{
-			/*遍历中间部分*/
-			for (j = -y; j < y; j ++)
-			{
-				/*在指定区域画点，填充部分圆*/
-				OLED_DrawPoint(X + x, Y + j);
-				OLED_DrawPoint(X - x, Y + j);
-			}
+			/*按列填充中间部分*/
+			OLED_FillColumn(X + x, Y - y, Y + y - 1);
+			OLED_FillColumn(X - x, Y - y, Y + y - 1);
 			
-			/*遍历两侧部分*/
-			for (j = -x; j < x; j ++)
-			{
-				/*在指定区域画点，填充部分圆*/
-				OLED_DrawPoint(X - y, Y + j);
-				OLED_DrawPoint(X + y, Y + j);
-			}
+			/*按列填充两侧部分*/
+			OLED_FillColumn(X - y, Y - x, Y + x - 1);
+			OLED_FillColumn(X + y, Y - x, Y + x - 1);
 		}
 	}
 }
@@ -1218,7 +2264,7 @@ void OLED_DrawCircle(int16_t X, int16_t Y, uint8_t Radius, uint8_t IsFilled)
   */
 void OLED_DrawEllipse(int16_t X, int16_t Y, uint8_t A, uint8_t B, uint8_t IsFilled)
 {
-	int16_t x, y, j;
+	int16_t x, y;
 	int16_t a = A, b = B;
 	float d1, d2;
 	
@@ -1231,13 +2277,9 @@ void OLED_DrawEllipse(int16_t X, int16_t Y, uint8_t A, uint8_t B, uint8_t IsFill
 	
 	if (IsFilled)	//指定椭圆填充
 	{
-		/*遍历起始点Y坐标*/
-		for (j = -y; j < y; j ++)
-		{
-			/*在指定区域画点，填充部分椭圆*/
-			OLED_DrawPoint(X, Y + j);
-			OLED_DrawPoint(X, Y + j);
-		}
+		/*填充起始点所在的列*/
+		OLED_FillColumn(X, Y - y, Y + y - 1);
+		OLED_MarkDirty(X - a, Y - b, 2 * a + 1, 2 * b + 1);
 	}
 	
 	/*画椭圆弧的起始点*/
@@ -1262,13 +2304,9 @@ void OLED_DrawEllipse(int16_t X, int16_t Y, uint8_t A, uint8_t B, uint8_t IsFill
 		
 		if (IsFilled)	//指定椭圆填充
 		{
-			/*遍历中间部分*/
-			for (j = -y; j < y; j ++)
-			{
-				/*在指定区域画点，填充部分椭圆*/
-				OLED_DrawPoint(X + x, Y + j);
-				OLED_DrawPoint(X - x, Y + j);
-			}
+			/*按列填充中间部分*/
+			OLED_FillColumn(X + x, Y - y, Y + y - 1);
+			OLED_FillColumn(X - x, Y - y, Y + y - 1);
 		}
 		
 		/*画椭圆中间部分圆弧*/
@@ -1297,13 +2335,9 @@ void OLED_DrawEllipse(int16_t X, int16_t Y, uint8_t A, uint8_t B, uint8_t IsFill
 		
 		if (IsFilled)	//指定椭圆填充
 		{
-			/*遍历两侧部分*/
-			for (j = -y; j < y; j ++)
-			{
-				/*在指定区域画点，填充部分椭圆*/
-				OLED_DrawPoint(X + x, Y + j);
-				OLED_DrawPoint(X - x, Y + j);
-			}
+			/*按列填充两侧部分*/
+			OLED_FillColumn(X + x, Y - y, Y + y - 1);
+			OLED_FillColumn(X - x, Y - y, Y + y - 1);
 		}
 		
 		/*画椭圆两侧部分圆弧*/
@@ -1331,7 +2365,7 @@ void OLED_DrawEllipse(int16_t X, int16_t Y, uint8_t A, uint8_t B, uint8_t IsFill
   */
 void OLED_DrawArc(int16_t X, int16_t Y, uint8_t Radius, int16_t StartAngle, int16_t EndAngle, uint8_t IsFilled)
 {
-	int16_t x, y, d, j;
+	int16_t x, y, d;
 	
 	/*此函数借用Bresenham算法画圆的方法*/
 	
@@ -1347,12 +2381,9 @@ void OLED_DrawArc(int16_t X, int16_t Y, uint8_t Radius, int16_t StartAngle, int1
 	
 	if (IsFilled)	//指定圆弧填充
 	{
-		/*遍历起始点Y坐标*/
-		for (j = -y; j < y; j ++)
-		{
-			/*在填充圆的每个点时，判断指定点是否在指定角度内，在，则画点，不在，则不做处理*/
-			if (OLED_IsInAngle(0, j, StartAngle, EndAngle)) {OLED_DrawPoint(X, Y + j);}
-		}
+		/*填充起始点所在的列，只填充在指定角度内的部分*/
+		OLED_FillArcColumn(X, Y, 0, -y, y, StartAngle, EndAngle);
+		OLED_MarkDirty(X - Radius, Y - Radius, 2 * Radius + 1, 2 * Radius + 1);
 	}
 	
 	while (x < y)		//遍历X轴的每个点
@@ -1380,21 +2411,13 @@ void OLED_DrawArc(int16_t X, int16_t Y, uint8_t Radius, int16_t StartAngle, int1
 		
 		if (IsFilled)	//指定圆弧填充
 		{
-			/*遍历中间部分*/
-			for (j = -y; j < y; j ++)
-			{
-				/*在填充圆的每个点时，判断指定点是否在指定角度内，在，则画点，不在，则不做处理*/
-				if (OLED_IsInAngle(x, j, StartAngle, EndAngle)) {OLED_DrawPoint(X + x, Y + j);}
-				if (OLED_IsInAngle(-x, j, StartAngle, EndAngle)) {OLED_DrawPoint(X - x, Y + j);}
-			}
+			/*按列填充中间部分，只填充在指定角度内的部分*/
+			OLED_FillArcColumn(X, Y, x, -y, y, StartAngle, EndAngle);
+			OLED_FillArcColumn(X, Y, -x, -y, y, StartAngle, EndAngle);
 			
-			/*遍历两侧部分*/
-			for (j = -x; j < x; j ++)
-			{
-				/*在填充圆的每个点时，判断指定点是否在指定角度内，在，则画点，不在，则不做处理*/
-				if (OLED_IsInAngle(-y, j, StartAngle, EndAngle)) {OLED_DrawPoint(X - y, Y + j);}
-				if (OLED_IsInAngle(y, j, StartAngle, EndAngle)) {OLED_DrawPoint(X + y, Y + j);}
-			}
+			/*按列填充两侧部分*/
+			OLED_FillArcColumn(X, Y, -y, -x, x, StartAngle, EndAngle);
+			OLED_FillArcColumn(X, Y, y, -x, x, StartAngle, EndAngle);
 		}
 	}
 }
@@ -0,0 +1,233 @@
+#include "bench.h"
+#include "main.h"
+#include "tim.h"
+#include "pid.h"
+#include "encoder.h"
+#include "filter.h"
+#include "planner.h"
+#include "mg513.h"
+#include "profiler.h"
+#include "telemetry.h"
+
+//控制路径基础函数的基准测试
+//同一份源码在目标板（DWT周期）和主机（ns时钟）上编译运行
+//mg513_PWM会改写电机驱动引脚，只能在电机停止时运行
+
+static volatile float sink;             //防止被优化掉
+
+//测试对象
+static PID pid_f, pid_q;
+static Encoder ecd;
+static EdgeTimer edge;
+static Curve curve;
+static MotionPlan plan;
+static LowPass lpf;
+static MovingAverage avg;
+static Median med;
+static Biquad iir;
+
+//输入：0~255循环的锯齿，避免每次相同
+static float input(uint32_t i) {
+    return (float) (i & 0xFF) - 128.0f;
+}
+
+static void case_Empty(uint32_t i) {
+    sink = input(i);
+}
+
+static void case_PIDSpeed(uint32_t i) {
+    updatePID_Speed(&pid_f, input(i));
+    sink = pid_f.output;
+}
+
+static void case_PIDSpeedFixed(uint32_t i) {
+    updatePID_Speed(&pid_q, input(i));
+    sink = pid_q.output;
+}
+
+static void case_PIDPosition(uint32_t i) {
+    updatePID_Position(&pid_f, input(i));
+    sink = pid_f.output;
+}
+
+static void case_EncoderLoop(uint32_t i) {
+    (void) i;
+    updateEncoderLoop(&ecd, 1.0f);
+    sink = ecd.velocity.angular;
+}
+
+static void case_EstimateVelocity(uint32_t i) {
+    edge.edge_time += 7200;
+    edge.edge_count += 2;
+    edge.edge_seq += (uint16_t) (i & 1);
+    sink = estimateVelocity(&edge, edge.edge_time, 41.2f, 72000.0f, 2.0f, sink);
+}
+
+#if PID_CURVE
+static void case_VelocityCurve(uint32_t i) {
+    (void) i;
+    if (curve.aTimes == 0)
+        setCurve(&curve, 0, 200, 10, 380);
+    VelocityCurve(&curve);
+    sink = curve.current;
+}
+
+static void case_PositionCurve(uint32_t i) {
+    (void) i;
+    if (curve.aTimes == 0) {
+        curve.current = 0;
+        setCurve(&curve, 0, 360, 0, 20);
+    }
+    PositionCurve(&curve);
+    sink = curve.current;
+}
+#endif
+
+static void case_PlannerStep(uint32_t i) {
+    (void) i;
+    if (plan.done) {
+        planner_Reset(&plan, 0, 0);
+        planner_Position(&plan, 360, 0, 1800, 7200, 72000);
+    }
+    planner_Step(&plan, 0.001f);
+    sink = plan.p;
+}
+
+static void case_LowPass(uint32_t i) {
+    sink = updateLowPass(&lpf, input(i));
+}
+
+static void case_MovingAverage(uint32_t i) {
+    sink = updateMovingAverage(&avg, input(i));
+}
+
+static void case_Median(uint32_t i) {
+    sink = updateMedian(&med, input(i * 37));
+}
+
+static void case_Biquad(uint32_t i) {
+    sink = updateBiquad(&iir, input(i));
+}
+
+static void case_PWM(uint32_t i) {
+    mg513_PWM(LEFT, (int16_t) ((int32_t) (i & 0x7FF) - 1024));
+}
+
+typedef struct {
+    const char* name;
+    void (*run)(uint32_t i);
+}BenchCase;
+
+static const BenchCase cases[] = {
+    {"updatePID_Speed",       case_PIDSpeed},
+    {"updatePID_Speed_q16",   case_PIDSpeedFixed},
+    {"updatePID_Position",    case_PIDPosition},
+    {"updateEncoderLoop",     case_EncoderLoop},
+    {"estimateVelocity",      case_EstimateVelocity},
+#if PID_CURVE
+    {"VelocityCurve",         case_VelocityCurve},
+    {"PositionCurve",         case_PositionCurve},
+#endif
+    {"planner_Step",          case_PlannerStep},
+    {"updateLowPass",         case_LowPass},
+    {"updateMovingAverage",   case_MovingAverage},
+    {"updateMedian",          case_Median},
+    {"updateBiquad",          case_Biquad},
+    {"mg513_PWM",             case_PWM},
+};
+
+//堆占用，主机上用malloc统计重新实现
+__weak int32_t bench_HeapUsed(void) {
+    return 0;
+}
+
+static void bench_Setup(void) {
+    initPID(&pid_f, 2000, 4000);
+    setPIDParam(&pid_f, 5, 0.8f, 6);
+    setPIDTarget(&pid_f, 100);
+    initPID(&pid_q, 2000, 4000);
+    setPIDParam(&pid_q, 5, 0.8f, 6);
+    setPIDTarget(&pid_q, 100);
+    setPIDFixed(&pid_q, 1);
+
+    Parameter param = {4, 13, 28, 0.065f, &htim2};
+    initEncoder(&ecd, param);
+    edge.primed = 0;
+
+    curve.aTimes = 0;
+    curve.maxTimes = 0;
+    curve.current = 0;
+    planner_Reset(&plan, 0, 0);
+
+    initLowPass(&lpf, VELOCITY_CUTOFF, 10);
+    initMovingAverage(&avg);
+    initMedian(&med);
+    initBiquadLowPass(&iir, 50, 1, 0.7071f);
+}
+
+//分段计时，累计为64位
+static uint64_t bench_Time(void (*run)(uint32_t), uint32_t iterations) {
+    uint64_t total = 0;
+    uint32_t i = 0;
+
+    while (i < iterations) {
+        uint32_t n = iterations - i < BENCH_CHUNK ? iterations - i : BENCH_CHUNK;
+        uint32_t end = i + n;
+        uint32_t start = profiler_Now();
+        for (; i < end; i++) {
+            run(i);
+        }
+        total += profiler_Now() - start;
+    }
+    return total;
+}
+
+//运行全部基准
+//BenchResult* result           结果数组
+//uint8_t max                   数组长度
+//uint32_t iterations           每项调用次数
+//返回值                        结果项数，控制中断运行中（电机打开）时返回0
+uint8_t bench_Run(BenchResult* result, uint8_t max, uint32_t iterations) {
+    uint8_t count = 0;
+    uint64_t overhead;
+    float ns_per_tick = 1e9f / (float) profiler_ClockHz();
+
+    if ((htim4.Instance->CR1 & TIM_CR1_CEN) || iterations == 0)
+        return 0;
+
+    bench_Setup();
+    overhead = bench_Time(case_Empty, iterations);
+
+    for (uint8_t k = 0; k < sizeof(cases) / sizeof(cases[0]) && count < max; k++) {
+        int32_t heap = bench_HeapUsed();
+        uint64_t ticks = bench_Time(cases[k].run, iterations);
+        BenchResult* r = &result[count++];
+
+        ticks = ticks > overhead ? ticks - overhead : 0;
+        r->name = cases[k].name;
+        r->calls = iterations;
+        r->ticks_per_call = (float) ticks / (float) iterations;
+        r->ns_per_call = r->ticks_per_call * ns_per_tick;
+        r->heap_delta = bench_HeapUsed() - heap;
+    }
+
+    mg513_PWM(LEFT, 0);
+    return count;
+}
+
+//与基准比较
+//float baseline_ns             基准耗时，<=0 表示没有基准
+//float tolerance               允许的变慢比例，0.1 表示 10%
+uint8_t bench_Check(const BenchResult* result, float baseline_ns, float tolerance) {
+    if (baseline_ns <= 0)
+        return 0;
+    return result->ns_per_call > baseline_ns * (1.0f + tolerance);
+}
+
+//通过遥测上报，每项一帧
+void bench_Report(const BenchResult* result, uint8_t count) {
+    for (uint8_t k = 0; k < count; k++) {
+        float ch[] = {result[k].ticks_per_call, result[k].ns_per_call, (float) result[k].heap_delta};
+        telemetry_Send(BENCH_FRAME | k, ch, 3);
+    }
+}
@@ -1,12 +1,29 @@
 #include "encoder.h"
-#include "limits.h"
 
-#define PI 3.1415926
+#define PI 3.1415926f
+#define EDGE_TIMEOUT_MS 1000        //超过该时间没有边沿视为停转
+#define COUNT_HALF      0x8000      //16位计数器半程，判断溢出方向
 
 //初始化编码器
 void initEncoder(Encoder* ecd, const Parameter param){
     ecd->param = param;
 
+    //预计算换算系数
+    float cpr = (float) param.multiple * param.reduction_ratio * (float) param.ppr;     //输出轴每圈计数
+    ecd->scale.count_to_rot = 1.0f / cpr;
+    ecd->scale.count_to_rpm = 60000.0f / cpr;
+    ecd->scale.rpm_to_linear = 2.0f * PI * param.r / 60.0f;
+    ecd->scale.period = 0;
+    ecd->scale.inv_period = 0;
+    ecd->scale.cycles_per_ms = (float) SystemCoreClock / 1000.0f;
+    ecd->scale.edge_counts = (float) param.multiple / 2.0f;
+
+    //边沿时刻使用DWT周期计数器
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    ecd->edge.primed = 0;
+    ecd->edge.last_seq = ecd->edge.edge_seq;
+
     //初始化速度
     ecd->velocity.angular = 0;
     ecd->velocity.linear = 0;
@@ -18,8 +35,6 @@ void initEncoder(Encoder* ecd, const Parameter param){
     ecd->counter.count_increment = 0;
     ecd->counter.count_total = 0;
     ecd->counter.count_overflow = 0;
-    ecd->counter.JUMP_THRESHOLD = 30000;
-    ecd->counter.TIMx_MAX_COUNT = 0;
 
     //初始化位置
     ecd->position.rotations = 0;    //圈数
@@ -28,12 +43,18 @@ void initEncoder(Encoder* ecd, const Parameter param){
 
     //初始化方向
     ecd->direction = INIT;
+
+    //计数器从零点开始，见restEncoder
+    __HAL_TIM_SetCounter(param.tim_hander, ENCODER_COUNT_ORIGIN);
 }
 
 //重置编码器
 void restEncoder(Encoder* ecd) {
 
-    __HAL_TIM_SetCounter(ecd->param.tim_hander,0);
+    //零点放在计数器中间，远离回绕点0/65535：停在零点附近抖动时不会溢出，
+    //否则更新中断被推迟时一次上溢和一次下溢合并成一个UIF，溢出次数会差65536
+    __HAL_TIM_SetCounter(ecd->param.tim_hander, ENCODER_COUNT_ORIGIN);
+    __HAL_TIM_CLEAR_IT(ecd->param.tim_hander, TIM_IT_UPDATE);   //丢弃清零前的溢出
 
     //初始化速度
     ecd->velocity.angular = 0;
@@ -46,8 +67,6 @@ void restEncoder(Encoder* ecd) {
     ecd->counter.count_increment = 0;
     ecd->counter.count_total = 0;
     ecd->counter.count_overflow = 0;
-    ecd->counter.JUMP_THRESHOLD = 30000;
-    ecd->counter.TIMx_MAX_COUNT = 0;
 
     //初始化位置
     ecd->position.rotations = 0;    //圈数
@@ -56,69 +75,133 @@ void restEncoder(Encoder* ecd) {
 
     //初始化方向
     ecd->direction = INIT;
-}
 
-//获取编码器状态（循环）
-void updateEncoderLoop(Encoder* ecd, uint8_t loop_period){
-    //direction
-    ecd->direction = __HAL_TIM_IS_TIM_COUNTING_DOWN(ecd->param.tim_hander);
+    //重新开始M/T测速：清零前记录的边沿计数值已失效，等待下一个边沿
+    ecd->edge.primed = 0;
+    ecd->edge.last_seq = ecd->edge.edge_seq;
+}
 
-    //------counter
-    //counter_now
-    ecd->counter.count_now = (uint16_t) __HAL_TIM_GET_COUNTER(ecd->param.tim_hander);
-    //
-    ecd->counter.count_increment = (int32_t)ecd->counter.count_now - (int32_t)ecd->counter.count_last;
-
-    //counter_increment
-    //溢出检测
-    if(ecd->counter.count_increment > ecd->counter.JUMP_THRESHOLD){
-        //down overflow
+//计数器溢出（定时器更新中断）
+//ARR = 65535，上溢后CNT从0附近开始，下溢后从65535附近开始
+//按中断中读到的CNT判断方向，只要中断延迟不超过半程（32768计数）就不会判错
+void encoderOverflow(Encoder* ecd) {
+    if ((uint16_t) __HAL_TIM_GET_COUNTER(ecd->param.tim_hander) < COUNT_HALF)
+        ecd->counter.count_overflow++;
+    else
         ecd->counter.count_overflow--;
+}
 
-        //16bits or 32bits
-        if(ecd->counter.count_last > USHRT_MAX || ecd->counter.count_now > USHRT_MAX){
-            //32bits
-            ecd->counter.TIMx_MAX_COUNT = UINT_MAX;     //2^32 - 1
-        }else {
-            //16bits
-            ecd->counter.TIMx_MAX_COUNT = USHRT_MAX;    //2^16 - 1
+//读取64位总计数（相对零点ENCODER_COUNT_ORIGIN）
+//主循环中读取时可能被更新中断打断，溢出次数前后不一致则重读；
+//在同优先级中断（控制中断）中读取时更新中断还未执行，溢出标志置位则自行补上这次溢出
+int64_t encoderCount64(Encoder* ecd) {
+    TIM_HandleTypeDef* htim = ecd->param.tim_hander;
+    int32_t raw, overflow;
+    uint16_t count;
+
+    do {
+        raw = ecd->counter.count_overflow;
+        overflow = raw;
+        count = (uint16_t) __HAL_TIM_GET_COUNTER(htim);
+        if (__HAL_TIM_GET_FLAG(htim, TIM_FLAG_UPDATE)) {
+            //已溢出但中断还未计数
+            count = (uint16_t) __HAL_TIM_GET_COUNTER(htim);
+            overflow += count < COUNT_HALF ? 1 : -1;
         }
+    } while (raw != ecd->counter.count_overflow);
 
-        //compensate - (TIMx_MAX_COUNT+1)
-        ecd->counter.count_increment = ecd->counter.count_increment - ecd->counter.TIMx_MAX_COUNT - 1;
-    } else if(ecd->counter.count_increment < -ecd->counter.JUMP_THRESHOLD){
-        //up overflow
-        ecd->counter.count_overflow++;
+    return (int64_t) overflow * 65536 + count - ENCODER_COUNT_ORIGIN;
+}
 
-        //16bits or 32bits
-        if(ecd->counter.count_last > USHRT_MAX || ecd->counter.count_now > USHRT_MAX){
-            //32bits
-            ecd->counter.TIMx_MAX_COUNT = UINT_MAX;     //2^32 - 1
-        }else {
-            //16bits
-            ecd->counter.TIMx_MAX_COUNT = USHRT_MAX;    //2^16 - 1
-        }
+//读取32位总计数（约±2^31计数后回绕）
+int32_t encoderCount32(Encoder* ecd) {
+    return (int32_t) encoderCount64(ecd);
+}
+
+//A相边沿（EXTI中断）
+void encoderEdge(Encoder* ecd) {
+    ecd->edge.edge_time = DWT->CYCCNT;
+    ecd->edge.edge_count = (uint16_t) __HAL_TIM_GET_COUNTER(ecd->param.tim_hander);
+    ecd->edge.edge_seq++;
+}
 
-        //compensate + (TIMx_MAX_COUNT+1)
-        ecd->counter.count_increment = ecd->counter.count_increment + ecd->counter.TIMx_MAX_COUNT + 1;
+//M/T测速
+//采样间隔内有新边沿：用上次与本次所取两个边沿之间的计数差除以两边沿的时间差（M/T法），
+//高速时时间差接近采样周期，相当于M法；低速时两边沿可跨多个采样周期，相当于T法，两者之间连续过渡
+//采样间隔内没有边沿：速度不可能超过“一个边沿间隔/距上个边沿的时间”，据此把速度向0收敛
+//超过EDGE_TIMEOUT_MS没有边沿视为停转，下一个边沿只作为新的起点
+//DWT周期计数器72MHz下约59.6s回绕，时刻按无符号差计算，两边沿间隔不超过EDGE_TIMEOUT_MS时不受回绕影响
+//uint32_t now                  当前时刻  DWT周期
+//float velocity                上次估计值  rpm
+float estimateVelocity(EdgeTimer* edge, uint32_t now, float count_to_rpm, float cycles_per_ms,
+                       float edge_counts, float velocity) {
+    uint16_t seq = edge->edge_seq;
+    uint32_t time = edge->edge_time;
+    uint16_t count = edge->edge_count;
+    uint32_t timeout = (uint32_t) (cycles_per_ms * EDGE_TIMEOUT_MS);
+    uint32_t elapsed;
+    float bound;
+
+    if (seq != edge->last_seq) {
+        int16_t dn = (int16_t) (count - edge->last_count);
+        uint32_t dt = time - edge->last_time;
+        uint8_t primed = edge->primed;
+
+        edge->last_time = time;
+        edge->last_count = count;
+        edge->last_seq = seq;
+        edge->primed = 1;
+        //复位或停转后的第一个边沿只作为起点
+        if (!primed || dt > timeout)
+            return 0;
+        if (dt != 0)
+            velocity = (float) dn * count_to_rpm * cycles_per_ms / (float) dt;
+        return velocity;
     }
 
-    //counter_total
-    ecd->counter.count_total += ecd->counter.count_increment;
+    //没有新边沿
+    if (!edge->primed)
+        return 0;
+    elapsed = now - edge->last_time;
+    if (elapsed > timeout) {
+        edge->primed = 0;
+        return 0;
+    }
+    bound = edge_counts * count_to_rpm * cycles_per_ms / (float) elapsed;
+    if (velocity > bound)
+        velocity = bound;
+    else if (velocity < -bound)
+        velocity = -bound;
+    return velocity;
+}
+
+//获取编码器状态（循环）
+//float loop_period            调用周期  ms
+void updateEncoderLoop(Encoder* ecd, float loop_period){
+    //direction
+    ecd->direction = __HAL_TIM_IS_TIM_COUNTING_DOWN(ecd->param.tim_hander);
+
+    //------counter
+    //溢出已在更新中断中计数，这里直接读取完整计数，与调用周期无关
+    ecd->counter.count_total = encoderCount64(ecd);
+    ecd->counter.count_now = (uint16_t) ecd->counter.count_total;
+    ecd->counter.count_increment = (int32_t) (ecd->counter.count_total - ecd->counter.count_last);
+    ecd->counter.count_last = ecd->counter.count_total;
 
     //------position
-    ecd->position.rotations = (float) ecd->counter.count_total /
-                              ((float) ecd->param.multiple * ecd->param.reduction_ratio * ecd->param.ppr);
-    ecd->position.angle = ecd->position.rotations * 360;
-    ecd->position.distance = ecd->position.rotations / 60.0 * PI * 2.0 * ecd->param.r;
+    ecd->position.rotations = (float) ecd->counter.count_total * ecd->scale.count_to_rot;
+    ecd->position.angle = ecd->position.rotations * 360.0f;
+    ecd->position.distance = ecd->position.rotations * ecd->scale.rpm_to_linear;
 
     //------velocity
-    ecd->velocity.angular = (float) (ecd->counter.count_increment /
-                                     ((float) ecd->param.multiple * ecd->param.reduction_ratio * ecd->param.ppr) *
-                                     1000.0 / loop_period * 60);
-    ecd->velocity.acceleration = (float) (ecd->velocity.angular / loop_period);
-    ecd->velocity.linear = (float) (ecd->velocity.angular / 60.0 * PI * 2.0 * ecd->param.r);
-
-    //更新count_last
-    ecd->counter.count_last = ecd->counter.count_now;
+    //周期不变时复用倒数，避免每次做除法
+    if (loop_period != ecd->scale.period) {
+        ecd->scale.period = loop_period;
+        ecd->scale.inv_period = 1.0f / loop_period;
+    }
+    float angular = estimateVelocity(&ecd->edge, DWT->CYCCNT, ecd->scale.count_to_rpm,
+                                     ecd->scale.cycles_per_ms, ecd->scale.edge_counts, ecd->velocity.angular);
+    ecd->velocity.angular = angular;
+    ecd->velocity.acceleration = ecd->velocity.angular * ecd->scale.inv_period;
+    ecd->velocity.linear = ecd->velocity.angular * ecd->scale.rpm_to_linear;
 }
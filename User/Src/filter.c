@@ -1,50 +1,167 @@
 #include "filter.h"
-#include "stdlib.h"
+#include "math.h"
 
-float buffer[FILTER_SIZE] = {0};
-uint8_t buffer_index = 10;
+#define PI 3.1415926f
 
 //------低通滤波器------//
-float alpha = 0.5; // 滤波器系数
-float filtered = 0; // 初始化滤波后的值
-float lowPassFilter(float new_value) {
-    filtered = alpha * new_value + (1 - alpha) * filtered;
-    return filtered;
+//float cutoff                  截止频率  Hz
+//float period                  采样周期  ms
+void initLowPass(LowPass* f, float cutoff, float period) {
+    float dt = period * 0.001f;
+    float rc = 1.0f / (2.0f * PI * cutoff);
+    f->alpha = dt / (rc + dt);
+    f->y = 0;
+    f->primed = 0;
 }
 
-//----滑动平均滤波器----//
-float buffer_sum = 0; // 用于存储累加值
-float movingAverageFilter(float new_value) {
-    // 从累加值中减去将被替换的老值
-    buffer_sum -= buffer[buffer_index];
-    // 将新值添加到缓冲区并更新累加值
-    buffer[buffer_index] = new_value;
-    buffer_sum += new_value;
-    // 更新索引
-    buffer_index = (buffer_index + 1) % FILTER_SIZE;
+void setLowPassAlpha(LowPass* f, float alpha) {
+    f->alpha = alpha;
+}
+
+float updateLowPass(LowPass* f, float x) {
+    if (!f->primed) {
+        f->y = x;
+        f->primed = 1;
+    } else {
+        f->y += f->alpha * (x - f->y);
+    }
+    return f->y;
+}
 
-    // 返回更新后的平均值
-    return buffer_sum / FILTER_SIZE;
+//----滑动平均滤波器----//
+void initMovingAverage(MovingAverage* f) {
+    for (uint8_t i = 0; i < FILTER_SIZE; i++) {
+        f->buf[i] = 0;
+    }
+    f->sum = 0;
+    f->index = 0;
+    f->count = 0;
 }
 
+float updateMovingAverage(MovingAverage* f, float x) {
+    // 从累加值中减去将被替换的老值，加上新值
+    f->sum += x - f->buf[f->index];
+    f->buf[f->index] = x;
+    if (++f->index >= FILTER_SIZE) {
+        f->index = 0;
+        // 每转一圈重新求和一次，消除累加误差
+        f->sum = 0;
+        for (uint8_t i = 0; i < FILTER_SIZE; i++) {
+            f->sum += f->buf[i];
+        }
+    }
+    if (f->count < FILTER_SIZE)
+        f->count++;
+
+    // 窗口未满时按已有样本数平均
+    return f->sum / (float) f->count;
+}
 
 //------中值滤波器------//
-int compareFloats(const void *a, const void *b) {
-    float f1 = *(float*)a;
-    float f2 = *(float*)b;
+void initMedian(Median* f) {
+    for (uint8_t i = 0; i < FILTER_SIZE; i++) {
+        f->ring[i] = 0;
+        f->sorted[i] = 0;
+    }
+    f->index = 0;
+    f->count = 0;
+}
 
-    // 返回负数、零或正数，使得较小的数排在前面
-    return (f1 < f2) ? -1 : (f1 > f2) ? 1 : 0;
+//按环形缓冲重新插入排序（有序数组与环形缓冲不一致时使用）
+static void median_Rebuild(Median* f) {
+    for (uint8_t k = 0; k < FILTER_SIZE; k++) {
+        float v = f->ring[k];
+        uint8_t i = k;
+        while (i > 0 && f->sorted[i - 1] > v) {
+            f->sorted[i] = f->sorted[i - 1];
+            i--;
+        }
+        f->sorted[i] = v;
+    }
 }
 
-float medianFilter(float new_value) {
-    // 将新值添加到缓冲区
-    buffer[buffer_index] = new_value;
-    // 更新索引
-    buffer_index = (buffer_index + 1) % FILTER_SIZE;
+//移出最老样本、插入新样本，一次移位保持有序，不再每次排序
+//NaN、Inf不进入窗口（NaN与任何值比较都不相等，会破坏有序数组），输出保持上次的中值
+float updateMedian(Median* f, float x) {
+    uint8_t n = f->count;
+    uint8_t i;
+
+    if (!isfinite(x))
+        return f->sorted[n / 2];
+
+    if (n < FILTER_SIZE) {
+        //窗口未满：直接插入
+        i = n;
+        while (i > 0 && f->sorted[i - 1] > x) {
+            f->sorted[i] = f->sorted[i - 1];
+            i--;
+        }
+        f->sorted[i] = x;
+        f->count = ++n;
+    } else {
+        //找到最老样本在有序数组中的位置，向新值方向移位后放入新值
+        float old = f->ring[f->index];
+        i = 0;
+        while (i < FILTER_SIZE && f->sorted[i] != old) {
+            i++;
+        }
+        if (i >= FILTER_SIZE) {
+            //找不到最老样本（状态被改写）：放入新值后整体重建
+            f->ring[f->index] = x;
+            median_Rebuild(f);
+        } else {
+            while (i > 0 && f->sorted[i - 1] > x) {
+                f->sorted[i] = f->sorted[i - 1];
+                i--;
+            }
+            while (i < FILTER_SIZE - 1 && f->sorted[i + 1] < x) {
+                f->sorted[i] = f->sorted[i + 1];
+                i++;
+            }
+            f->sorted[i] = x;
+        }
+    }
+
+    f->ring[f->index] = x;
+    if (++f->index >= FILTER_SIZE)
+        f->index = 0;
 
-    // 对缓冲区数据进行排序
-    qsort(buffer, FILTER_SIZE, sizeof(float), compareFloats);
-    // 返回中值
-    return buffer[FILTER_SIZE / 2];
-}
\ No newline at end of file
+    return f->sorted[n / 2];
+}
+
+//------二阶IIR------//
+void initBiquad(Biquad* f, float b0, float b1, float b2, float a1, float a2) {
+    f->b0 = b0;
+    f->b1 = b1;
+    f->b2 = b2;
+    f->a1 = a1;
+    f->a2 = a2;
+    resetBiquad(f);
+}
+
+//二阶低通（双线性变换）
+//float cutoff                  截止频率  Hz，需小于采样频率的一半
+//float period                  采样周期  ms
+//float q                       品质因数
+void initBiquadLowPass(Biquad* f, float cutoff, float period, float q) {
+    float w0 = 2.0f * PI * cutoff * period * 0.001f;
+    float cw = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+
+    initBiquad(f, (1.0f - cw) * 0.5f / a0, (1.0f - cw) / a0, (1.0f - cw) * 0.5f / a0,
+               -2.0f * cw / a0, (1.0f - alpha) / a0);
+}
+
+void resetBiquad(Biquad* f) {
+    f->w1 = 0;
+    f->w2 = 0;
+}
+
+float updateBiquad(Biquad* f, float x) {
+    float w = x - f->a1 * f->w1 - f->a2 * f->w2;
+    float y = f->b0 * w + f->b1 * f->w1 + f->b2 * f->w2;
+    f->w2 = f->w1;
+    f->w1 = w;
+    return y;
+}
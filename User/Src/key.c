@@ -1,23 +1,94 @@
 #include "key.h"
 
-//按键    ok
-GPIO_PinState ReadKeyState() {
-    GPIO_PinState mValue = GPIO_PIN_SET;
-    if (HAL_GPIO_ReadPin(Key_OK_GPIO_Port, Key_OK_Pin) == GPIO_PIN_RESET) {
-        HAL_Delay(50);
-        while (HAL_GPIO_ReadPin(Key_OK_GPIO_Port, Key_OK_Pin) == GPIO_PIN_RESET);
-        mValue = GPIO_PIN_RESET;
+//移位寄存器消抖：每KEY_SAMPLE_MS采样一次移入history，连续8次相同才改变状态（约40ms）
+typedef struct {
+    uint8_t history;        //最近8次采样，1为按下
+    uint8_t pressed;        //消抖后的状态
+    uint16_t held;          //按住的采样次数，每次自动重复后回到长按点
+}KeyState;
+
+static KeyState keys[KEY_COUNT];
+static uint8_t sample_div;
+
+//事件队列：head只由生产者（SysTick中断）写，tail只由消费者（主循环）写
+static KeyEvent queue[KEY_QUEUE_SIZE];
+static volatile uint8_t queue_head;     //写入位置（自由计数）
+static volatile uint8_t queue_tail;     //读取位置（自由计数）
+static uint32_t dropped;
+
+static uint8_t key_Sample(uint8_t key) {
+    if (key == KEY_OK)
+        return HAL_GPIO_ReadPin(Key_OK_GPIO_Port, Key_OK_Pin) == GPIO_PIN_RESET;
+    return HAL_GPIO_ReadPin(Key_ON_GPIO_Port, Key_ON_Pin) == GPIO_PIN_RESET;
+}
+
+static void key_Push(uint8_t key, uint8_t type) {
+    uint8_t head = queue_head;
+
+    if ((uint8_t) (head - queue_tail) >= KEY_QUEUE_SIZE) {
+        dropped++;
+        return;
+    }
+    queue[head & (KEY_QUEUE_SIZE - 1)].key = key;
+    queue[head & (KEY_QUEUE_SIZE - 1)].type = type;
+    queue_head = head + 1;      //数据写完后再发布
+}
+
+//清空状态与事件队列
+void key_Init(void) {
+    for (uint8_t i = 0; i < KEY_COUNT; i++) {
+        keys[i].history = 0;
+        keys[i].pressed = 0;
+        keys[i].held = 0;
     }
-    return mValue;
+    sample_div = 0;
+    queue_head = 0;
+    queue_tail = 0;
+    dropped = 0;
 }
 
-//按键    on/off
-uint16_t ReadKey2State() {
-    static uint16_t mValue = 0;
-    if (HAL_GPIO_ReadPin(Key_ON_GPIO_Port, Key_ON_Pin) == GPIO_PIN_RESET) {
-        HAL_Delay(50);
-        while (HAL_GPIO_ReadPin(Key_ON_GPIO_Port, Key_ON_Pin) == GPIO_PIN_RESET);
-        mValue = !mValue;
+//1ms周期调用：采样、消抖、产生事件，不等待
+void key_Tick(void) {
+    if (++sample_div < KEY_SAMPLE_MS)
+        return;
+    sample_div = 0;
+
+    for (uint8_t i = 0; i < KEY_COUNT; i++) {
+        KeyState* k = &keys[i];
+        k->history = (uint8_t) (k->history << 1) | key_Sample(i);
+
+        if (!k->pressed && k->history == 0xFF) {
+            k->pressed = 1;
+            k->held = 0;
+            key_Push(i, KEY_EVENT_PRESS);
+        } else if (k->pressed && k->history == 0x00) {
+            k->pressed = 0;
+            key_Push(i, KEY_EVENT_RELEASE);
+        } else if (k->pressed) {
+            //长按与自动重复：从确认按下开始计时，松开时的抖动不影响
+            k->held++;
+            if (k->held == KEY_LONG_MS / KEY_SAMPLE_MS) {
+                key_Push(i, KEY_EVENT_LONG);
+            } else if (k->held == (KEY_LONG_MS + KEY_REPEAT_MS) / KEY_SAMPLE_MS) {
+                k->held = KEY_LONG_MS / KEY_SAMPLE_MS;
+                key_Push(i, KEY_EVENT_REPEAT);
+            }
+        }
     }
-    return mValue;
+}
+
+//取出一个事件，队列空返回0
+uint8_t key_Read(KeyEvent* event) {
+    uint8_t tail = queue_tail;
+
+    if (tail == queue_head)
+        return 0;
+    *event = queue[tail & (KEY_QUEUE_SIZE - 1)];
+    queue_tail = tail + 1;      //数据读完后再释放
+    return 1;
+}
+
+//队列满丢弃的事件数
+uint32_t key_Dropped(void) {
+    return dropped;
 }
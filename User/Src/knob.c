@@ -0,0 +1,84 @@
+#include "knob.h"
+
+//格雷码状态转移表：下标为 上次状态 << 2 | 当前状态，状态为 A << 1 | B
+//顺时针 00 -> 10 -> 11 -> 01 -> 00 记+1，逆时针记-1
+//状态不变记0；AB同时变化无法判断方向，记0并计入invalid
+//触点抖动表现为同一相来回变化，+1、-1相互抵消，不会计错方向
+static const int8_t knob_table[16] = {
+     0, -1, +1,  0,
+    +1,  0,  0, -1,
+    -1,  0,  0, +1,
+     0, +1, -1,  0
+};
+
+static uint8_t state;               //上次AB相状态
+static int8_t quarter;              //未满一格的状态变化次数
+static uint32_t last_tick;          //上一格的时刻 ms
+static volatile int16_t detents;    //累计格数，主循环读取后清零
+static volatile int16_t steps;      //累计加速后的格数
+static uint32_t invalid;
+
+//A、B都在GPIOB，一次读IDR得到同一时刻的两相电平
+static uint8_t knob_State(void) {
+    uint32_t idr = Encoder_A_GPIO_Port->IDR;
+    return (uint8_t) (((idr & Encoder_A_Pin) ? 2 : 0) | ((idr & Encoder_B_Pin) ? 1 : 0));
+}
+
+//读取AB相初始状态并清零计数
+void knob_Init(void) {
+    state = knob_State();
+    quarter = 0;
+    last_tick = HAL_GetTick() - KNOB_MEDIUM_MS;
+    detents = 0;
+    steps = 0;
+    invalid = 0;
+}
+
+//AB相边沿中断：查表累计状态变化，满一格记一次，按与上一格的间隔加速
+void knob_Edge(void) {
+    uint8_t now = knob_State();
+    uint8_t index = (uint8_t) (state << 2 | now);
+    uint32_t tick, gap;
+    int8_t gain;
+
+    if (now == state)
+        return;
+    if ((state ^ now) == 3)
+        invalid++;
+    state = now;
+    quarter += knob_table[index];
+    if (quarter > -KNOB_STEPS_PER_DETENT && quarter < KNOB_STEPS_PER_DETENT)
+        return;
+
+    tick = HAL_GetTick();
+    gap = tick - last_tick;
+    last_tick = tick;
+    gain = gap < KNOB_FAST_MS ? KNOB_FAST_GAIN : gap < KNOB_MEDIUM_MS ? KNOB_MEDIUM_GAIN : 1;
+    if (quarter > 0) {
+        detents++;
+        steps += gain;
+    } else {
+        detents--;
+        steps -= gain;
+    }
+    quarter = 0;
+}
+
+//取出累计的增量并清零
+KnobDelta knob_Read(void) {
+    KnobDelta delta;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    delta.detents = detents;
+    delta.steps = steps;
+    detents = 0;
+    steps = 0;
+    __set_PRIMASK(primask);
+    return delta;
+}
+
+//AB相同时变化被丢弃的次数
+uint32_t knob_Invalid(void) {
+    return invalid;
+}
@@ -4,642 +4,691 @@
 #include "tim.h"
 #include "pid.h"
 #include "key.h"
+#include "knob.h"
 #include "encoder.h"
+#include "profiler.h"
 
-int16_t this_y;
-static uint16_t prevKey2State;
-uint16_t currentKey2State;
-
-extern int16_t encoder_num;
-extern MotorMode Mode;
-extern PID vec_l,vel_r;
-extern PID ang_l,ang_r;
-
-void Menu_option(void);//选项指针更新
-
-//初始化
-void Menu_MODE1_Init(void); //Speed Control
-void Menu_MODE2_Init(void); //Position Control
-void Menu_MODE3_Init(void); //Speed Follow
-void Menu_MODE4_Init(void); //Position Follow
-void Menu_MODE5_Init(void); //Cascade Control
-
-//页面逻辑
-void Menu_Mode1(void);      //Speed Control
-void Menu_Mode2(void);      //Position Control
-void Menu_Mode3(void);      //Speed Follow
-void Menu_Mode4(void);      //Position Follow
-void Menu_Mode5(void);      //Cascade Control
-
-//选项逻辑
-void Menu_Start_OK(void);   //主页
-void Menu_Mode1_OK(void);   //Speed Control
-void Menu_Mode2_OK(void);   //Position Control
-void Menu_Mode3_OK(void);   //Speed Follow
-void Menu_Mode4_OK(void);   //Position Follow
-void Menu_Mode5_OK(void);   //Cascade Control
-
-//选项指针更新
-void Menu_option() {
-    this_y = encoder_num;
-    OLED_ClearArea(0, 0, 16, 64);
-    OLED_ShowImage(0, (int16_t)(this_y * 9), 16, 9, This);
-    OLED_Update();
+#define MENU_REFRESH_MS     100     //实时数据（指令队列、诊断统计）的检查周期 ms
+
+//页面，page_table的下标
+typedef enum {
+    PAGE_HOME,
+    PAGE_MODE1,     //Speed Control
+    PAGE_MODE2,     //Position Control
+    PAGE_MODE3,     //Speed Follow
+    PAGE_MODE4,     //Position Follow
+    PAGE_MODE5,     //Speed Curve
+    PAGE_MODE6,     //Position Curve
+    PAGE_MODE7,     //Diagnostics
+    PAGE_TUNE,      //PID Tuning，模式页长按OK打开
+    PAGE_COUNT
+}MenuPage;
+
+//菜单项类型
+typedef enum {
+    ITEM_TEXT,      //只显示文字，光标不可达
+    ITEM_PAGE,      //OK进入target页
+    ITEM_BACK,      //OK回到主页
+    ITEM_EDIT       //OK开始编辑edit绑定的数值，再按OK确认
+}ItemKind;
+
+//数值的显示方式
+typedef enum {
+    SHOW_SIGNED,    //有符号数，以10^-frac为单位存储
+    SHOW_UNSIGNED,  //无符号数
+    SHOW_CHOICE,    //显示choices[value]
+    SHOW_MARK,      //编辑时显示选中标记，不显示数值
+    SHOW_CUSTOM     //由页面的show绘制
+}EditShow;
+
+#define EDIT_WRAP       0x01    //超出min~max时回绕，否则限幅
+#define EDIT_LIVE       0x02    //每次修改都调用action，否则OK确认时调用
+
+#define PAGE_MOTOR      0x01    //第0行显示ON/OFF，进入时切换电机模式，返回时停止电机
+#define PAGE_LEFT_ONLY  0x02    //只用左电机：确认数值后关闭右电机PWM
+#define PAGE_OVERLAY    0x04    //叠加在模式页上：BACK回到打开它的页面，不切换电机模式、不停止电机
+
+//可编辑的数值：显示在光标所在行的第x列
+typedef struct {
+    int16_t* value;
+    const char* const* choices;     //SHOW_CHOICE的选项文字
+    void (*action)(void);           //确认数值后的动作，可为NULL
+    int16_t step, min, max;         //每格改变量与范围
+    uint8_t show;                   //EditShow
+    uint8_t flags;
+    uint8_t x;
+    uint8_t digits;                 //整数位数
+    uint8_t frac;                   //小数位数
+}EditDesc;
+
+//菜单项：文字在第16列
+typedef struct {
+    const char* label;
+    const EditDesc* edit;           //ITEM_EDIT绑定的数值
+    uint8_t kind;                   //ItemKind
+    uint8_t target;                 //ITEM_PAGE进入的页面
+}ItemDesc;
+
+//页面：items从第first行起每项一行，光标在first~last行之间移动
+typedef struct {
+    const ItemDesc* items;
+    uint8_t count;
+    uint8_t first, last;
+    uint8_t flags;
+    MotorMode mode;                 //PAGE_MOTOR：进入时切换的电机模式
+    void (*show)(void);             //绘制页面的实时数据，可为NULL
+    uint32_t (*stamp)(void);        //实时数据的状态，变化时才调用show；NULL表示只在进入时绘制
+}PageDesc;
+
+static uint8_t page;                //当前页面
+static int8_t this_y;               //光标所在行
+static int8_t home_y;               //进入模式页时主页的光标行，返回时恢复
+static uint8_t editing;             //1：旋钮修改光标所在行的数值，OK键确认
+static uint8_t running;             //1：ON/OFF键已打开电机
+static uint8_t dirty;               //显存有修改，待刷新
+static uint32_t flush_count;        //刷新屏幕次数
+static uint32_t shown_stamp;        //实时数据上次显示时的状态，变化时才重绘
+static uint32_t refresh_tick;
+static uint8_t overlay_return;      //PAGE_OVERLAY页面返回的页面
+static uint8_t ok_long;             //1：本次按住OK已产生长按
+
+//各模式页编辑的数值
+static int16_t mode1_speed, mode2_angle, mode3_speed;
+static int16_t mode4_side;          //0跟随左电机，1跟随右电机
+static int16_t mode5_speed;
+static int16_t mode5_accel;         //0.1rpm/10ms
+static int16_t mode6_angle;
+static int16_t mode6_speed;
+static int16_t diag_mode = Speed_Control;
+
+//参数整定页：tune为所选控制环的参数，tune_xx为编辑用的定点值（单位见tune_items）
+static PIDTune tune;
+static int16_t tune_loop;
+static int16_t tune_kp, tune_ki, tune_kd, tune_max_output, tune_max_integral;
+
+extern PID vec_l;
+extern PID ang_l;
+
+static void Menu_Diag_Show(void);
+static uint32_t Menu_Diag_Stamp(void);
+
+//------确认数值后的动作------//
+static void Menu_SetSpeed(void) {
+    setPIDTarget(&vec_l, mode1_speed);                  //更新目标速度
 }
 
-//菜单主页初始化
-void Menu_Init() {
-    OLED_Init();
-    OLED_Clear();
-    OLED_ShowString(16, 0, "Speed Control", OLED_6X8);
-    OLED_ShowString(16, 9 * 1, "Position Control", OLED_6X8);
-    OLED_ShowString(16, 9 * 2, "Speed Follow", OLED_6X8);
-    OLED_ShowString(16, 9 * 3, "Position Follow", OLED_6X8);
-    OLED_ShowString(16, 9 * 4, "Speed Curve", OLED_6X8);
-    OLED_ShowString(16, 9 * 5, "Position Curve", OLED_6X8);
-    OLED_ShowString(16, 9 * 6, "MODE7", OLED_6X8);
-    OLED_Update();
+static void Menu_SetAngle(void) {
+    setPIDTarget(&ang_l, mode2_angle);                  //更新目标角度
 }
 
-//MODE1初始化
-void Menu_MODE1_Init() {
-    OLED_Clear();
-    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-    OLED_ReverseArea(14, -1, 21, 9);
-    OLED_ShowString(16, 9 * 1, "SetSpeed", OLED_6X8);
-    OLED_ShowString(16, 9 * 2, "BACK", OLED_6X8);
-    OLED_ShowString(16, 9 * 3, "Kp", OLED_6X8);
+static void Menu_SetFollowSpeed(void) {
+    setPIDTarget(&vec_l, mode3_speed);                  //跟随模式转动时即更新目标速度
+}
+
+static void Menu_SetFollowSide(void) {
+    mg513_SetMode(mode4_side ? Position_Follow_R : Position_Follow_L);
+}
+
+static void Menu_PlanSpeed(void) {
+    mg513_PlanSpeed(mode5_speed, mode5_accel * 10.0f, 0);               //0.1rpm/10ms -> rpm/s
+}
+
+static void Menu_PlanPosition(void) {
+    mg513_PlanPosition(mode6_angle, mode6_speed * 6.0f, 0, 0);          //追加到指令队列  rpm -> °/s
+}
+
+//浮点值按单位scale转为编辑用的定点值（饱和）
+static int16_t Menu_ToFixed(float value, float scale) {
+    float x = value / scale + (value >= 0 ? 0.5f : -0.5f);
+    if (x > INT16_MAX)
+        return INT16_MAX;
+    if (x < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t) x;
+}
+
+//读取所选控制环的当前参数
+static void Menu_TuneLoad(void) {
+    mg513_GetTune((TuneLoop) tune_loop, &tune);
+    tune_kp = Menu_ToFixed(tune.kp, 0.01f);
+    tune_ki = Menu_ToFixed(tune.ki, 0.001f);
+    tune_kd = Menu_ToFixed(tune.kd, 0.01f);
+    tune_max_output = Menu_ToFixed(tune.max_output, 1.0f);
+    tune_max_integral = Menu_ToFixed(tune.max_integral, 1.0f);
+}
+
+//提交修改：只改变了定点值的一项，其余各项保持原浮点值
+static void Menu_TuneApply(void) {
+    if (tune_kp != Menu_ToFixed(tune.kp, 0.01f))
+        tune.kp = tune_kp * 0.01f;
+    if (tune_ki != Menu_ToFixed(tune.ki, 0.001f))
+        tune.ki = tune_ki * 0.001f;
+    if (tune_kd != Menu_ToFixed(tune.kd, 0.01f))
+        tune.kd = tune_kd * 0.01f;
+    if (tune_max_output != Menu_ToFixed(tune.max_output, 1.0f))
+        tune.max_output = tune_max_output;
+    if (tune_max_integral != Menu_ToFixed(tune.max_integral, 1.0f))
+        tune.max_integral = tune_max_integral;
+    mg513_Tune((TuneLoop) tune_loop, &tune);
+}
+
+static void Menu_ShowTune(void);
+
+//切换控制环：读取并显示其参数
+static void Menu_TuneSelect(void) {
+    Menu_TuneLoad();
+    Menu_ShowTune();
+}
+
+//------页面的实时数据------//
+//速度环参数，进入页面时显示
+static void Menu_ShowGains(void) {
     OLED_ShowFloatNum(92, 9 * 3, vec_l.kp, 2, 2, OLED_6X8);
-    OLED_ShowString(16, 9 * 4, "Ki", OLED_6X8);
     OLED_ShowFloatNum(92, 9 * 4, vec_l.ki, 2, 2, OLED_6X8);
-    OLED_ShowString(16, 9 * 5, "Kd", OLED_6X8);
     OLED_ShowFloatNum(92, 9 * 5, vec_l.kd, 2, 2, OLED_6X8);
-    OLED_Update();
 }
 
-//MODE2初始化
-void Menu_MODE2_Init() {
-    OLED_Clear();
-    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-    OLED_ReverseArea(14, -1, 21, 9);
-    OLED_ShowString(16, 9 * 1, "SetAngle", OLED_6X8);
-    OLED_ShowString(16, 9 * 2, "BACK", OLED_6X8);
-    OLED_Update();
+//参数整定页的各项数值
+static const char* const TuneName[TUNE_LOOPS] = {"vec_l", "vec_r", "ang_l", "ang_r"};
+
+static void Menu_ShowTune(void) {
+    OLED_ShowString(98, 9 * 0, (char*) TuneName[tune_loop], OLED_6X8);
+    OLED_ShowFloatNum(86, 9 * 1, tune.kp, 3, 2, OLED_6X8);
+    OLED_ShowFloatNum(86, 9 * 2, tune.ki, 2, 3, OLED_6X8);
+    OLED_ShowFloatNum(86, 9 * 3, tune.kd, 3, 2, OLED_6X8);
+    OLED_ShowNum(98, 9 * 4, (uint32_t) tune.max_output, 5, OLED_6X8);
+    OLED_ShowNum(98, 9 * 5, (uint32_t) tune.max_integral, 5, OLED_6X8);
 }
 
-//MODE3初始化
-void Menu_MODE3_Init(){
-    OLED_Clear();
-    OLED_ShowString(16, 9*0, "OFF",OLED_6X8);
-    OLED_ReverseArea(16,-1,21,9);
-    OLED_ShowString(16,9*1,"SetSpeed",OLED_6X8);
-    OLED_ShowString(16,9*2,"BACK",OLED_6X8);
-    OLED_Update();
+//指令队列占用，欠载时显示U
+static void Menu_ShowQueue(void) {
+    const MotionQueue* queue = mg513_GetMotionQueue();
+    OLED_ShowNum(92, 9 * 4, motion_Count(queue), 2, OLED_6X8);
+    OLED_ShowChar(110, 9 * 4, queue->underrun ? 'U' : ' ', OLED_6X8);
 }
 
-//MODE4初始化
-void Menu_MODE4_Init() {
-    OLED_Clear();
-    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-    OLED_ReverseArea(14, -1, 21, 9);
-    OLED_ShowString(16, 9 * 1, "Control Motor", OLED_6X8);
-    OLED_ShowString(16, 9 * 2, "BACK", OLED_6X8);
-    OLED_Update();
+static uint32_t Menu_QueueStamp(void) {
+    const MotionQueue* queue = mg513_GetMotionQueue();
+    return (uint32_t) motion_Count(queue) << 1 | queue->underrun;
 }
 
-//MODE5初始化
-void Menu_MODE5_Init() {
-    OLED_Clear();
-    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
+//------页面描述------//
+static const ItemDesc home_items[] = {
+    {.label = "Speed Control",    .kind = ITEM_PAGE, .target = PAGE_MODE1},
+    {.label = "Position Control", .kind = ITEM_PAGE, .target = PAGE_MODE2},
+    {.label = "Speed Follow",     .kind = ITEM_PAGE, .target = PAGE_MODE3},
+    {.label = "Position Follow",  .kind = ITEM_PAGE, .target = PAGE_MODE4},
+    {.label = "Speed Curve",      .kind = ITEM_PAGE, .target = PAGE_MODE5},
+    {.label = "Position Curve",   .kind = ITEM_PAGE, .target = PAGE_MODE6},
+    {.label = "Diagnostics",      .kind = ITEM_PAGE, .target = PAGE_MODE7},
+};
+
+static const EditDesc mode1_speed_edit = {
+    .value = &mode1_speed, .action = Menu_SetSpeed,
+    .step = 10, .min = -500, .max = 500, .show = SHOW_SIGNED, .x = 92, .digits = 4,
+};
+
+static const ItemDesc mode1_items[] = {
+    {.label = "SetSpeed", .edit = &mode1_speed_edit, .kind = ITEM_EDIT},
+    {.label = "BACK", .kind = ITEM_BACK},
+    {.label = "Kp"},
+    {.label = "Ki"},
+    {.label = "Kd"},
+};
+
+static const EditDesc mode2_angle_edit = {
+    .value = &mode2_angle, .action = Menu_SetAngle,
+    .step = 90, .min = -9000, .max = 9000, .show = SHOW_SIGNED, .x = 92, .digits = 4,
+};
+
+static const ItemDesc mode2_items[] = {
+    {.label = "SetAngle", .edit = &mode2_angle_edit, .kind = ITEM_EDIT},
+    {.label = "BACK", .kind = ITEM_BACK},
+};
+
+static const EditDesc mode3_speed_edit = {
+    .value = &mode3_speed, .action = Menu_SetFollowSpeed,
+    .step = 1, .min = -500, .max = 500, .show = SHOW_MARK, .flags = EDIT_LIVE, .x = 92,
+};
+
+static const ItemDesc mode3_items[] = {
+    {.label = "SetSpeed", .edit = &mode3_speed_edit, .kind = ITEM_EDIT},
+    {.label = "BACK", .kind = ITEM_BACK},
+};
+
+static const char* const FollowSide[] = {"-L-", "-R-"};
+static const EditDesc mode4_side_edit = {
+    .value = &mode4_side, .choices = FollowSide, .action = Menu_SetFollowSide,
+    .step = 1, .min = 0, .max = 1, .show = SHOW_CHOICE, .flags = EDIT_WRAP, .x = 108,
+};
+
+static const ItemDesc mode4_items[] = {
+    {.label = "Control Motor", .edit = &mode4_side_edit, .kind = ITEM_EDIT},
+    {.label = "BACK", .kind = ITEM_BACK},
+};
+
+static const EditDesc mode5_speed_edit = {
+    .value = &mode5_speed, .action = Menu_PlanSpeed,
+    .step = 10, .min = -500, .max = 500, .show = SHOW_SIGNED, .x = 92, .digits = 3,
+};
+static const EditDesc mode5_accel_edit = {
+    .value = &mode5_accel, .action = Menu_PlanSpeed,
+    .step = 1, .min = 0, .max = 99, .show = SHOW_SIGNED, .x = 104, .digits = 1, .frac = 1,
+};
+
+static const ItemDesc mode5_items[] = {
+    {.label = "Speed", .edit = &mode5_speed_edit, .kind = ITEM_EDIT},
+    {.label = "Acceleration", .edit = &mode5_accel_edit, .kind = ITEM_EDIT},
+    {.label = "BACK", .kind = ITEM_BACK},
+};
+
+static const EditDesc mode6_angle_edit = {
+    .value = &mode6_angle, .action = Menu_PlanPosition,
+    .step = 10, .min = -990, .max = 990, .show = SHOW_SIGNED, .x = 92, .digits = 3,
+};
+//从下一条位置指令起生效
+static const EditDesc mode6_speed_edit = {
+    .value = &mode6_speed,
+    .step = 10, .min = 0, .max = 500, .show = SHOW_UNSIGNED, .x = 104, .digits = 3,
+};
+
+static const ItemDesc mode6_items[] = {
+    {.label = "Angle", .edit = &mode6_angle_edit, .kind = ITEM_EDIT},
+    {.label = "Speed", .edit = &mode6_speed_edit, .kind = ITEM_EDIT},
+    {.label = "BACK", .kind = ITEM_BACK},
+    {.label = "Queue"},
+};
+
+static const EditDesc diag_mode_edit = {
+    .value = &diag_mode,
+    .step = 1, .min = 0, .max = PROFILER_MAX_MODES - 1, .show = SHOW_CUSTOM, .flags = EDIT_WRAP,
+};
+
+static const ItemDesc mode7_items[] = {
+    {.label = "Mode", .edit = &diag_mode_edit, .kind = ITEM_EDIT},
+    {.label = "BACK", .kind = ITEM_BACK},
+    {.label = "Min"},
+    {.label = "Max"},
+    {.label = "Avg"},
+    {.label = "Ovr"},
+};
+
+//kp kd单位0.01，ki单位0.001，限幅单位1；转动时即生效
+static const EditDesc tune_loop_edit = {
+    .value = &tune_loop, .choices = TuneName, .action = Menu_TuneSelect,
+    .step = 1, .min = 0, .max = TUNE_LOOPS - 1, .show = SHOW_CHOICE, .flags = EDIT_WRAP | EDIT_LIVE, .x = 98,
+};
+static const EditDesc tune_kp_edit = {
+    .value = &tune_kp, .action = Menu_TuneApply,
+    .step = 10, .min = 0, .max = 30000, .show = SHOW_SIGNED, .flags = EDIT_LIVE, .x = 86, .digits = 3, .frac = 2,
+};
+static const EditDesc tune_ki_edit = {
+    .value = &tune_ki, .action = Menu_TuneApply,
+    .step = 1, .min = 0, .max = 30000, .show = SHOW_SIGNED, .flags = EDIT_LIVE, .x = 86, .digits = 2, .frac = 3,
+};
+static const EditDesc tune_kd_edit = {
+    .value = &tune_kd, .action = Menu_TuneApply,
+    .step = 10, .min = 0, .max = 30000, .show = SHOW_SIGNED, .flags = EDIT_LIVE, .x = 86, .digits = 3, .frac = 2,
+};
+static const EditDesc tune_max_output_edit = {
+    .value = &tune_max_output, .action = Menu_TuneApply,
+    .step = 100, .min = 0, .max = 30000, .show = SHOW_UNSIGNED, .flags = EDIT_LIVE, .x = 98, .digits = 5,
+};
+static const EditDesc tune_max_integral_edit = {
+    .value = &tune_max_integral, .action = Menu_TuneApply,
+    .step = 100, .min = 0, .max = 30000, .show = SHOW_UNSIGNED, .flags = EDIT_LIVE, .x = 98, .digits = 5,
+};
+
+static const ItemDesc tune_items[] = {
+    {.label = "Loop", .edit = &tune_loop_edit, .kind = ITEM_EDIT},
+    {.label = "Kp", .edit = &tune_kp_edit, .kind = ITEM_EDIT},
+    {.label = "Ki", .edit = &tune_ki_edit, .kind = ITEM_EDIT},
+    {.label = "Kd", .edit = &tune_kd_edit, .kind = ITEM_EDIT},
+    {.label = "MaxOut", .edit = &tune_max_output_edit, .kind = ITEM_EDIT},
+    {.label = "MaxI", .edit = &tune_max_integral_edit, .kind = ITEM_EDIT},
+    {.label = "BACK", .kind = ITEM_BACK},
+};
+
+#define PAGE_ITEMS(items)   items, sizeof(items) / sizeof(items[0])
+
+//以MenuPage为下标，新增页面只需添加一组菜单项和此处一项
+static const PageDesc page_table[PAGE_COUNT] = {
+    [PAGE_HOME]  = {PAGE_ITEMS(home_items),  0, 6, 0,                           Init},
+    [PAGE_MODE1] = {PAGE_ITEMS(mode1_items), 1, 2, PAGE_MOTOR | PAGE_LEFT_ONLY, Speed_Control,
+                    Menu_ShowGains},
+    [PAGE_MODE2] = {PAGE_ITEMS(mode2_items), 1, 2, PAGE_MOTOR | PAGE_LEFT_ONLY, Position_Control},
+    [PAGE_MODE3] = {PAGE_ITEMS(mode3_items), 1, 2, PAGE_MOTOR,                  Speed_Follow},
+    [PAGE_MODE4] = {PAGE_ITEMS(mode4_items), 1, 2, PAGE_MOTOR,                  Init},
+    [PAGE_MODE5] = {PAGE_ITEMS(mode5_items), 1, 3, PAGE_MOTOR | PAGE_LEFT_ONLY, Speed_CurveControl},
+    [PAGE_MODE6] = {PAGE_ITEMS(mode6_items), 1, 3, PAGE_MOTOR | PAGE_LEFT_ONLY, Position_CurveControl,
+                    Menu_ShowQueue, Menu_QueueStamp},
+    [PAGE_MODE7] = {PAGE_ITEMS(mode7_items), 1, 2, 0,                           Init,
+                    Menu_Diag_Show, Menu_Diag_Stamp},
+    [PAGE_TUNE]  = {PAGE_ITEMS(tune_items),  0, 6, PAGE_OVERLAY,                Init,
+                    Menu_ShowTune},
+};
+
+//------页面引擎------//
+//光标移动到指定行
+static void Menu_MoveCursor(int8_t y) {
+    OLED_ClearArea(0, (int16_t) (this_y * 9), 16, 9);
+    this_y = y;
+    OLED_ShowImage(0, (int16_t) (this_y * 9), 16, 9, This);
+}
+
+//ON/OFF状态（反色显示）
+static void Menu_ShowRunning(void) {
+    OLED_ClearArea(14, 0, 21, 8);
+    OLED_ShowString(16, 9 * 0, running ? "ON." : "OFF", OLED_6X8);
     OLED_ReverseArea(14, -1, 21, 9);
-    OLED_ShowString(16, 9 * 1, "Speed", OLED_6X8);
-    OLED_ShowString(16, 9 * 2, "Acceleration", OLED_6X8);
-    OLED_ShowString(16, 9 * 3, "BACK", OLED_6X8);
-    OLED_Update();
 }
 
-//MODE6初始化
-void Menu_MODE6_Init(){
+//光标所在行的菜单项
+static const ItemDesc* Menu_Item(void) {
+    return &page_table[page].items[this_y - page_table[page].first];
+}
+
+//实时数据：只在状态变化时重绘
+static void Menu_Refresh(void) {
+    const PageDesc* desc = &page_table[page];
+    uint32_t stamp;
+
+    if (desc->stamp == NULL)
+        return;
+    stamp = desc->stamp();
+    if (stamp != shown_stamp) {
+        shown_stamp = stamp;
+        desc->show();
+        dirty = 1;
+    }
+}
+
+//进入页面：显示各项文字
+//从PAGE_OVERLAY页面返回时电机模式不变
+static void Menu_Enter(uint8_t to) {
+    const PageDesc* desc = &page_table[to];
+
+    if ((desc->flags & PAGE_MOTOR) && !(page_table[page].flags & PAGE_OVERLAY))
+        mg513_SetMode(desc->mode);
+    page = to;
+    editing = 0;
     OLED_Clear();
-    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-    OLED_ReverseArea(14, -1, 21, 9);
-    OLED_ShowString(16, 9 * 1, "Angle", OLED_6X8);
-    OLED_ShowString(16, 9 * 2, "Speed", OLED_6X8);
-    OLED_ShowString(16, 9 * 3, "BACK", OLED_6X8);
-    OLED_Update();
+    if (desc->flags & PAGE_MOTOR)
+        Menu_ShowRunning();
+    for (uint8_t i = 0; i < desc->count; i++)
+        OLED_ShowString(16, (int16_t) (9 * (desc->first + i)), (char*) desc->items[i].label, OLED_6X8);
+    this_y = to == PAGE_HOME ? home_y : (int8_t) desc->first;
+    Menu_MoveCursor(this_y);
+    if (desc->show != NULL)
+        desc->show();
+    shown_stamp = desc->stamp != NULL ? desc->stamp() : 0;
 }
 
-//主页逻辑
-void Menu() {
-    while (1) {
-        if (encoder_num < 0) {
-            encoder_num = 6;
-            Menu_option();
-        } else if (encoder_num <= 6) {
-            Menu_option();
-            if (ReadKeyState() == GPIO_PIN_RESET) {
-                Menu_Start_OK();
-            }
-        } else {
-            encoder_num = 0;
-            Menu_option();
-        }
+//模式页BACK：关闭电机，回到主页
+static void Menu_Back(void) {
+    if (page_table[page].flags & PAGE_OVERLAY) {
+        Menu_Enter(overlay_return);
+        return;
+    }
+    if (running) {
+        running = 0;
+        mg513_Stop();
     }
+    if (page_table[page].flags & PAGE_MOTOR)
+        mg513_SetMode(Init);
+    Menu_Enter(PAGE_HOME);
 }
 
-//主页各选项逻辑
-void Menu_Start_OK() {
-    switch (this_y) {
-        //Speed_Control
-        case 0: {
-            encoder_num = 1;
-            Mode = Speed_Control;
-            mg513_InitPID();
-            mg513_SetPID(Mode);
-            Menu_MODE1_Init();
-            Menu_Mode1();
-        }
-            break;
-        //Position_Control
-        case 1:{
-            encoder_num = 1;
-            Mode = Position_Control;
-            mg513_InitPID();
-            mg513_SetPID(Mode);
-            Menu_MODE2_Init();
-            Menu_Mode2();
-        }
+//显示正在编辑的数值
+static void Menu_ShowValue(const EditDesc* edit) {
+    static const float Scale[] = {1.0f, 0.1f, 0.01f, 0.001f};
+    int16_t y = (int16_t) (this_y * 9);
+
+    switch (edit->show) {
+        case SHOW_SIGNED:
+            if (edit->frac)
+                OLED_ShowFloatNum(edit->x, y, *edit->value * Scale[edit->frac], edit->digits, edit->frac, OLED_6X8);
+            else
+                OLED_ShowSignedNum(edit->x, y, *edit->value, edit->digits, OLED_6X8);
             break;
-        //Speed_Follow
-        case 2:
-        {
-            encoder_num = 1;
-            Mode = Speed_Follow;
-            mg513_InitPID();
-            mg513_SetPID(Mode);
-            Menu_MODE3_Init();
-            Menu_Mode3();
-        }
+        case SHOW_UNSIGNED:
+            OLED_ShowNum(edit->x, y, (uint32_t) *edit->value, edit->digits, OLED_6X8);
             break;
-        //Position_Follow
-        case 3:
-        {
-            encoder_num = 1;
-            mg513_InitPID();
-            Menu_MODE4_Init();
-            Menu_Mode4();
-        }
-            break;
-        //Speed_CurveControl
-        case 4:
-        {
-            encoder_num = 1;
-            Mode = Speed_CurveControl;
-            mg513_InitPID();
-            mg513_SetPID(Mode);
-            Menu_MODE5_Init();
-            Menu_Mode5();
-        }
+        case SHOW_CHOICE:
+            OLED_ShowString(edit->x, y, (char*) edit->choices[*edit->value], OLED_6X8);
             break;
-            //Position_CurveControl
-        case 5:
-        {
-            encoder_num = 1;
-            Mode = Position_CurveControl;
-            mg513_InitPID();
-            mg513_SetPID(Mode);
-            Menu_MODE6_Init();
-            Menu_Mode6();
-        }
-        case 6:
+        case SHOW_MARK:
+            if (editing)
+                OLED_ShowImage(edit->x, y, 16, 9, Selected);
+            else
+                OLED_ClearArea(edit->x, y, 16, 9);
             break;
         default:
+            page_table[page].show();
             break;
     }
 }
 
-//模式1页面逻辑
-void Menu_Mode1() {
-    while (1) {
-        if (encoder_num < 1) {
-            encoder_num = 2;
-            Menu_option();
-        } else if (encoder_num <= 2) {
-            Menu_option();
-            if (ReadKeyState() == GPIO_PIN_RESET) {
-                encoder_num = 0;
-                Menu_Mode1_OK();
-            }
-            currentKey2State = ReadKey2State();
-            if (currentKey2State != prevKey2State) {
-                if (currentKey2State) {
-                    OLED_ShowString(16, 9 * 0, "ON.", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    OLED_Update();
-                    HAL_Delay(100);
-                    mg513_Start();
-                } else {
-                    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    OLED_Update();
-                    HAL_Delay(100);
-                    mg513_Stop();
-                }
-                prevKey2State = currentKey2State;
-            }
-        } else {
-            encoder_num = 1;
-            Menu_option();
-        }
+//旋钮修改正在编辑的数值：回绕或限幅
+static void Menu_Adjust(int16_t delta) {
+    const EditDesc* edit = Menu_Item()->edit;
+    int32_t value;
+
+    if (edit->flags & EDIT_WRAP) {
+        int32_t n = edit->max - edit->min + 1;
+        value = (*edit->value - edit->min + (int32_t) delta * edit->step % n + n) % n + edit->min;
+    } else {
+        value = *edit->value + (int32_t) delta * edit->step;
+        if (value < edit->min)
+            value = edit->min;
+        else if (value > edit->max)
+            value = edit->max;
     }
+    *edit->value = (int16_t) value;
+    if ((edit->flags & EDIT_LIVE) && edit->action != NULL)
+        edit->action();
+    Menu_ShowValue(edit);
 }
 
-//模式1选项逻辑
-void Menu_Mode1_OK() {
-    switch (this_y) {
-        case 1: {
-            while (1) {
-                static int16_t SetSpeed;
-                SetSpeed+=(encoder_num * 10);
-                encoder_num=0;
-                OLED_ShowSignedNum(92, this_y*9, SetSpeed, 4, OLED_6X8);
-                OLED_Update();
-                if (ReadKeyState() == GPIO_PIN_RESET) {
-                    encoder_num = 1;
-                    setPIDTarget(&vec_l,SetSpeed);                   //更新目标速度
-                    HAL_TIM_PWM_Stop(&htim1,TIM_CHANNEL_4);     //关闭右电机
-                    return;
-                }
-            }
-        }
-            break;
-        case 2: {
-            encoder_num = 0;
-            Mode = Init;
-            mg513_InitPID();
-            Menu_Init();
-            Menu();
-        }
-            break;
-        default:
-            break;
-    }
+//OK键确认正在编辑的数值
+static void Menu_Apply(void) {
+    const EditDesc* edit = Menu_Item()->edit;
+
+    if (!(edit->flags & EDIT_LIVE) && edit->action != NULL)
+        edit->action();
+    if (page_table[page].flags & PAGE_LEFT_ONLY)
+        HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_4);            //关闭右电机
+    Menu_ShowValue(edit);
 }
 
-//模式2页面逻辑
-void Menu_Mode2(){
-    while (1) {
-        if (encoder_num < 1) {
-            encoder_num = 2;
-            Menu_option();
-        } else if (encoder_num <= 2) {
-            Menu_option();
-            if (ReadKeyState() == GPIO_PIN_RESET) {
-                encoder_num = 0;
-                Menu_Mode2_OK();
-            }
-            currentKey2State = ReadKey2State();
-            if (currentKey2State != prevKey2State) {
-                if (currentKey2State) {
-                    OLED_ShowString(16, 9 * 0, "ON.", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Start();
-                } else {
-                    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Stop();
-                }
-                prevKey2State = currentKey2State;
-            }
-        } else {
-            encoder_num = 1;
-            Menu_option();
-        }
+//OK键
+static void Menu_OK(void) {
+    const ItemDesc* item = Menu_Item();
+
+    if (editing) {
+        editing = 0;
+        Menu_Apply();
+    } else if (item->kind == ITEM_PAGE) {
+        home_y = this_y;
+        Menu_Enter(item->target);
+    } else if (item->kind == ITEM_BACK) {
+        Menu_Back();
+    } else if (item->kind == ITEM_EDIT) {
+        editing = 1;
+        Menu_ShowValue(item->edit);
     }
 }
 
-//模式2选项逻辑
-void Menu_Mode2_OK(){
-    switch (this_y) {
-        case 1: {
-            static int16_t SetAngle;
-            while (1) {
-                SetAngle+=(encoder_num * 90);
-                encoder_num=0;
-                OLED_ShowSignedNum(92, this_y*9, SetAngle, 4, OLED_6X8);
-                OLED_Update();
-                if (ReadKeyState() == GPIO_PIN_RESET) {
-                    encoder_num = 1;
-                    setPIDTarget(&ang_l,SetAngle);              //更新目标角度
-                    HAL_TIM_PWM_Stop(&htim1,TIM_CHANNEL_4);     //关闭右电机
-                    return;
-                }
-            }
-        }
-            break;
-        case 2: {
-            encoder_num = 0;
-            Mode = Init;
-            mg513_InitPID();
-            Menu_Init();
-            Menu();
-        }
-            break;
-        default:
-            break;
-    }
+//旋钮移动光标，超出首尾行时回绕
+static void Menu_Move(int16_t delta) {
+    int8_t first = (int8_t) page_table[page].first;
+    int8_t rows = (int8_t) (page_table[page].last - first + 1);
+    int8_t y = (int8_t) ((this_y - first + delta % rows + rows) % rows + first);
+
+    Menu_MoveCursor(y);
 }
 
-//模式3页面逻辑
-void Menu_Mode3(){
-    while (1) {
-        if (encoder_num < 1) {
-            encoder_num = 2;
-            Menu_option();
-        } else if (encoder_num <= 2) {
-            Menu_option();
-            if (ReadKeyState() == GPIO_PIN_RESET) {
-                encoder_num = 0;
-                Menu_Mode3_OK();
-            }
-            currentKey2State = ReadKey2State();
-            if (currentKey2State != prevKey2State) {
-                if (currentKey2State) {
-                    OLED_ShowString(16, 9 * 0, "ON.", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Start();
-                } else {
-                    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Stop();
-                }
-                prevKey2State = currentKey2State;
-            }
-        } else {
-            encoder_num = 1;
-            Menu_option();
-        }
+//菜单初始化：初始化屏幕并显示主页
+void Menu_Init(void) {
+    OLED_Init();
+    key_Init();
+    knob_Init();
+    home_y = 0;
+    Menu_Enter(PAGE_HOME);
+    OLED_Update();
+    refresh_tick = HAL_GetTick();
+}
+
+//开关电机：模式页，或叠加在模式页上的PAGE_OVERLAY页面（参数整定时也能随时停下电机）
+static void Menu_OnOff(void) {
+    uint8_t motor_page = (page_table[page].flags & PAGE_OVERLAY) ? overlay_return : page;
+
+    if (!(page_table[motor_page].flags & PAGE_MOTOR))
+        return;
+    running = !running;
+    if (running)
+        mg513_Start();
+    else
+        mg513_Stop();
+    //叠加页面上不显示ON/OFF，返回模式页时重绘
+    if (motor_page == page) {
+        Menu_ShowRunning();
+        dirty = 1;
     }
 }
 
-//模式3选项逻辑
-void Menu_Mode3_OK(){
-    switch (this_y) {
-        case 1: {
-            static int16_t SetSpeed;
-            while (1) {
-                SetSpeed+=encoder_num;
-                encoder_num=0;
-                OLED_ShowImage(92,9*1,16,9,Selected);
-                OLED_Update();
-                setPIDTarget(&vec_l,SetSpeed);              //更新目标角度
-                if (ReadKeyState() == GPIO_PIN_RESET) {
-                    encoder_num = 1;
-                    OLED_ClearArea(92,9*1,16,9);
-                    return;
-                }
-            }
-        }
+//处理一个输入事件，显存有修改时刷新一次屏幕
+void Menu_Handle(const MenuEvent* event) {
+    switch (event->type) {
+        case MENU_EVENT_KNOB:
+            if (event->delta == 0)
+                break;
+            if (editing)
+                Menu_Adjust(event->delta);
+            else
+                Menu_Move(event->delta);
+            dirty = 1;
             break;
-        case 2: {
-            encoder_num = 0;
-            Mode = Init;
-            mg513_InitPID();
-            Menu_Init();
-            Menu();
-        }
+        case MENU_EVENT_OK:
+            Menu_OK();
+            dirty = 1;
+            break;
+        case MENU_EVENT_TUNE:
+            //模式页长按OK：打开参数整定页，电机保持运行
+            if (!(page_table[page].flags & PAGE_MOTOR))
+                break;
+            overlay_return = page;
+            Menu_TuneLoad();
+            Menu_Enter(PAGE_TUNE);
+            dirty = 1;
+            break;
+        case MENU_EVENT_ON_OFF:
+            Menu_OnOff();
+            break;
+        case MENU_EVENT_REFRESH:
+            Menu_Refresh();
             break;
         default:
             break;
     }
-}
 
-//模式4页面逻辑
-void Menu_Mode4() {
-    while (1) {
-        mg513_SetPID(Mode);
-        if (encoder_num < 1) {
-            encoder_num = 2;
-            Menu_option();
-        } else if (encoder_num <= 2) {
-            Menu_option();
-            if (ReadKeyState() == GPIO_PIN_RESET) {
-                encoder_num = 0;
-                Menu_Mode4_OK();
-            }
-            currentKey2State = ReadKey2State();
-            if (currentKey2State != prevKey2State) {
-                if (currentKey2State) {
-                    OLED_ShowString(16, 9 * 0, "ON.", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Start();
-                } else {
-                    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Stop();
-                }
-                prevKey2State = currentKey2State;
-            }
-        } else {
-            encoder_num = 1;
-            Menu_option();
-        }
+    if (dirty) {
+        dirty = 0;
+        OLED_Update();
+        flush_count++;
     }
 }
 
-//模式4选项逻辑
-void Menu_Mode4_OK(){
-    switch (this_y) {
-        case 1:{
-            while (1){
-                static uint8_t num;
-                num += encoder_num;
-                encoder_num = 0;
-                if(num%2) {
-                    OLED_ShowString(108,this_y*9,"-R-",OLED_6X8);
-                    Mode = Position_Follow_R;
-                }else{
-                    OLED_ShowString(108,this_y*9,"-L-",OLED_6X8);
-                    Mode = Position_Follow_L;
-                }
-                OLED_Update();
-                if(ReadKeyState()==GPIO_PIN_RESET){
-                    encoder_num = 1;
-                    mg513_InitPID();
-                    mg513_SetPID(Mode);
-                    return;
-                }
-            }
-        }
-        case 2:{
-            encoder_num = 0;
-            Mode = Init;
-            Menu_Init();
-            Menu();
-        }
+//菜单主循环：主循环中反复调用，每次处理已发生的输入事件，没有事件时休眠
+//不递归、不阻塞，栈深度固定，按住按键时屏幕与设定值照常更新
+void Menu(void) {
+    MenuEvent event;
+    KeyEvent key;
+    KnobDelta knob;
+    uint8_t handled = 0;
+
+    //旋钮：取出中断中累计的格数，编辑数值时按转速加速，移动光标时按实际格数
+    knob = knob_Read();
+    event.delta = editing ? knob.steps : knob.detents;
+    if (event.delta != 0) {
+        event.type = MENU_EVENT_KNOB;
+        Menu_Handle(&event);
+        handled = 1;
     }
-}
 
-//模式5页面逻辑
-void Menu_Mode5(){
-    while (1) {
-        if (encoder_num < 1) {
-            encoder_num = 2;
-            Menu_option();
-        } else if (encoder_num <= 3) {
-            Menu_option();
-            if (ReadKeyState() == GPIO_PIN_RESET) {
-                encoder_num = 0;
-                Menu_Mode5_OK();
-            }
-            currentKey2State = ReadKey2State();
-            if (currentKey2State != prevKey2State) {
-                if (currentKey2State) {
-                    OLED_ShowString(16, 9 * 0, "ON.", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Start();
-                } else {
-                    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Stop();
-                    vec_l.curve.aTimes = 0;
-                }
-                prevKey2State = currentKey2State;
-            }
+    //按键：SysTick中断中消抖后放入队列
+    //ON/OFF键按下即生效；OK键松开时生效，长按（打开参数整定页）后松开不再算一次OK
+    event.delta = 0;
+    while (key_Read(&key)) {
+        if (key.key == KEY_ON && key.type == KEY_EVENT_PRESS) {
+            event.type = MENU_EVENT_ON_OFF;
+        } else if (key.key == KEY_OK && key.type == KEY_EVENT_PRESS) {
+            ok_long = 0;
+            continue;
+        } else if (key.key == KEY_OK && key.type == KEY_EVENT_LONG) {
+            ok_long = 1;
+            event.type = MENU_EVENT_TUNE;
+        } else if (key.key == KEY_OK && key.type == KEY_EVENT_RELEASE && !ok_long) {
+            event.type = MENU_EVENT_OK;
         } else {
-            encoder_num = 1;
-            Menu_option();
+            continue;
         }
+        Menu_Handle(&event);
+        handled = 1;
     }
-}
 
-void Menu_Mode5_OK() {
-    static int16_t SetSpeed;
-    static float SetAcceleration;
-    extern Encoder ecd_l;
-    switch (this_y) {
-        case 1: {
-            while (1) {
-                SetSpeed += (encoder_num * 10);
-                encoder_num = 0;
-                OLED_ShowSignedNum(92, this_y * 9, SetSpeed, 3, OLED_6X8);
-                OLED_Update();
-                if (ReadKeyState() == GPIO_PIN_RESET) {
-                    encoder_num = 1;
-                    setCurve(&vec_l.curve, ecd_l.velocity.angular, SetSpeed,SetAcceleration,380);
-                    HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_4);     //关闭右电机
-                    return;
-                }
-            }
-        }
-            break;
-        case 2:
-        {
-            while (1){
-                SetAcceleration+=(encoder_num / 10.0);
-                encoder_num = 0;
-                 OLED_ShowFloatNum(104,this_y * 9,SetAcceleration,1,1,OLED_6X8);
-                OLED_Update();
-                if(ReadKeyState() == GPIO_PIN_RESET){
-                    encoder_num = 2;
-                    setCurve(&vec_l.curve, ecd_l.velocity.angular, SetSpeed,SetAcceleration,380);
-                    HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_4);     //关闭右电机
-                    return;
-                }
-            }
-        }
-            break;
-        case 3: {
-            encoder_num = 0;
-            Mode = Init;
-            mg513_InitPID();
-            Menu_Init();
-            Menu();
-        }
-            break;
-        default:
-            break;
+    if (HAL_GetTick() - refresh_tick >= MENU_REFRESH_MS) {
+        refresh_tick = HAL_GetTick();
+        event.type = MENU_EVENT_REFRESH;
+        Menu_Handle(&event);
+        handled = 1;
     }
+
+    //没有事件时休眠，SysTick（1ms）、编码器或控制中断唤醒后再检查输入
+    if (!handled)
+        __WFI();
 }
 
-//
-void Menu_Mode6(){
-    while (1) {
-        if (encoder_num < 1) {
-            encoder_num = 2;
-            Menu_option();
-        } else if (encoder_num <= 3) {
-            Menu_option();
-            if (ReadKeyState() == GPIO_PIN_RESET) {
-                encoder_num = 0;
-                Menu_Mode6_OK();
-            }
-            currentKey2State = ReadKey2State();
-            if (currentKey2State != prevKey2State) {
-                if (currentKey2State) {
-                    OLED_ShowString(16, 9 * 0, "ON.", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Start();
-                } else {
-                    OLED_ShowString(16, 9 * 0, "OFF", OLED_6X8);
-                    OLED_ReverseArea(14, -1, 21, 9);
-                    mg513_Stop();
-                    ang_l.curve.aTimes = 0;
-                }
-                prevKey2State = currentKey2State;
-            }
-        } else {
-            encoder_num = 1;
-            Menu_option();
-        }
-    }
+//读取刷新屏幕次数
+uint32_t Menu_GetFlushCount(void) {
+    return flush_count;
 }
 
-void Menu_Mode6_OK(){
-    static int16_t SetSpeed;
-    static float SetAngle;
-    extern Encoder ecd_l;
-    switch (this_y) {
-        case 1: {
-            while (1) {
-                SetAngle += (encoder_num * 10);
-                encoder_num = 0;
-                OLED_ShowSignedNum(92, this_y * 9, SetAngle, 3, OLED_6X8);
-                OLED_Update();
-                if (ReadKeyState() == GPIO_PIN_RESET) {
-                    encoder_num = 1;
-                    setCurve(&vec_l.curve, ecd_l.velocity.angular, SetAngle,0,SetSpeed);
-                    HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_4);     //关闭右电机
-                    return;
-                }
-            }
-        }
-            break;
-        case 2:
-        {
-            while (1){
-                SetSpeed+=(encoder_num * 10.0);
-                encoder_num = 0;
-                OLED_ShowNum(104,this_y * 9,SetSpeed,3,OLED_6X8);
-                OLED_Update();
-                if(ReadKeyState() == GPIO_PIN_RESET){
-                    encoder_num = 2;
-                    setCurve(&ang_l.curve, ecd_l.position.angle, SetSpeed,0,SetSpeed);
-                    HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_4);     //关闭右电机
-                    return;
-                }
-            }
-        }
-            break;
-        case 3: {
-            encoder_num = 0;
-            Mode = Init;
-            mg513_InitPID();
-            Menu_Init();
-            Menu();
-        }
-            break;
-        default:
-            break;
+//------诊断页面：控制中断耗时统计------//
+static const char* const ModeName[PROFILER_MAX_MODES] = {
+    "Idle    ", "Speed   ", "Position", "SpdFollw",
+    "PosFolwL", "PosFolwR", "SpdCurve", "PosCurve"
+};
+
+//显示所选模式的统计
+static void Menu_Diag_Show(void) {
+    const ProfilerStats* stats = profiler_Get(diag_mode);
+    uint32_t hist_max = 1;
+    uint8_t i;
+
+    OLED_ShowString(16, 9 * 0, (char*) ModeName[diag_mode], OLED_6X8);
+    OLED_ShowNum(40, 9 * 3, profiler_CyclesToUs(stats->count ? stats->min : 0), 5, OLED_6X8);
+    OLED_ShowNum(40, 9 * 4, profiler_CyclesToUs(stats->max), 5, OLED_6X8);
+    OLED_ShowNum(40, 9 * 5, profiler_CyclesToUs(profiler_Mean(stats)), 5, OLED_6X8);
+    OLED_ShowNum(40, 9 * 6, stats->overrun, 5, OLED_6X8);
+    OLED_ShowString(72, 9 * 3, "us", OLED_6X8);
+    OLED_ShowString(72, 9 * 4, "us", OLED_6X8);
+    OLED_ShowString(72, 9 * 5, "us", OLED_6X8);
+
+    //起始抖动直方图
+    for (i = 0; i < PROFILER_HIST_BINS; i++) {
+        if (stats->hist[i] > hist_max)
+            hist_max = stats->hist[i];
+    }
+    OLED_ClearArea(96, 27, 32, 37);
+    for (i = 0; i < PROFILER_HIST_BINS; i++) {
+        uint8_t height = (uint8_t) ((uint64_t) stats->hist[i] * 36 / hist_max);
+        if (height)
+            OLED_DrawRectangle((int16_t) (96 + i * 4), (int16_t) (63 - height), 3, height, OLED_FILLED);
     }
-}
\ No newline at end of file
+}
+
+//统计次数不变则统计结果不变
+static uint32_t Menu_Diag_Stamp(void) {
+    return profiler_Get(diag_mode)->count;
+}
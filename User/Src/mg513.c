@@ -3,11 +3,45 @@
 #include "tim.h"
 #include "encoder.h"
 #include "filter.h"
+#include "telemetry.h"
+#include "profiler.h"
+#include "planner.h"
+#include "motion.h"
+#include "bench.h"
 
-MotorMode Mode;             //电机模式
+MotorMode Mode;             //电机模式（当前生效）
+static volatile MotorMode pending_mode;     //待切换模式，在控制周期边界生效
+static volatile uint8_t mode_request;       //1：控制周期边界重新进入pending_mode（与当前模式相同时也重新进入）
 Encoder ecd_l,ecd_r;        //编码器
 PID vec_l,vec_r;            //速度环   pid
 PID ang_l,ang_r;            //位置环   p
+LowPass lpf_l,lpf_r;        //速度反馈低通，每个速度环一个
+static ControlSchedule schedule = {1, PID_TUNE_PERIOD, OUTER_DIV_DEFAULT, 0};   //多速率调度
+static uint16_t report_count;                   //统计上报计数
+MotionPlan plan_l;                              //左电机运动规划
+MotionQueue queue_l;                            //左电机位置指令队列
+
+//速度规划请求：主循环写入，控制中断在周期边界取走
+typedef struct {
+    uint8_t pending;
+    float target, amax, jmax;
+}PlanRequest;
+static volatile PlanRequest plan_request;
+static volatile uint8_t bench_request;          //上位机请求运行基准测试，主循环取走
+
+static void mg513_ResetLoops(void);
+
+//在线整定请求：每个控制环两份缓冲，主循环写入未发布的一份后发布，控制中断在周期边界取走
+//控制中断只读最近发布的一份，主循环只写另一份，参数不会读到一半被改写
+static PID* const tune_pid[TUNE_LOOPS] = {&vec_l, &vec_r, &ang_l, &ang_r};
+static PIDTune tune_buf[TUNE_LOOPS][2];
+static uint8_t tune_slot[TUNE_LOOPS];           //最近发布的缓冲
+static volatile uint8_t tune_pending;           //待生效的控制环，按位
+
+//整定结果：kp ki kd按PID_TUNE_PERIOD换算后保存，再次进入同一模式时替代模式表中的参数；限幅对所有模式有效
+static PIDTune tune_saved[TUNE_LOOPS];
+static MotorMode tune_mode[TUNE_LOOPS];
+static uint8_t tune_valid;                      //已整定的控制环，按位
 
 //编码器初始化
 void mg513_EncoderInit() {
@@ -20,44 +54,36 @@ void mg513_EncoderInit() {
     initEncoder(&ecd_r, right_param);
 }
 
+//编码器A相边沿中断
+//uint16_t GPIO_Pin             PA0：左编码器（TIM2_CH1）    PA6：右编码器（TIM3_CH1）
+void mg513_EncoderEdge(uint16_t GPIO_Pin) {
+    if (GPIO_Pin == GPIO_PIN_0)
+        encoderEdge(&ecd_l);
+    else if (GPIO_Pin == GPIO_PIN_6)
+        encoderEdge(&ecd_r);
+}
+
 //pid参数初始化
 void mg513_InitPID(){
     initPID(&vec_l, 2000, 4000);
     initPID(&vec_r, 2000, 4000);
     initPID(&ang_l, 2000, 4000);
     initPID(&ang_r, 2000, 4000);
-}
-
-//设置pid参数
-void mg513_SetPID(MotorMode mode) {
-    if (mode == Speed_Control) {
-        //速度控制
-        setPIDParam(&vec_l, 5, 0.8, 6);         //速度环    4.95, 0.8, 5
-    } else if (mode == Position_Control) {
-        //位置控制
-        setPIDParam(&vec_l, 4.95, 0.8, 5);         //速度环
-        setPIDParam(&ang_l, 0.5, 0, 0.0);          //位置环
-    } else if (mode == Speed_Follow) {
-        //速度跟随
-        setPIDParam(&vec_l, 10, 0.5, 0);
-    } else if (mode == Position_Follow_L) {
-        //位置跟随  左
-        setPIDParam(&ang_r, 80, 0, 50);
-    } else if (mode == Position_Follow_R) {
-        //位置跟随  右
-        setPIDParam(&ang_l, 60, 0, 0);
-    } else if (mode == Speed_CurveControl){
-        //速度曲线控速
-        setPIDParam(&vec_l,10,1.5,0);
-    } else if (mode == Position_CurveControl){
-        setPIDParam(&ang_l,10,0.2,0.1);
+    for (uint8_t i = 0; i < TUNE_LOOPS; i++) {
+        if (tune_valid & (1 << i))
+            setPIDLimit(tune_pid[i], tune_saved[i].max_output, tune_saved[i].max_integral);
     }
+    //速度反馈低通按外环周期设计
+    initLowPass(&lpf_l, VELOCITY_CUTOFF, schedule.outer_period);
+    initLowPass(&lpf_r, VELOCITY_CUTOFF, schedule.outer_period);
 }
 
 //电机初始化
+//停止前的积分和上次输出不带入本次运行
 void mg513_Start() {
     restEncoder(&ecd_l);
     restEncoder(&ecd_r);
+    mg513_ResetLoops();
     //PWM（PSC 72-1    ARR 2000）
     HAL_TIM_Base_Start_IT(&htim1);
     HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_3);        //PWM_左
@@ -65,7 +91,12 @@ void mg513_Start() {
     //Encoder Mode（TI1 and TI2      ARR 65535）
     HAL_TIM_Encoder_Start(&htim2, TIM_CHANNEL_1|TIM_CHANNEL_2); //encoder_左
     HAL_TIM_Encoder_Start(&htim3, TIM_CHANNEL_1|TIM_CHANNEL_2);//encoder_右
-    //TIM4 global interrupt （PSC 72-1     ARR 10000-1）
+    __HAL_TIM_ENABLE_IT(&htim2, TIM_IT_UPDATE);                 //溢出计数
+    __HAL_TIM_ENABLE_IT(&htim3, TIM_IT_UPDATE);
+    //编码器已清零，规划从静止零点开始
+    planner_Reset(&plan_l, 0, 0);
+    //TIM4 global interrupt （PSC 72-1     ARR 1000-1   内环1kHz）
+    profiler_Resync();
     HAL_TIM_Base_Start_IT(&htim4);
 }
 
@@ -79,7 +110,12 @@ void mg513_Stop()
     HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_4);
     HAL_TIM_Encoder_Stop(&htim2, TIM_CHANNEL_1|TIM_CHANNEL_2);  //编码器模式
     HAL_TIM_Encoder_Stop(&htim3,TIM_CHANNEL_1|TIM_CHANNEL_2);
+    __HAL_TIM_DISABLE_IT(&htim2, TIM_IT_UPDATE);
+    __HAL_TIM_DISABLE_IT(&htim3, TIM_IT_UPDATE);
     HAL_TIM_Base_Stop_IT(&htim4);                          //定时器中断
+    //控制中断已停止，未生效的模式切换立即完成
+    if (mode_request)
+        mg513_ApplyMode(pending_mode);
 }
 
 //取绝对值
@@ -142,76 +178,414 @@ void mg513_PWM(Motor l_or_r, int16_t pwm_val) {
     }
 }
 
+//------各模式控制步------//
+//空闲
+static void mode_Idle(void) {
+}
+
+//速度环控制--增量式pid     (左电机)
+static void mode_SpeedStep(void) {
+    updateEncoderLoop(&ecd_l, schedule.outer_period);
+    updatePID_Speed(&vec_l, ecd_l.velocity.angular);          //M/T测速无需再滤波
+    mg513_PWM(LEFT, vec_l.output);
+    float ch[] = {ecd_l.velocity.angular, vec_l.target};
+    telemetry_Send(Mode, ch, 2);
+}
+
+//位置环控制--串级pid(外级位置环，内级速度环）     (左电机)
+//内环：速度环，每个节拍执行
+static void mode_PositionInner(void) {
+    updateEncoderLoop(&ecd_l, schedule.inner_period);
+    updatePID_Speed(&vec_l, ecd_l.velocity.angular);          //M/T测速，1ms周期下不再有计数量化
+    mg513_PWM(LEFT, vec_l.output);
+}
+//外环：位置环，输出作为速度环目标
+static void mode_PositionOuter(void) {
+    updatePID_Position(&ang_l, ecd_l.position.angle);
+    ang_l.output = Limit(ang_l.output,200);
+    setPIDTarget(&vec_l, ang_l.output);
+    float ch[] = {ecd_l.position.angle, ang_l.target, ecd_l.velocity.angular};
+    telemetry_Send(Mode, ch, 3);
+}
+
+//速度跟随
+static void mode_SpeedFollowStep(void) {
+    updateEncoderLoop(&ecd_l, schedule.outer_period);
+    float filtered_velocity = updateLowPass(&lpf_l, ecd_l.velocity.angular);      //低通滤波
+    updatePID_Speed(&vec_l, filtered_velocity);
+    mg513_PWM(LEFT, vec_l.output);
+    float ch[] = {ecd_l.velocity.angular, vec_l.target};
+    telemetry_Send(Mode, ch, 2);
+}
+
+//位置跟随控制        （左电机为主电机）
+static void mode_FollowLStep(void) {
+    HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_3);
+    updateEncoderLoop(&ecd_l, schedule.outer_period);
+    float position_l = ecd_l.position.angle;
+    setPIDTarget(&ang_r, position_l);
+    updateEncoderLoop(&ecd_r, schedule.outer_period);
+    updatePID_Position(&ang_r, ecd_r.position.angle);
+    mg513_PWM(RIGHT, ang_r.output);
+    float ch[] = {ecd_r.position.angle, ecd_l.position.angle};
+    telemetry_Send(Mode, ch, 2);
+}
+
+//位置跟随控制        （右电机为主电机）
+static void mode_FollowRStep(void) {
+    HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_4);
+    updateEncoderLoop(&ecd_r, schedule.outer_period);
+    float position_r = ecd_r.position.angle;
+    setPIDTarget(&ang_l, position_r);
+    updateEncoderLoop(&ecd_l, schedule.outer_period);
+    updatePID_Position(&ang_l, ecd_l.position.angle);
+    mg513_PWM(LEFT, ang_l.output);
+    float ch[] = {ecd_r.position.angle, ecd_l.position.angle};
+    telemetry_Send(Mode, ch, 2);
+}
+
+//进入曲线模式：从当前状态重新开始规划
+static void mode_PlanInit(void) {
+    plan_request.pending = 0;
+    motion_Clear(&queue_l);
+    planner_Reset(&plan_l, ecd_l.position.angle, 0);
+}
+
+//速度曲线规划
+static void mode_SpeedCurveStep(void) {
+    updateEncoderLoop(&ecd_l, schedule.outer_period);
+    //取走速度请求，从当前规划状态生成新轨迹
+    if (plan_request.pending) {
+        planner_Velocity(&plan_l, plan_request.target, plan_request.amax, plan_request.jmax);
+        plan_request.pending = 0;
+    }
+    planner_Step(&plan_l, schedule.outer_period * 0.001f);
+    setPIDTarget(&vec_l, plan_l.v);
+    float filtered_velocity = updateLowPass(&lpf_l, ecd_l.velocity.angular);      //低通滤波
+    updatePID_Speed(&vec_l, filtered_velocity);
+    mg513_PWM(LEFT, vec_l.output);
+    float ch[] = {vec_l.target, ecd_l.velocity.angular};
+    telemetry_Send(Mode, ch, 2);
+}
+
+//位置曲线控制
+static void mode_PositionCurveStep(void) {
+    updateEncoderLoop(&ecd_l, schedule.outer_period);
+    motion_Run(&queue_l, &plan_l, schedule.outer_period * 0.001f);
+    setPIDTarget(&ang_l, plan_l.p);
+    updatePID_Position(&ang_l,ecd_l.position.angle);
+    mg513_PWM(LEFT,ang_l.output);
+    float ch[] = {ang_l.target, ecd_l.position.angle, ecd_l.velocity.angular};
+    telemetry_Send(Mode, ch, 3);
+}
+
+//退出模式时停掉该模式驱动的电机
+static void mode_StopLeft(void) {
+    mg513_PWM(LEFT, 0);
+}
+static void mode_StopRight(void) {
+    mg513_PWM(RIGHT, 0);
+}
+
+//------模式注册表------//
+//以MotorMode为下标，新增模式只需在此添加一项
+//单环模式只挂外环，串级模式把速度环挂在内环
+//参数组最后一项fixed置1即改用定点pid（Cortex-M3无FPU）：速度环均使用定点
+//位置环保持浮点：误差按浮点求出后再转换，不受角度范围限制，需要时可同样置1
+static const ModeDesc mode_table[] = {
+    [Init]                  = {NULL, mode_Idle,          mode_Idle,              NULL,
+                               {{NULL}}},
+    [Speed_Control]         = {NULL, mode_Idle,          mode_SpeedStep,         mode_StopLeft,
+                               {{&vec_l, 5, 0.8, 6, OUTER_LOOP, 1}}},           //速度环    4.95, 0.8, 5
+    [Position_Control]      = {NULL, mode_PositionInner, mode_PositionOuter,     mode_StopLeft,
+                               {{&vec_l, 4.95, 0.8, 5, INNER_LOOP, 1},          //速度环
+                                {&ang_l, 0.5, 0, 0.0}}},                        //位置环
+    [Speed_Follow]          = {NULL, mode_Idle,          mode_SpeedFollowStep,   mode_StopLeft,
+                               {{&vec_l, 10, 0.5, 0, OUTER_LOOP, 1}}},
+    [Position_Follow_L]     = {NULL, mode_Idle,          mode_FollowLStep,       mode_StopRight,
+                               {{&ang_r, 80, 0, 50}}},
+    [Position_Follow_R]     = {NULL, mode_Idle,          mode_FollowRStep,       mode_StopLeft,
+                               {{&ang_l, 60, 0, 0}}},
+    [Speed_CurveControl]    = {mode_PlanInit, mode_Idle,          mode_SpeedCurveStep,    mode_StopLeft,
+                               {{&vec_l, 10, 1.5, 0, OUTER_LOOP, 1}}},
+    [Position_CurveControl] = {mode_PlanInit, mode_Idle,          mode_PositionCurveStep, mode_StopLeft,
+                               {{&ang_l, 10, 0.2, 0.1}}},
+};
+
+//由TIM4配置推算内外环周期
+static void updateSchedule(void) {
+    //APB1分频不为1时定时器时钟为PCLK1的2倍
+    uint32_t tim_clk = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+        tim_clk *= 2;
+
+    schedule.inner_period = (float) (htim4.Init.Prescaler + 1) * (float) (htim4.Init.Period + 1)
+                            * 1000.0f / (float) tim_clk;
+    schedule.outer_period = schedule.inner_period * schedule.outer_div;
+    schedule.count = 0;
+
+    //控制周期对应的CPU周期数，用于耗时统计
+    profiler_SetPeriod((uint32_t) ((uint64_t) (htim4.Init.Prescaler + 1) * (htim4.Init.Period + 1)
+                                   * SystemCoreClock / tim_clk));
+}
+
+//pid在模式中所在控制环的周期与PID_TUNE_PERIOD之比，模式不使用该pid时按外环
+static float tuneRatio(MotorMode mode, const PID* pid) {
+    const ModeGain* gain = mode_table[mode].gains;
+    float period = schedule.outer_period;
+    for (uint8_t i = 0; i < MODE_MAX_GAINS && gain[i].pid != NULL; i++) {
+        if (gain[i].pid == pid && gain[i].loop == INNER_LOOP)
+            period = schedule.inner_period;
+    }
+    return period / PID_TUNE_PERIOD;
+}
+
+//设置pid参数
+//参数按PID_TUNE_PERIOD整定，按所在控制环的实际周期换算ki、kd
+void mg513_SetPID(MotorMode mode) {
+    const ModeGain* gain = mode_table[mode].gains;
+    for (uint8_t i = 0; i < MODE_MAX_GAINS && gain[i].pid != NULL; i++) {
+        float period = gain[i].loop == INNER_LOOP ? schedule.inner_period : schedule.outer_period;
+        float ratio = period / PID_TUNE_PERIOD;
+        setPIDParam(gain[i].pid, gain[i].kp, gain[i].ki * ratio, gain[i].kd / ratio);
+        setPIDFixed(gain[i].pid, gain[i].fixed);
+    }
+
+    //在该模式下在线整定过的控制环改用整定结果
+    for (uint8_t i = 0; i < TUNE_LOOPS; i++) {
+        if ((tune_valid & (1 << i)) && tune_mode[i] == mode) {
+            float ratio = tuneRatio(mode, tune_pid[i]);
+            setPIDParam(tune_pid[i], tune_saved[i].kp, tune_saved[i].ki * ratio, tune_saved[i].kd / ratio);
+        }
+    }
+}
+
+//清空当前模式各控制环的运行状态和速度反馈低通，参数和目标值不变
+static void mg513_ResetLoops(void) {
+    const ModeGain* gain = mode_table[Mode].gains;
+    for (uint8_t i = 0; i < MODE_MAX_GAINS && gain[i].pid != NULL; i++) {
+        resetPID(gain[i].pid);
+    }
+    initLowPass(&lpf_l, VELOCITY_CUTOFF, schedule.outer_period);
+    initLowPass(&lpf_r, VELOCITY_CUTOFF, schedule.outer_period);
+}
+
+//立即切换模式：旧模式收尾，复位控制环并装载新模式参数
+void mg513_ApplyMode(MotorMode mode) {
+    if (mode_table[Mode].teardown != NULL)
+        mode_table[Mode].teardown();
+
+    Mode = mode;
+    pending_mode = mode;
+    mode_request = 0;
+    updateSchedule();
+    mg513_InitPID();
+    mg513_SetPID(mode);
+
+    if (mode_table[mode].init != NULL)
+        mode_table[mode].init();
+}
+
+//请求切换模式
+//控制中断未运行时立即生效，否则在下一个控制周期开始时生效
+//与当前模式相同时同样重新进入：复位控制环、重新装载参数
+void mg513_SetMode(MotorMode mode) {
+    if (htim4.Instance->CR1 & TIM_CR1_CEN) {
+        pending_mode = mode;
+        mode_request = 1;
+    } else {
+        mg513_ApplyMode(mode);
+    }
+}
+
+//设置外环分频
+//uint8_t div                   外环周期 = 内环周期 * div
+void mg513_SetOuterDivider(uint8_t div) {
+    schedule.outer_div = div ? div : 1;
+}
+
+//整定参数生效：先改限幅，再无扰切换kp ki kd，并保存供再次进入该模式时使用
+static void tuneApply(uint8_t loop, const PIDTune* tune) {
+    PID* pid = tune_pid[loop];
+    float ratio = tuneRatio(Mode, pid);
+
+    setPIDLimit(pid, tune->max_output, tune->max_integral);
+    setPIDParamBumpless(pid, tune->kp, tune->ki, tune->kd);
+
+    tune_saved[loop] = *tune;
+    tune_saved[loop].ki = tune->ki / ratio;
+    tune_saved[loop].kd = tune->kd * ratio;
+    tune_mode[loop] = Mode;
+    tune_valid |= 1 << loop;
+}
+
+//控制中断内调用：取走已发布的整定参数
+static void tuneTake(void) {
+    uint8_t pending = tune_pending;
+
+    tune_pending = 0;
+    for (uint8_t i = 0; i < TUNE_LOOPS; i++) {
+        if (pending & (1 << i))
+            tuneApply(i, &tune_buf[i][tune_slot[i]]);
+    }
+}
+
+//读取控制环当前参数
+void mg513_GetTune(TuneLoop loop, PIDTune* tune) {
+    const PID* pid = tune_pid[loop];
+
+    __disable_irq();
+    tune->kp = pid->kp;
+    tune->ki = pid->ki;
+    tune->kd = pid->kd;
+    tune->max_output = pid->MAX_OUTPUT;
+    tune->max_integral = pid->MAX_ERROR_INTEGRAL;
+    __enable_irq();
+}
+
+//提交新参数
+//控制中断未运行时立即生效，否则在下一个控制周期开始时生效
+void mg513_Tune(TuneLoop loop, const PIDTune* tune) {
+    uint8_t slot;
+
+    if (!(htim4.Instance->CR1 & TIM_CR1_CEN)) {
+        tuneApply(loop, tune);
+        return;
+    }
+
+    slot = tune_slot[loop] ^ 1;
+    tune_buf[loop][slot] = *tune;
+    __disable_irq();
+    tune_slot[loop] = slot;
+    tune_pending |= 1 << loop;
+    __enable_irq();
+}
+
+//读取当前调度周期
+const ControlSchedule* mg513_GetSchedule(void) {
+    return &schedule;
+}
+
+//请求速度曲线
+//float target                  目标速度 rpm，限幅PLAN_SPEED_VMAX
+//float amax jmax               加速度 rpm/s、加加速度 rpm/s²，<=0 时使用默认值
+void mg513_PlanSpeed(float target, float amax, float jmax) {
+    if (amax <= 0)
+        amax = PLAN_SPEED_AMAX;
+    if (jmax <= 0)
+        jmax = amax * PLAN_JERK_RATIO;
+
+    __disable_irq();
+    plan_request.target = Limit(target, PLAN_SPEED_VMAX);
+    plan_request.amax = amax;
+    plan_request.jmax = jmax;
+    plan_request.pending = 1;
+    __enable_irq();
+}
+
+//追加位置指令，同向的相邻指令之间不停顿
+//float target                  目标角度 °
+//float vmax amax jmax          速度 °/s、加速度 °/s²、加加速度 °/s³，<=0 时使用默认值
+//返回值                        1：已入队    0：队列满
+uint8_t mg513_PlanPosition(float target, float vmax, float amax, float jmax) {
+    MotionCommand cmd = {target, vmax, amax, jmax};
+
+    if (cmd.vmax <= 0)
+        cmd.vmax = PLAN_POSITION_VMAX;
+    if (cmd.amax <= 0)
+        cmd.amax = PLAN_POSITION_AMAX;
+    if (cmd.jmax <= 0)
+        cmd.jmax = cmd.amax * PLAN_JERK_RATIO;
+    return motion_Push(&queue_l, &cmd);
+}
+
+//清空位置指令队列，当前这段轨迹走完后减速停止（按衔接速度规划的一段不会以末速度继续运动）
+void mg513_ClearPosition(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    motion_Clear(&queue_l);
+    __set_PRIMASK(primask);
+}
+
+//读取位置指令队列（占用、欠载标志）
+const MotionQueue* mg513_GetMotionQueue(void) {
+    return &queue_l;
+}
+
+//应答：上位机据此控制发送节奏
+static void mg513_Ack(uint8_t accepted) {
+    float ch[] = {motion_Count(&queue_l), queue_l.underrun, accepted};
+    telemetry_Send(TELEMETRY_CMD_ACK, ch, 3);
+}
+
+//上位机指令（串口中断内调用）
+void telemetry_Command(uint8_t cmd, const float* arg, uint8_t count) {
+    uint8_t accepted = 0;
+
+    switch (cmd) {
+        case TELEMETRY_CMD_MOVE:
+            if (count >= 1)
+                accepted = mg513_PlanPosition(arg[0], count >= 2 ? arg[1] : 0, count >= 3 ? arg[2] : 0, 0);
+            break;
+        case TELEMETRY_CMD_CLEAR:
+            mg513_ClearPosition();
+            accepted = 1;
+            break;
+        case TELEMETRY_CMD_BENCH:
+            //耗时约数百ms，不能在中断内运行：只置请求，由主循环运行并发出结果帧和应答
+            bench_request = 1;
+            return;
+        default:
+            break;
+    }
+    mg513_Ack(accepted);
+}
+
+//主循环内调用：运行上位机请求的耗时任务
+//基准测试电机停止时才运行，结果帧先于应答发出
+void mg513_Service(void) {
+    static BenchResult bench[BENCH_MAX_CASES];
+
+    if (!bench_request)
+        return;
+    bench_request = 0;
+    uint8_t n = bench_Run(bench, BENCH_MAX_CASES, BENCH_TARGET_ITERATIONS);
+    bench_Report(bench, n);
+    mg513_Ack(n > 0);
+}
+
 //中断
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+    //编码器计数器溢出
+    if (htim == &htim2) {
+        encoderOverflow(&ecd_l);
+        return;
+    }
+    if (htim == &htim3) {
+        encoderOverflow(&ecd_r);
+        return;
+    }
+
     if (htim == &htim4) {
-        //速度环控制--增量式pid     (左电机)
-        if (Mode == Speed_Control) {
-            updateEncoderLoop(&ecd_l, 10);
-            float filtered_velocity = movingAverageFilter(ecd_l.velocity.angular);      //低通滤波
-            updatePID_Speed(&vec_l, filtered_velocity);
-            mg513_PWM(LEFT, vec_l.output);
-            printf("%.2f,%.2f\n", ecd_l.velocity.angular, vec_l.target);
-        }
-        //位置环控制--串级pid(外级位置环，内级速度环）     (左电机)
-        else if (Mode == Position_Control) {
-            updateEncoderLoop(&ecd_l, 10);
-            updatePID_Position(&ang_l, ecd_l.position.angle);
-            ang_l.output = Limit(ang_l.output,200);
-            setPIDTarget(&vec_l, ang_l.output);
-            float filtered_velocity = movingAverageFilter(ecd_l.velocity.angular);      //滑动平均滤波
-            updatePID_Speed(&vec_l, ecd_l.velocity.angular);
-            mg513_PWM(LEFT, vec_l.output);
-            printf("%.2f,%.2f,%.2f\n", ecd_l.position.angle, ang_l.target, ecd_l.velocity.angular);
-        }
-        //速度跟随
-        else if (Mode == Speed_Follow) {
-            updateEncoderLoop(&ecd_l, 10);
-            float filtered_velocity = lowPassFilter(ecd_l.velocity.angular);      //低通滤波
-            updatePID_Speed(&vec_l, filtered_velocity);
-            mg513_PWM(LEFT, vec_l.output);
-            printf("%.2f,%.2f\n", ecd_l.velocity.angular, vec_l.target);
-        }
-        //位置跟随控制        （左电机为主电机）
-        else if (Mode == Position_Follow_L) {
-            HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_3);
-            updateEncoderLoop(&ecd_l, 10);
-            float position_l = ecd_l.position.angle;
-            setPIDTarget(&ang_r, position_l);
-            updateEncoderLoop(&ecd_r, 10);
-            updatePID_Position(&ang_r, ecd_r.position.angle);
-            mg513_PWM(RIGHT, ang_r.output);
-            printf("%.2f,%.2f\n", ecd_r.position.angle, ecd_l.position.angle);
-        }
-        //位置跟随控制        （右电机为主电机）
-        else if (Mode == Position_Follow_R) {
-            HAL_TIM_PWM_Stop(&htim1, TIM_CHANNEL_4);
-            updateEncoderLoop(&ecd_r, 10);
-            float position_r = ecd_r.position.angle;
-            setPIDTarget(&ang_l, position_r);
-            updateEncoderLoop(&ecd_l, 10);
-            updatePID_Position(&ang_l, ecd_l.position.angle);
-            mg513_PWM(LEFT, ang_l.output);
-            printf("%.2f,%.2f\n", ecd_r.position.angle, ecd_l.position.angle);
-        }
-        //速度曲线规划
-        else if (Mode == Speed_CurveControl) {
-            updateEncoderLoop(&ecd_l, 10);
-            VelocityCurve(&vec_l.curve);
-            setPIDTarget(&vec_l, vec_l.curve.current);
-            float filtered_velocity = lowPassFilter(ecd_l.velocity.angular);      //滑动平均滤波
-            updatePID_Speed(&vec_l, filtered_velocity);
-            mg513_PWM(LEFT, vec_l.output);
-            printf("%.2f,%.2f\n", vec_l.target, ecd_l.velocity.angular);
+        profiler_Begin();
+
+        //模式切换、在线整定参数只在周期边界进行
+        if (mode_request)
+            mg513_ApplyMode(pending_mode);
+        if (tune_pending)
+            tuneTake();
+
+        const ModeDesc* desc = &mode_table[Mode];
+        desc->inner();
+        if (++schedule.count >= schedule.outer_div) {
+            schedule.count = 0;
+            desc->outer();
         }
-            //位置曲线控制
-        else if(Mode == Position_CurveControl){
-            updateEncoderLoop(&ecd_l,10);
-            PositionCurve(&ang_l.curve);
-            setPIDTarget(&ang_l,ang_l.curve.current);
-            updatePID_Position(&ang_l,ecd_l.position.angle);
-            mg513_PWM(LEFT,ang_l.output);
-            printf("%.2f,%.2f,%.2f\n",ang_l.target,ecd_l.position.angle,ecd_l.velocity.angular);
+
+        profiler_End(Mode);
+        if (++report_count >= PROFILER_REPORT_TICKS) {
+            report_count = 0;
+            profiler_Report(Mode);
         }
     }
 }
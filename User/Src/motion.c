@@ -0,0 +1,121 @@
+#include "motion.h"
+#include "main.h"
+#include "math.h"
+
+#define MOTION_MASK (MOTION_QUEUE_SIZE - 1)
+#define MOTION_BLEND_MARGIN 0.9f        //衔接速度留余量，避免临界情况下规划失败
+#define MOTION_BLEND_RETRY  4           //衔接速度不可达时减半重试次数
+#define MOTION_STOP_V       1e-3f       //队列取空后低于此速度直接视为停止
+
+//清空队列
+void motion_Clear(MotionQueue* queue) {
+    queue->tail = queue->head;
+    queue->underrun = 0;
+    queue->active = 0;
+}
+
+//追加指令
+//菜单（主循环）和串口中断都可能写入，关中断保护写指针（可在中断内调用）
+uint8_t motion_Push(MotionQueue* queue, const MotionCommand* cmd) {
+    uint8_t ok = 0;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if ((uint8_t) (queue->head - queue->tail) < MOTION_QUEUE_SIZE) {
+        queue->cmd[queue->head & MOTION_MASK] = *cmd;
+        queue->head++;
+        queue->underrun = 0;
+        ok = 1;
+    }
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+//队列占用
+uint8_t motion_Count(const MotionQueue* queue) {
+    return (uint8_t) (queue->head - queue->tail);
+}
+
+//从速度v减速到0所需的距离不超过h时，v的最大值
+static float motion_StopVelocity(float h, float amax, float jmax) {
+    float v;
+
+    if (jmax <= 0)
+        return sqrtf(2 * amax * h);
+
+    //达不到amax：h = v * sqrt(v / jmax)
+    v = cbrtf(h * h * jmax);
+    if (v * jmax <= amax * amax)
+        return v;
+
+    //达到amax：h = v / 2 * (v / amax + amax / jmax)
+    return 0.5f * amax * (sqrtf(amax * amax / (jmax * jmax) + 8 * h / amax) - amax / jmax);
+}
+
+//前瞻：当前指令结束时的衔接速度
+//两段同向时不停顿，速度取两段限速、本段能加到的速度及下一段能停住的速度中的最小值；反向时停下
+static float motion_BlendVelocity(const MotionPlan* plan, const MotionCommand* cmd, const MotionCommand* next) {
+    float h1 = cmd->target - plan->p;
+    float h2 = next->target - cmd->target;
+    float v;
+
+    if (h1 * h2 <= 0)
+        return 0;
+
+    v = fminf(cmd->vmax, next->vmax);
+    v = fminf(v, fabsf(plan->v) + motion_StopVelocity(fabsf(h1), cmd->amax, cmd->jmax));
+    v = fminf(v, motion_StopVelocity(fabsf(h2), next->amax, next->jmax));
+    v *= MOTION_BLEND_MARGIN;
+    return h1 > 0 ? v : -v;
+}
+
+//规划队首指令，成功后出队
+static void motion_Next(MotionQueue* queue, MotionPlan* plan) {
+    const MotionCommand* cmd = &queue->cmd[queue->tail & MOTION_MASK];
+    float v1 = 0;
+    uint8_t ok, i;
+
+    if (motion_Count(queue) >= 2)
+        v1 = motion_BlendVelocity(plan, cmd, &queue->cmd[(queue->tail + 1) & MOTION_MASK]);
+
+    //衔接速度不可达时逐次减半，最后退回到停在目标点
+    ok = planner_Position(plan, cmd->target, v1, cmd->vmax, cmd->amax, cmd->jmax);
+    for (i = 0; !ok && v1 != 0 && i < MOTION_BLEND_RETRY; i++) {
+        v1 *= 0.5f;
+        ok = planner_Position(plan, cmd->target, v1, cmd->vmax, cmd->amax, cmd->jmax);
+    }
+    if (!ok)
+        ok = planner_Position(plan, cmd->target, 0, cmd->vmax, cmd->amax, cmd->jmax);
+    if (!ok) {
+        //剩余距离不够减速：先停下，停稳后重新规划
+        planner_Velocity(plan, 0, cmd->amax, cmd->jmax);
+        return;
+    }
+
+    queue->active = 1;
+    queue->amax = cmd->amax;
+    queue->jmax = cmd->jmax;
+    queue->tail++;
+}
+
+//执行队列
+//当前轨迹结束后立即规划下一条指令，衔接速度保证段间不停顿
+//队列取空时若末速度不为0（按衔接速度规划的一段走完后下一条指令被清空），按最近一条指令的加速度减速停下
+void motion_Run(MotionQueue* queue, MotionPlan* plan, float dt) {
+    if (plan->done) {
+        if (queue->head != queue->tail) {
+            motion_Next(queue, plan);
+        } else {
+            if (queue->active) {
+                //队列取空
+                queue->active = 0;
+                queue->underrun = 1;
+            }
+            if (fabsf(plan->v) > MOTION_STOP_V)
+                planner_Velocity(plan, 0, queue->amax, queue->jmax);
+            if (plan->done && plan->v != 0)
+                planner_Reset(plan, plan->p, 0);
+        }
+    }
+    planner_Step(plan, dt);
+}
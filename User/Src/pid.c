@@ -42,10 +42,12 @@ void initPID(PID* pid, const float MAX_OUTPUT, const float MAX_E_I){
     pid->target = 0;
     pid->input = 0;
     pid->output = 0;
+    pid->output_last = 0;
 
     // error
     pid->error.now = 0;
     pid->error.last = 0;
+    pid->error.pre = 0;
     pid->error.integral = 0;
 
     //curve
@@ -54,6 +56,31 @@ void initPID(PID* pid, const float MAX_OUTPUT, const float MAX_E_I){
     //limit
     pid->MAX_OUTPUT = MAX_OUTPUT;
     pid->MAX_ERROR_INTEGRAL = MAX_E_I;
+
+    //fixed
+    pid->fixed = 0;
+    initPIDQ(&pid->q, MAX_OUTPUT, MAX_E_I);
+}
+
+//清空pid运行状态（误差、积分、上次输出），参数、目标值和限幅不变
+//PID* pid                      需要操作的PID地址
+void resetPID(PID* pid) {
+    pid->input = 0;
+    pid->output = 0;
+    pid->output_last = 0;
+
+    pid->error.now = 0;
+    pid->error.last = 0;
+    pid->error.pre = 0;
+    pid->error.integral = 0;
+
+    pid->q.input = 0;
+    pid->q.output = 0;
+    pid->q.output_last = 0;
+    pid->q.error.now = 0;
+    pid->q.error.last = 0;
+    pid->q.error.pre = 0;
+    pid->q.error.integral = 0;
 }
 
 //设置pid参数
@@ -65,6 +92,7 @@ void setPIDParam(PID* pid, float kp, float ki, float kd){
     pid->kp = kp;
     pid->ki = ki;
     pid->kd = kd;
+    setPIDQParam(&pid->q, kp, ki, kd);
 }
 
 //设置pid目标值
@@ -74,16 +102,61 @@ void setPIDTarget(PID* pid, float target){
     pid->target = target;
 }
 
+#if PID_CURVE
+//------归一化S曲线查表------//
+//s(x) = 1 / (1 + exp(-x))，x在[-CURVE_TABLE_RANGE, CURVE_TABLE_RANGE]上等距采样，线性插值
+//所有曲线共用一张表，每个控制周期只做一次查表和乘加，不再调用expf
+static float sigmoid_table[CURVE_TABLE_SIZE + 1];
+static uint8_t sigmoid_ready = 0;
+
+//生成S曲线表（只在第一次设置曲线时执行）
+void initCurveTable(void) {
+    for (uint16_t i = 0; i <= CURVE_TABLE_SIZE; i++) {
+        float x = -CURVE_TABLE_RANGE + (2.0f * CURVE_TABLE_RANGE) * (float) i / (float) CURVE_TABLE_SIZE;
+        sigmoid_table[i] = 1.0f / (1.0f + expf(-x));
+    }
+    sigmoid_ready = 1;
+}
+
+//查表计算s(x)，超出范围时取端点值
+float sigmoidLookup(float x) {
+    float pos;
+    uint16_t i;
+
+    if (x <= -CURVE_TABLE_RANGE)
+        return sigmoid_table[0];
+    if (x >= CURVE_TABLE_RANGE)
+        return sigmoid_table[CURVE_TABLE_SIZE];
+
+    pos = (x + CURVE_TABLE_RANGE) * ((float) CURVE_TABLE_SIZE / (2.0f * CURVE_TABLE_RANGE));
+    i = (uint16_t) pos;
+    if (i >= CURVE_TABLE_SIZE)
+        return sigmoid_table[CURVE_TABLE_SIZE];
+    return sigmoid_table[i] + (pos - (float) i) * (sigmoid_table[i + 1] - sigmoid_table[i]);
+}
+
 //设置曲线参数
 void setCurve(Curve* curve, float start, float target, float acceleration, float Max) {
+    if (!sigmoid_ready)
+        initCurveTable();
     curve->target = target;             //目标状态
     curve->start = start;               //初始状态
     curve->acceleration = acceleration; //速度控制时表示加速度，位置控制时值设置为0
     curve->Max = Max;                   //速度控制时表示最大速度，位置控制时表示目标速度
 }
+#endif
 
 //速度环-增量式
 void updatePID_Speed(PID* pid, float input){
+    if (pid->fixed) {
+        //定点实现，仅在边界处转换
+        pid->q.target = q16_FromFloat(pid->target);
+        updatePIDQ_Speed(&pid->q, q16_FromFloat(input));
+        pid->input = input;
+        pid->output = q16_ToFloat(pid->q.output);
+        return;
+    }
+
     pid->input = input;
     pid->error.now = pid->target - pid->input;
 
@@ -100,6 +173,16 @@ void updatePID_Speed(PID* pid, float input){
 
 //位置环-位置式
 void updatePID_Position(PID* pid, float input){
+    if (pid->fixed) {
+        //定点实现，仅在边界处转换
+        //角度超过Q16.16范围（约91圈）后仍可用：误差先按浮点求出，以target = 误差、input = 0送入定点pid
+        pid->q.target = q16_FromFloat(pid->target - input);
+        updatePIDQ_Position(&pid->q, 0);
+        pid->input = input;
+        pid->output = q16_ToFloat(pid->q.output);
+        return;
+    }
+
     pid->input = input;
     pid->error.now = pid->target - pid->input;
     pid->error.integral += pid->error.now;
@@ -113,6 +196,7 @@ void updatePID_Position(PID* pid, float input){
     pid->error.last = pid->error.now;
 }
 
+#if PID_CURVE
 //速度曲线
 void VelocityCurve(Curve* curve) {
     //限幅
@@ -135,14 +219,14 @@ void VelocityCurve(Curve* curve) {
         //初始化曲线
         curve->A = curve->target - curve->start;
         curve->C = curve->start;
-        if (fabsf(curve->A) > 0.01)                                                     //原点处函数值设为0.01，近似为0
-            curve->B = 2.0 / curve->maxTimes * log((fabsf(curve->A) - 0.01) / 0.01);   //计算B的值，使函数从近似原点增长
+        if (fabsf(curve->A) > 0.01f)                                                    //原点处函数值设为0.01，近似为0
+            curve->B = 2.0f / curve->maxTimes * logf((fabsf(curve->A) - 0.01f) / 0.01f);  //计算B的值，使函数从近似原点增长
     }
 
     //控制阶段
     if (curve->aTimes < curve->maxTimes) {
         //计算速度曲线
-        curve->current = curve->A / (float)(1 + exp((0.0 - curve->B) * (curve->aTimes - curve->maxTimes / 2.0)))
+        curve->current = curve->A * sigmoidLookup(curve->B * ((float) curve->aTimes - (float) curve->maxTimes * 0.5f))
                          + curve->C;
         //更新时间
         curve->aTimes++;
@@ -164,8 +248,8 @@ void PositionCurve(Curve* curve) {
         curve->A = (float) ((curve->target - curve->start) / 4);
         curve->B = (float)(4 * curve->Max / curve->A);
         curve->D = curve->start;
-        if(curve->A > 0.01) {
-            curve->C = logf((curve->A - 0.01) / 0.01) / curve->B;
+        if(curve->A > 0.01f) {
+            curve->C = logf((curve->A - 0.01f) / 0.01f) / curve->B;
         }
         //计算最大加速时间
         curve->maxTimes = curve->A * 3 / curve->Max + 2 * curve->C;
@@ -177,17 +261,17 @@ void PositionCurve(Curve* curve) {
     if(curve->aTimes < curve->maxTimes){
         //加速阶段
         if(curve->aTimes <= curve->C) {
-            curve->current = curve->A / (1 + expf((0.0 - curve->B) * (curve->aTimes - curve->C))) + curve->D;
+            curve->current = curve->A * sigmoidLookup(curve->B * ((float) curve->aTimes - curve->C)) + curve->D;
         }
             //匀速阶段
         else if(curve->aTimes >= (curve->maxTimes - curve->C)) {
-            curve->current = curve->A / (1 + expf((0.0 - curve->B) * ((curve->aTimes - curve->maxTimes + curve->C))))
-                             + curve->target - curve->A / 2.0;
+            curve->current = curve->A * sigmoidLookup(curve->B * ((float) curve->aTimes - (float) curve->maxTimes + curve->C))
+                             + curve->target - curve->A * 0.5f;
         }
 
             //减速阶段
         else {
-            curve->current = (float)(curve->Max * (curve->aTimes - curve->C) + curve->A / 2.0);
+            curve->current = curve->Max * ((float) curve->aTimes - curve->C) + curve->A * 0.5f;
         }
         curve->aTimes++;
     }
@@ -198,3 +282,179 @@ void PositionCurve(Curve* curve) {
         curve->maxTimes = 0;
     }
 }
+#endif
+
+//选择浮点或定点实现
+//PID* pid                      需要操作的PID地址
+//uint8_t fixed                 1：定点    0：浮点
+//切换时把当前状态拷贝到目标实现，输出不跳变
+void setPIDFixed(PID* pid, uint8_t fixed){
+    if (fixed && !pid->fixed) {
+        pid->q.target = q16_FromFloat(pid->target);
+        pid->q.input = q16_FromFloat(pid->input);
+        pid->q.output = q16_FromFloat(pid->output);
+        pid->q.output_last = q16_FromFloat(pid->output_last);
+        pid->q.error.now = q16_FromFloat(pid->error.now);
+        pid->q.error.last = q16_FromFloat(pid->error.last);
+        pid->q.error.pre = q16_FromFloat(pid->error.pre);
+        pid->q.error.integral = q16_FromFloat(pid->error.integral);
+    } else if (!fixed && pid->fixed) {
+        pid->output = q16_ToFloat(pid->q.output);
+        pid->output_last = q16_ToFloat(pid->q.output_last);
+        pid->error.now = q16_ToFloat(pid->q.error.now);
+        pid->error.last = q16_ToFloat(pid->q.error.last);
+        pid->error.pre = q16_ToFloat(pid->q.error.pre);
+        pid->error.integral = q16_ToFloat(pid->q.error.integral);
+    }
+    pid->fixed = fixed;
+}
+
+//------定点pid------//
+
+//饱和到32位
+static inline q16_t q16_Sat(int64_t x) {
+    if (x > Q16_MAX)
+        return Q16_MAX;
+    if (x < Q16_MIN)
+        return Q16_MIN;
+    return (q16_t) x;
+}
+
+//饱和加减
+static inline q16_t q16_Add(q16_t a, q16_t b) {
+    return q16_Sat((int64_t) a + b);
+}
+static inline q16_t q16_Sub(q16_t a, q16_t b) {
+    return q16_Sat((int64_t) a - b);
+}
+
+//饱和乘法  Q16.16 * Q16.16 -> Q16.16，四舍五入
+//直接截断总是向负方向舍入，增量式pid每周期累加，偏差随时间线性增长
+static inline q16_t q16_Mul(q16_t a, q16_t b) {
+    return q16_Sat(((int64_t) a * b + 0x8000) >> 16);
+}
+
+//对称限幅
+static inline q16_t q16_Limit(q16_t x, q16_t max_abs) {
+    if (x > max_abs)
+        return max_abs;
+    if (x < -max_abs)
+        return -max_abs;
+    return x;
+}
+
+//浮点转定点（饱和，四舍五入）
+//截断时ki等小参数的相对误差可达1e-4量级（0.08 -> 0.079987），积分项随之产生稳定偏差
+q16_t q16_FromFloat(float x) {
+    if (x >= 32767.99998f)
+        return Q16_MAX;
+    if (x <= -32768.0f)
+        return Q16_MIN;
+    return (q16_t) (x * 65536.0f + (x >= 0 ? 0.5f : -0.5f));
+}
+
+//定点转浮点
+float q16_ToFloat(q16_t x) {
+    return (float) x * (1.0f / 65536.0f);
+}
+
+//初始化定点pid
+void initPIDQ(PIDQ* pid, const float MAX_OUTPUT, const float MAX_E_I){
+    pid->kp = 0;
+    pid->ki = 0;
+    pid->kd = 0;
+
+    pid->target = 0;
+    pid->input = 0;
+    pid->output = 0;
+    pid->output_last = 0;
+
+    pid->error.now = 0;
+    pid->error.last = 0;
+    pid->error.pre = 0;
+    pid->error.integral = 0;
+
+    pid->MAX_OUTPUT = q16_FromFloat(MAX_OUTPUT);
+    pid->MAX_ERROR_INTEGRAL = q16_FromFloat(MAX_E_I);
+}
+
+//设置定点pid参数（初始化时转换一次）
+void setPIDQParam(PIDQ* pid, float kp, float ki, float kd){
+    pid->kp = q16_FromFloat(kp);
+    pid->ki = q16_FromFloat(ki);
+    pid->kd = q16_FromFloat(kd);
+}
+
+//设置定点pid目标值
+void setPIDQTarget(PIDQ* pid, q16_t target){
+    pid->target = target;
+}
+
+//定点速度环-增量式
+void updatePIDQ_Speed(PIDQ* pid, q16_t input){
+    q16_t delta, d2;
+
+    pid->input = input;
+    pid->error.now = q16_Sub(pid->target, input);
+
+    delta = q16_Sub(pid->error.now, pid->error.last);
+    d2 = q16_Add(q16_Sub(delta, pid->error.last), pid->error.pre);
+
+    pid->output = q16_Add(pid->output_last, q16_Mul(pid->kp, delta));
+    pid->output = q16_Add(pid->output, q16_Mul(pid->ki, pid->error.now));
+    pid->output = q16_Add(pid->output, q16_Mul(pid->kd, d2));
+    pid->output = q16_Limit(pid->output, pid->MAX_OUTPUT);
+
+    pid->error.pre = pid->error.last;
+    pid->error.last = pid->error.now;
+    pid->output_last = pid->output;
+}
+
+//定点位置环-位置式
+void updatePIDQ_Position(PIDQ* pid, q16_t input){
+    pid->input = input;
+    pid->error.now = q16_Sub(pid->target, input);
+    pid->error.integral = q16_Add(pid->error.integral, pid->error.now);
+    pid->error.integral = q16_Limit(pid->error.integral, pid->MAX_ERROR_INTEGRAL);
+
+    pid->output = q16_Mul(pid->kp, pid->error.now);
+    pid->output = q16_Add(pid->output, q16_Mul(pid->ki, pid->error.integral));
+    pid->output = q16_Add(pid->output, q16_Mul(pid->kd, q16_Sub(pid->error.now, pid->error.last)));
+    pid->output = q16_Limit(pid->output, pid->MAX_OUTPUT);
+
+    pid->error.last = pid->error.now;
+}
+
+//------在线修改参数------//
+//设置限幅，已有的积分和输出一并限幅
+//PID* pid                      需要操作的PID地址
+//float MAX_OUTPUT              最大输出值
+//float MAX_E_I                 最大误差积分值
+void setPIDLimit(PID* pid, float MAX_OUTPUT, float MAX_E_I) {
+    pid->MAX_OUTPUT = MAX_OUTPUT;
+    pid->MAX_ERROR_INTEGRAL = MAX_E_I;
+    pid->error.integral = limitOutput(pid->error.integral, MAX_E_I);
+    pid->output_last = limitOutput(pid->output_last, MAX_OUTPUT);
+
+    pid->q.MAX_OUTPUT = q16_FromFloat(MAX_OUTPUT);
+    pid->q.MAX_ERROR_INTEGRAL = q16_FromFloat(MAX_E_I);
+    pid->q.error.integral = q16_Limit(pid->q.error.integral, pid->q.MAX_ERROR_INTEGRAL);
+    pid->q.output_last = q16_Limit(pid->q.output_last, pid->q.MAX_OUTPUT);
+}
+
+//无扰切换pid参数（控制周期之间调用）
+//位置式：调整误差积分，使 kp * e + ki * integral 在新旧参数下相等，下一周期输出不因参数跳变；新ki为0时无法吸收
+//增量式：输出以output_last为基准累加，参数变化本身不引起跳变
+void setPIDParamBumpless(PID* pid, float kp, float ki, float kd) {
+    if (ki != 0) {
+        float e = pid->error.last;
+        float integral = (pid->kp * e + pid->ki * pid->error.integral - kp * e) / ki;
+        pid->error.integral = limitOutput(integral, pid->MAX_ERROR_INTEGRAL);
+
+        e = q16_ToFloat(pid->q.error.last);
+        integral = (q16_ToFloat(pid->q.kp) * e + q16_ToFloat(pid->q.ki) * q16_ToFloat(pid->q.error.integral)
+                    - kp * e) / ki;
+        pid->q.error.integral = q16_Limit(q16_FromFloat(integral), pid->q.MAX_ERROR_INTEGRAL);
+    }
+    setPIDParam(pid, kp, ki, kd);
+}
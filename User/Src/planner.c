@@ -0,0 +1,280 @@
+#include "planner.h"
+#include "math.h"
+
+//时间最优运动规划
+//jmax <= 0 时生成梯形（加速度受限）轨迹，否则生成7段S型（加加速度受限）轨迹
+//起点为规划器当前的位置和速度，起点加速度按0处理
+//参考：Biagiotti, Melchiorri《Trajectory Planning for Automatic Machines and Robots》3.2 / 3.4节
+
+#define PLAN_GAMMA          0.9f        //S曲线达不到最大加速度时每次缩小的比例
+#define PLAN_MAX_ITERATION  40
+
+//追加一段，起点状态由上一段末端推出
+static void planner_Push(MotionPlan* plan, float T, float j, float a0) {
+    PlanSegment* seg;
+    float p0, v0;
+
+    if (T <= 0 || plan->count >= PLAN_MAX_SEGMENTS)
+        return;
+
+    if (plan->count == 0) {
+        p0 = plan->p;
+        v0 = plan->v;
+    } else {
+        const PlanSegment* last = &plan->seg[plan->count - 1];
+        float t = last->T;
+        p0 = last->p0 + t * (last->v0 + t * (last->a0 * 0.5f + t * last->j * (1.0f / 6.0f)));
+        v0 = last->v0 + t * (last->a0 + t * last->j * 0.5f);
+    }
+
+    seg = &plan->seg[plan->count++];
+    seg->T = T;
+    seg->j = j;
+    seg->p0 = p0;
+    seg->v0 = v0;
+    seg->a0 = a0;
+}
+
+//从当前状态开始一次新的规划
+static void planner_Begin(MotionPlan* plan) {
+    plan->count = 0;
+    plan->index = 0;
+    plan->t = 0;
+    plan->a = 0;
+    plan->done = 0;
+}
+
+//停在指定状态
+void planner_Reset(MotionPlan* plan, float p, float v) {
+    plan->p = p;
+    plan->v = v;
+    planner_Begin(plan);
+    plan->done = 1;
+}
+
+//速度规划：从当前速度变化到v1，之后保持v1
+//float v1                      目标速度
+//float amax                    最大加速度（>0）
+//float jmax                    最大加加速度，<=0 表示不限制（梯形）
+//返回值                        1：成功    0：参数无效
+uint8_t planner_Velocity(MotionPlan* plan, float v1, float amax, float jmax) {
+    float dv = v1 - plan->v;
+    float sign = dv >= 0 ? 1.0f : -1.0f;
+    float Tj, Ta;
+
+    if (amax <= 0)
+        return 0;
+
+    planner_Begin(plan);
+    dv = fabsf(dv);
+
+    if (jmax <= 0) {
+        //梯形：恒加速度
+        planner_Push(plan, dv / amax, 0, sign * amax);
+    } else if (dv * jmax >= amax * amax) {
+        //能达到最大加速度：加加速-匀加速-减加速
+        Tj = amax / jmax;
+        Ta = Tj + dv / amax;
+        planner_Push(plan, Tj, sign * jmax, 0);
+        planner_Push(plan, Ta - 2 * Tj, 0, sign * amax);
+        planner_Push(plan, Tj, -sign * jmax, sign * amax);
+    } else {
+        //达不到最大加速度：加加速-减加速
+        Tj = sqrtf(dv / jmax);
+        planner_Push(plan, Tj, sign * jmax, 0);
+        planner_Push(plan, Tj, -sign * jmax, sign * jmax * Tj);
+    }
+
+    plan->done = (plan->count == 0);
+    return 1;
+}
+
+//梯形位置规划（已变换为正方向，h > 0）
+static uint8_t planner_Trapezoid(MotionPlan* plan, float sign, float h, float v0, float v1,
+                                 float vmax, float amax) {
+    float vlim, Ta, Td, Tv;
+
+    //无法在h内从v0加速或减速到v1
+    if (amax * h < fabsf(v0 * v0 - v1 * v1) * 0.5f)
+        return 0;
+
+    if (amax * h > vmax * vmax - (v0 * v0 + v1 * v1) * 0.5f) {
+        //能达到最大速度
+        Ta = (vmax - v0) / amax;
+        Td = (vmax - v1) / amax;
+        Tv = (h - (vmax * vmax - v0 * v0) / (2 * amax) - (vmax * vmax - v1 * v1) / (2 * amax)) / vmax;
+    } else {
+        //达不到最大速度
+        vlim = sqrtf(amax * h + (v0 * v0 + v1 * v1) * 0.5f);
+        Ta = (vlim - v0) / amax;
+        Td = (vlim - v1) / amax;
+        Tv = 0;
+    }
+
+    planner_Push(plan, Ta, 0, sign * amax);
+    planner_Push(plan, Tv, 0, 0);
+    planner_Push(plan, Td, 0, -sign * amax);
+    return 1;
+}
+
+//S型位置规划（已变换为正方向，h > 0）
+static uint8_t planner_SCurve(MotionPlan* plan, float sign, float h, float v0, float v1,
+                              float vmax, float amax, float jmax) {
+    float Tj, Tj1, Tj2, Ta, Td, Tv, delta, alim_a, alim_d;
+    uint8_t i;
+
+    //可行性：能否在h内完成速度变化
+    Tj = fminf(sqrtf(fabsf(v1 - v0) / jmax), amax / jmax);
+    if (Tj < amax / jmax) {
+        if (h < Tj * (v0 + v1))
+            return 0;
+    } else {
+        if (h < 0.5f * (v0 + v1) * (Tj + fabsf(v1 - v0) / amax))
+            return 0;
+    }
+
+    //情况1：假设能达到最大速度
+    if ((vmax - v0) * jmax < amax * amax) {
+        Tj1 = sqrtf((vmax - v0) / jmax);
+        Ta = 2 * Tj1;
+    } else {
+        Tj1 = amax / jmax;
+        Ta = Tj1 + (vmax - v0) / amax;
+    }
+    if ((vmax - v1) * jmax < amax * amax) {
+        Tj2 = sqrtf((vmax - v1) / jmax);
+        Td = 2 * Tj2;
+    } else {
+        Tj2 = amax / jmax;
+        Td = Tj2 + (vmax - v1) / amax;
+    }
+    Tv = h / vmax - Ta * 0.5f * (1 + v0 / vmax) - Td * 0.5f * (1 + v1 / vmax);
+
+    //情况2：达不到最大速度，必要时逐步缩小最大加速度
+    if (Tv <= 0) {
+        Tv = 0;
+        for (i = 0; i < PLAN_MAX_ITERATION; i++) {
+            Tj = amax / jmax;
+            Tj1 = Tj;
+            Tj2 = Tj;
+            delta = amax * amax * amax * amax / (jmax * jmax) + 2 * (v0 * v0 + v1 * v1)
+                    + amax * (4 * h - 2 * amax / jmax * (v0 + v1));
+            Ta = (amax * amax / jmax - 2 * v0 + sqrtf(delta)) / (2 * amax);
+            Td = (amax * amax / jmax - 2 * v1 + sqrtf(delta)) / (2 * amax);
+
+            if (Ta < 0) {
+                //只有减速段
+                Ta = 0;
+                Tj1 = 0;
+                Td = 2 * h / (v0 + v1);
+                Tj2 = (jmax * h - sqrtf(jmax * (jmax * h * h + (v1 + v0) * (v1 + v0) * (v1 - v0))))
+                      / (jmax * (v1 + v0));
+                break;
+            }
+            if (Td < 0) {
+                //只有加速段
+                Td = 0;
+                Tj2 = 0;
+                Ta = 2 * h / (v0 + v1);
+                Tj1 = (jmax * h - sqrtf(jmax * (jmax * h * h - (v1 + v0) * (v1 + v0) * (v1 - v0))))
+                      / (jmax * (v1 + v0));
+                break;
+            }
+            if (Ta >= 2 * Tj && Td >= 2 * Tj)
+                break;
+            amax *= PLAN_GAMMA;
+        }
+        //未收敛时各段时长可能为负，放弃本次规划
+        if (i >= PLAN_MAX_ITERATION)
+            return 0;
+    }
+
+    alim_a = jmax * Tj1;
+    alim_d = -jmax * Tj2;
+
+    planner_Push(plan, Tj1, sign * jmax, 0);
+    planner_Push(plan, Ta - 2 * Tj1, 0, sign * alim_a);
+    planner_Push(plan, Tj1, -sign * jmax, sign * alim_a);
+    planner_Push(plan, Tv, 0, 0);
+    planner_Push(plan, Tj2, -sign * jmax, 0);
+    planner_Push(plan, Td - 2 * Tj2, 0, sign * alim_d);
+    planner_Push(plan, Tj2, sign * jmax, sign * alim_d);
+    return 1;
+}
+
+//位置规划：从当前位置和速度运动到p1，末速度v1
+//float vmax amax jmax          速度、加速度、加加速度上限，jmax <= 0 时为梯形轨迹
+//返回值                        1：成功    0：参数无效或距离不足以把速度降到v1
+uint8_t planner_Position(MotionPlan* plan, float p1, float v1, float vmax, float amax, float jmax) {
+    float h = p1 - plan->p;
+    float sign = h >= 0 ? 1.0f : -1.0f;
+    float v0 = sign * plan->v;
+    uint8_t ok;
+
+    if (vmax <= 0 || amax <= 0)
+        return 0;
+
+    h = fabsf(h);
+    v1 = sign * v1;
+    //当前速度已超过上限时不再加速
+    if (v0 > vmax)
+        vmax = v0;
+
+    planner_Begin(plan);
+    if (h <= 0) {
+        ok = (v0 == 0 && v1 == 0);
+    } else if (jmax <= 0) {
+        ok = planner_Trapezoid(plan, sign, h, v0, v1, vmax, amax);
+    } else {
+        ok = planner_SCurve(plan, sign, h, v0, v1, vmax, amax, jmax);
+    }
+
+    if (!ok)
+        plan->count = 0;
+    plan->done = (plan->count == 0);
+    return ok;
+}
+
+//推进dt秒
+void planner_Step(MotionPlan* plan, float dt) {
+    const PlanSegment* seg;
+    float t;
+
+    if (plan->done) {
+        //保持末速度
+        plan->p += plan->v * dt;
+        plan->a = 0;
+        return;
+    }
+
+    plan->t += dt;
+    while (plan->t >= plan->seg[plan->index].T) {
+        plan->t -= plan->seg[plan->index].T;
+        if (++plan->index >= plan->count) {
+            //最后一段结束，停在其末端状态
+            seg = &plan->seg[plan->count - 1];
+            t = seg->T;
+            plan->v = seg->v0 + t * (seg->a0 + t * seg->j * 0.5f);
+            plan->p = seg->p0 + t * (seg->v0 + t * (seg->a0 * 0.5f + t * seg->j * (1.0f / 6.0f)))
+                      + plan->v * plan->t;
+            plan->a = 0;
+            plan->done = 1;
+            return;
+        }
+    }
+
+    seg = &plan->seg[plan->index];
+    t = plan->t;
+    plan->p = seg->p0 + t * (seg->v0 + t * (seg->a0 * 0.5f + t * seg->j * (1.0f / 6.0f)));
+    plan->v = seg->v0 + t * (seg->a0 + t * seg->j * 0.5f);
+    plan->a = seg->a0 + t * seg->j;
+}
+
+//总时长
+float planner_Duration(const MotionPlan* plan) {
+    float T = 0;
+    for (uint8_t i = 0; i < plan->count; i++) {
+        T += plan->seg[i].T;
+    }
+    return T;
+}
@@ -0,0 +1,149 @@
+#include "profiler.h"
+#include "string.h"
+
+#if defined(__arm__)
+#include "main.h"
+#include "telemetry.h"
+
+//DWT周期计数器
+#define PROFILER_NOW()      (DWT->CYCCNT)
+#define PROFILER_CLOCK_HZ   (SystemCoreClock)
+#else
+//主机桩：以纳秒时钟代替周期计数，同一套接口可在Linux上编译运行
+#include <stdio.h>
+#include <time.h>
+
+static uint32_t profiler_HostNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec);
+}
+#define PROFILER_NOW()      profiler_HostNow()
+#define PROFILER_CLOCK_HZ   1000000000u
+#endif
+
+static ProfilerStats stats[PROFILER_MAX_MODES];
+static uint32_t period;                 //控制周期  周期
+static uint32_t start;                  //本次中断起始
+static uint32_t last_start;             //上次中断起始
+static uint8_t primed;                  //last_start是否有效
+
+//打开周期计数器并清空统计
+void profiler_Init(void) {
+#if defined(__arm__)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    period = 0;
+    primed = 0;
+    profiler_Reset();
+}
+
+//设置控制周期
+//uint32_t cycles               控制周期对应的周期数，用于计算抖动和超时
+void profiler_SetPeriod(uint32_t cycles) {
+    period = cycles;
+    primed = 0;
+}
+
+//丢弃下一次间隔（定时器停止后重新启动时调用）
+void profiler_Resync(void) {
+    primed = 0;
+}
+
+//清空统计
+void profiler_Reset(void) {
+    memset(stats, 0, sizeof(stats));
+    for (uint8_t i = 0; i < PROFILER_MAX_MODES; i++) {
+        stats[i].min = UINT32_MAX;
+    }
+}
+
+//控制中断入口
+void profiler_Begin(void) {
+    start = PROFILER_NOW();
+}
+
+//控制中断出口：累计耗时、起始抖动和超时
+//uint8_t mode                  本次执行的模式
+void profiler_End(uint8_t mode) {
+    uint32_t now = PROFILER_NOW();
+    uint32_t elapsed = now - start;
+    ProfilerStats* s;
+
+    if (mode >= PROFILER_MAX_MODES)
+        return;
+    s = &stats[mode];
+
+    if (elapsed < s->min)
+        s->min = elapsed;
+    if (elapsed > s->max)
+        s->max = elapsed;
+    s->sum += elapsed;
+    s->count++;
+    if (period != 0 && elapsed > period)
+        s->overrun++;
+
+    //起始抖动 = |两次起始间隔 - 控制周期|
+    if (primed && period != 0) {
+        uint32_t interval = start - last_start;
+        uint32_t jitter = interval > period ? interval - period : period - interval;
+        uint32_t bin = jitter >> PROFILER_HIST_SHIFT;
+        if (bin >= PROFILER_HIST_BINS)
+            bin = PROFILER_HIST_BINS - 1;
+        s->hist[bin]++;
+        if (jitter > s->jitter_max)
+            s->jitter_max = jitter;
+        //间隔超过两个周期说明丢了节拍
+        if (interval >= 2 * period)
+            s->overrun++;
+    }
+    last_start = start;
+    primed = 1;
+}
+
+//平均耗时
+uint32_t profiler_Mean(const ProfilerStats* s) {
+    return s->count ? (uint32_t) (s->sum / s->count) : 0;
+}
+
+//周期数换算为us
+uint32_t profiler_CyclesToUs(uint32_t cycles) {
+    return (uint32_t) ((uint64_t) cycles * 1000000u / PROFILER_CLOCK_HZ);
+}
+
+//当前计数
+uint32_t profiler_Now(void) {
+    return PROFILER_NOW();
+}
+
+//计数频率
+uint32_t profiler_ClockHz(void) {
+    return PROFILER_CLOCK_HZ;
+}
+
+//读取统计
+const ProfilerStats* profiler_Get(uint8_t mode) {
+    return mode < PROFILER_MAX_MODES ? &stats[mode] : NULL;
+}
+
+//上报一个模式的统计
+void profiler_Report(uint8_t mode) {
+    const ProfilerStats* s = profiler_Get(mode);
+    if (s == NULL || s->count == 0)
+        return;
+#if defined(__arm__)
+    float timing[] = {(float) s->min, (float) s->max, (float) profiler_Mean(s)};
+    float overrun[] = {(float) s->overrun, (float) s->count, (float) s->jitter_max};
+    telemetry_Send(PROFILER_FRAME_TIMING | mode, timing, 3);
+    telemetry_Send(PROFILER_FRAME_OVERRUN | mode, overrun, 3);
+#else
+    fprintf(stderr, "mode %u: min %u max %u mean %u overrun %u count %u jitter_max %u hist",
+           mode, s->min, s->max, profiler_Mean(s), s->overrun, s->count, s->jitter_max);
+    for (uint8_t i = 0; i < PROFILER_HIST_BINS; i++) {
+        fprintf(stderr, " %u", s->hist[i]);
+    }
+    fprintf(stderr, "\n");
+#endif
+}
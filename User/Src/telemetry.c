@@ -0,0 +1,188 @@
+#include "telemetry.h"
+#include "usart.h"
+#include "string.h"
+
+#define TELEMETRY_MASK (TELEMETRY_BUF_SIZE - 1)
+
+//环形缓冲区：head只由生产者写（控制中断、串口中断、主循环，写入时关中断），tail只由消费者（DMA发送完成中断）写
+static uint8_t tx_buf[TELEMETRY_BUF_SIZE];
+static volatile uint16_t tx_head;       //写入位置（自由计数）
+static volatile uint16_t tx_tail;       //发送位置（自由计数）
+static volatile uint16_t tx_len;        //DMA正在发送的字节数，0表示空闲
+
+static uint16_t seq;                    //帧序号
+static uint32_t dropped;                //丢帧计数
+
+static uint8_t rx_byte;                 //串口接收字节
+static uint8_t rx_frame[sizeof(TelemetryFrame)];   //指令帧接收缓冲
+static uint8_t rx_len;                  //已接收字节数
+
+//CRC16-CCITT 半字节查表
+static const uint16_t crc_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t telemetry_CRC16(const uint8_t* data, uint16_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc = (crc << 4) ^ crc_table[(crc >> 12) ^ (*data >> 4)];
+        crc = (crc << 4) ^ crc_table[(crc >> 12) ^ (*data & 0x0F)];
+        data++;
+    }
+    return crc;
+}
+
+//启动DMA发送缓冲区中连续的一段
+static void telemetry_Kick(void) {
+    uint16_t len, contiguous;
+
+    if (tx_len != 0 || tx_head == tx_tail)
+        return;
+
+    len = (uint16_t) (tx_head - tx_tail);
+    contiguous = TELEMETRY_BUF_SIZE - (tx_tail & TELEMETRY_MASK);
+    if (len > contiguous)
+        len = contiguous;
+
+    tx_len = len;
+    if (HAL_UART_Transmit_DMA(&huart3, &tx_buf[tx_tail & TELEMETRY_MASK], len) != HAL_OK)
+        tx_len = 0;
+}
+
+//初始化遥测
+void telemetry_Init(void) {
+    tx_head = 0;
+    tx_tail = 0;
+    tx_len = 0;
+    seq = 0;
+    dropped = 0;
+    rx_len = 0;
+    HAL_UART_Receive_IT(&huart3, &rx_byte, 1);
+}
+
+//打包一帧写入环形缓冲区，不阻塞
+//中断和主循环都可调用：帧在关中断前打包，占位和拷贝在关中断期间进行
+//uint8_t mode                  当前电机模式
+//const float* ch               通道数据
+//uint8_t count                 通道数，超过TELEMETRY_CHANNELS的部分丢弃
+void telemetry_Send(uint8_t mode, const float* ch, uint8_t count) {
+    TelemetryFrame frame;
+    uint16_t head, offset, first;
+    uint32_t primask;
+
+    if (count > TELEMETRY_CHANNELS)
+        count = TELEMETRY_CHANNELS;
+
+    frame.head[0] = TELEMETRY_HEAD0;
+    frame.head[1] = TELEMETRY_HEAD1;
+    frame.mode = mode;
+    frame.count = count;
+    frame.timestamp = HAL_GetTick();
+    memset(frame.ch, 0, sizeof(frame.ch));
+    memcpy(frame.ch, ch, count * sizeof(float));
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    head = tx_head;
+    if ((uint16_t) (TELEMETRY_BUF_SIZE - (uint16_t) (head - tx_tail)) < sizeof(frame)) {
+        //缓冲区满，丢弃本帧；序号照常递增，上位机按序号间隔统计丢帧
+        dropped++;
+        seq++;
+        __set_PRIMASK(primask);
+        return;
+    }
+    frame.seq = seq++;
+    frame.crc = telemetry_CRC16((const uint8_t*) &frame, sizeof(frame) - sizeof(frame.crc));
+
+    //写入缓冲区，末尾回绕时分两段拷贝
+    offset = head & TELEMETRY_MASK;
+    first = TELEMETRY_BUF_SIZE - offset;
+    if (first >= sizeof(frame)) {
+        memcpy(&tx_buf[offset], &frame, sizeof(frame));
+    } else {
+        memcpy(&tx_buf[offset], &frame, first);
+        memcpy(&tx_buf[0], (const uint8_t*) &frame + first, sizeof(frame) - first);
+    }
+    tx_head = head + sizeof(frame);
+
+    telemetry_Kick();
+    __set_PRIMASK(primask);
+}
+
+//丢帧计数
+uint32_t telemetry_Dropped(void) {
+    return dropped;
+}
+
+//DMA发送完成
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart == &huart3) {
+        tx_tail = tx_tail + tx_len;
+        tx_len = 0;
+        telemetry_Kick();
+    }
+}
+
+//上位机指令，由电机模块重新实现
+__weak void telemetry_Command(uint8_t cmd, const float* arg, uint8_t count) {
+    (void) cmd;
+    (void) arg;
+    (void) count;
+}
+
+//逐字节接收指令帧：帧头同步，收满一帧校验CRC
+static void telemetry_Receive(uint8_t byte) {
+    TelemetryFrame frame;
+    float arg[TELEMETRY_CHANNELS];
+
+    if ((rx_len == 0 && byte != TELEMETRY_HEAD0) || (rx_len == 1 && byte != TELEMETRY_HEAD1)) {
+        rx_len = (byte == TELEMETRY_HEAD0);
+        rx_frame[0] = byte;
+        return;
+    }
+    rx_frame[rx_len++] = byte;
+    if (rx_len < sizeof(frame))
+        return;
+    rx_len = 0;
+
+    memcpy(&frame, rx_frame, sizeof(frame));
+    if (frame.crc != telemetry_CRC16(rx_frame, sizeof(frame) - sizeof(frame.crc)))
+        return;
+    if (frame.count > TELEMETRY_CHANNELS)
+        frame.count = TELEMETRY_CHANNELS;
+    memcpy(arg, frame.ch, sizeof(arg));         //packed结构体成员可能不对齐
+    telemetry_Command(frame.mode, arg, frame.count);
+}
+
+//串口接收完成
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart == &huart3) {
+        telemetry_Receive(rx_byte);
+        HAL_UART_Receive_IT(&huart3, &rx_byte, 1);
+    }
+}
+
+//DMA发送出错：丢弃正在发送的一段，首尾被截断的帧一并丢弃并计入丢帧，从下一帧的帧头继续发送
+//head总在帧边界上，由head往回按整帧保留这一段之后的数据
+static void telemetry_DropSegment(void) {
+    uint16_t pending = (uint16_t) (tx_head - tx_tail);
+    uint16_t kept = (uint16_t) (pending - tx_len) / sizeof(TelemetryFrame) * sizeof(TelemetryFrame);
+
+    dropped += (pending - kept + sizeof(TelemetryFrame) - 1) / sizeof(TelemetryFrame);
+    tx_tail = (uint16_t) (tx_head - kept);
+    tx_len = 0;
+}
+
+//串口错误：DMA发送出错时丢弃这一段并重新开始发送，否则tx_len不再清零，遥测停止；
+//接收错误（溢出等）后重新开始接收
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    if (huart == &huart3) {
+        if ((huart->ErrorCode & HAL_UART_ERROR_DMA) && tx_len != 0) {
+            telemetry_DropSegment();
+            telemetry_Kick();
+        }
+        rx_len = 0;
+        HAL_UART_Receive_IT(&huart3, &rx_byte, 1);
+    }
+}